@@ -38,12 +38,28 @@ POSSIBILITY OF SUCH DAMAGE.
 #ifndef PYFFI_OM_HPP_INCLUDED
 #define PYFFI_OM_HPP_INCLUDED
 
+#include "pyffi/object_models/array.hpp"
 #include "pyffi/object_models/attr.hpp"
+#include "pyffi/object_models/attr_handle.hpp"
 #include "pyffi/object_models/attr_map.hpp"
+#include "pyffi/object_models/block_reader.hpp"
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/byte_view.hpp"
 #include "pyffi/object_models/class.hpp"
+#include "pyffi/object_models/embedded_schema.hpp"
+#include "pyffi/object_models/endian.hpp"
+#include "pyffi/object_models/expr.hpp"
+#include "pyffi/object_models/generated.hpp"
 #include "pyffi/object_models/if_elifs_else.hpp"
 #include "pyffi/object_models/instance.hpp"
+#include "pyffi/object_models/instance_reader.hpp"
+#include "pyffi/object_models/instance_writer.hpp"
+#include "pyffi/object_models/layout.hpp"
+#include "pyffi/object_models/mapped_file.hpp"
+#include "pyffi/object_models/plan.hpp"
+#include "pyffi/object_models/prefetch_buffer.hpp"
 #include "pyffi/object_models/scope.hpp"
+#include "pyffi/object_models/symbol.hpp"
 
 namespace pyffi
 {
@@ -0,0 +1,195 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_ARENA_HPP_INCLUDED
+#define PYFFI_OM_ARENA_HPP_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <cstddef>
+#include <new>
+#include <type_traits> // std::is_constructible
+#include <utility> // std::pair, std::forward
+#include <vector>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A monotonic allocator: memory is taken from a few large blocks,
+//! and is only given back when the whole arena is released.
+/*!
+  Typical use is to construct all \ref Instance "instances" of a file
+  in a single arena, so the entire instance tree can be dropped at
+  once, without individual calls to the heap allocator.
+*/
+class Arena : boost::noncopyable
+{
+public:
+    //! Constructor.
+    /*!
+      \param block_size The size of each block. Larger requests get
+                        a block of their own.
+    */
+    explicit Arena(std::size_t block_size = 65536);
+
+    //! Destructor, frees all blocks.
+    ~Arena();
+
+    //! Allocate memory.
+    /*!
+      \param size The number of bytes to allocate.
+      \param alignment The alignment, must be a power of two.
+      \return Pointer to the allocated memory.
+    */
+    void * allocate(std::size_t size, std::size_t alignment);
+
+    //! Release all memory allocated so far. The first block is kept,
+    //! so it can be reused without going back to the heap allocator.
+    void release();
+
+    //! Number of blocks currently in use.
+    std::size_t get_num_blocks() const;
+
+private:
+    //! A block of memory, and its size.
+    typedef std::pair<char *, std::size_t> Block;
+
+    std::size_t block_size;     //!< Size of each block.
+    std::vector<Block> blocks;  //!< All allocated blocks.
+    char *position;             //!< Start of free memory in the current block.
+    char *end;                  //!< End of the current block.
+
+    //! Switch to a block which has at least the given size.
+    void next_block(std::size_t size);
+};
+
+//! An allocator for standard containers which takes its memory from
+//! an \ref Arena "arena", or from the heap if no arena is given.
+/*!
+  Copies of containers never share the arena of the original: they
+  always use the heap, so they remain valid when the arena is released.
+
+  Elements which take an arena pointer as last constructor argument
+  (such as \ref Value "values" and \ref Instance "instances") are
+  given the arena of the allocator, so a container and everything it
+  holds reside in the same arena.
+*/
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    //! Default constructor, allocates from the heap.
+    ArenaAllocator() : arena(0) {};
+    //! Constructor.
+    explicit ArenaAllocator(Arena * arena) : arena(arena) {};
+    //! Conversion constructor.
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U> const & other) : arena(other.get_arena()) {};
+
+    //! Allocate memory for n objects.
+    T * allocate(std::size_t n) {
+        if (arena) {
+            return static_cast<T *>(
+                       arena->allocate(n * sizeof(T), boost::alignment_of<T>::value));
+        } else {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        };
+    };
+
+    //! Deallocate memory; does nothing for memory from an arena.
+    void deallocate(T * p, std::size_t) {
+        if (!arena) {
+            ::operator delete(p);
+        };
+    };
+
+    //! Construct an object, passing the arena if the object accepts it.
+    template <typename U, typename... Args>
+    void construct(U * p, Args &&... args) {
+        construct_impl(
+            p, std::is_constructible<U, Args..., Arena *>(),
+            std::forward<Args>(args)...);
+    };
+
+    //! Containers which are copied get their memory from the heap.
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    };
+
+    //! Get the arena (or null if allocating from the heap).
+    Arena * get_arena() const {
+        return arena;
+    };
+
+    //! Equality operator.
+    template <typename U>
+    bool operator==(ArenaAllocator<U> const & other) const {
+        return arena == other.get_arena();
+    };
+
+    //! Inequality operator.
+    template <typename U>
+    bool operator!=(ArenaAllocator<U> const & other) const {
+        return !(*this == other);
+    };
+
+private:
+    Arena *arena; //!< The arena, or null.
+
+    //! Construct an object which accepts an arena.
+    template <typename U, typename... Args>
+    void construct_impl(U * p, std::true_type, Args &&... args) {
+        ::new(static_cast<void *>(p)) U(std::forward<Args>(args)..., arena);
+    };
+
+    //! Construct an object which does not accept an arena.
+    template <typename U, typename... Args>
+    void construct_impl(U * p, std::false_type, Args &&... args) {
+        ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
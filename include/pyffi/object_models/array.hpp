@@ -0,0 +1,146 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_ARRAY_HPP_INCLUDED
+#define PYFFI_OM_ARRAY_HPP_INCLUDED
+
+#include <cstddef>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+#include "pyffi/object_models/arena.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! The value of an array attribute (see Attr::arr1): a number of
+//! elements of a class, whose length is set when the array is read.
+/*!
+  Elements of a packed class (see Class::is_packed), such as vertices
+  and triangles, are stored one after the other in a single buffer,
+  exactly as in a file apart from the byte order, so the whole array
+  is read and written with a single copy. Elements of other classes
+  are stored as \ref Instance "instances".
+*/
+class Array
+{
+public:
+    //! Constructor, an empty array of the given class, allocating
+    //! from an arena (or from the heap if arena is null).
+    Array(Class const & class_, Arena * arena);
+    //! Copy constructor, the copy resides on the heap.
+    Array(Array const & other);
+    //! Copy constructor, the copy resides in the arena of the given
+    //! allocator.
+    Array(Array const & other, ArenaAllocator<char> const & allocator);
+    //! Move constructor.
+    Array(Array && other) noexcept;
+    //! Assignment operator, keeping this array's arena.
+    Array & operator=(Array const & other);
+
+    //! Get the class of the elements.
+    Class const & get_class() const {
+        return *class_;
+    };
+
+    //! Whether the elements are stored in a single buffer.
+    bool is_packed() const {
+        return packed;
+    };
+
+    //! Number of elements.
+    std::size_t size() const {
+        return length;
+    };
+
+    //! Change the number of elements; new elements are zero for
+    //! packed arrays, and default instances otherwise.
+    void resize(std::size_t size);
+
+    //! Number of bytes of a single element of a packed array.
+    std::size_t get_element_size() const {
+        return element_size;
+    };
+
+    //! Get the bytes of all elements of a packed array.
+    char * data();
+    //! Get the bytes of all elements of a packed array.
+    char const * data() const;
+
+    //! Get the elements of a packed array as a C array of the given
+    //! type, which must have the size of an element, and must be the
+    //! type of the class if it is primitive.
+    template<typename ValueType> ValueType * get() {
+        check_type(typeid(ValueType), sizeof(ValueType));
+        return reinterpret_cast<ValueType *>(data());
+    };
+    //! Get the elements of a packed array as a const C array.
+    template<typename ValueType> ValueType const * get() const {
+        check_type(typeid(ValueType), sizeof(ValueType));
+        return reinterpret_cast<ValueType const *>(data());
+    };
+
+    //! Get an element of an array which is not packed.
+    Instance & at(std::size_t i);
+    //! Get a const element of an array which is not packed.
+    Instance const & at(std::size_t i) const;
+
+private:
+    //! Storage for packed elements, aligned for all primitive types.
+    typedef std::vector<long long, ArenaAllocator<long long> > WordVector;
+
+    Class const *class_;      //!< Class of the elements.
+    bool packed;              //!< Whether the class is packed.
+    std::size_t length;       //!< Number of elements.
+    std::size_t element_size; //!< Bytes per element, if packed.
+    WordVector words;         //!< The elements, if packed.
+    InstanceVector instances; //!< The elements, if not packed.
+
+    //! Check that the elements can be accessed as the given type.
+    void check_type(std::type_info const & type, std::size_t size) const;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -43,6 +43,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <string>
 
 #include "pyffi/object_models/doc.hpp"
+#include "pyffi/object_models/expr.hpp"
+#include "pyffi/object_models/symbol.hpp"
 
 namespace pyffi
 {
@@ -54,32 +56,57 @@ namespace object_models
 class AttrMap;
 class Class;
 
-//! An attribute declaration has a class (its type), and a name.
+//! An attribute declaration has a class (its type), and a name. An
+//! attribute with a length is an array of instances of its class,
+//! see \ref Array.
 class Attr
 {
 public:
     //! Default constructor.
     Attr()
-        : class_name(), name(), class_(), index(), doc() {};
+        : class_name(), name(), arr1(), arr2(), doc(), class_(), symbol(), index(), offset() {};
     //! Constructor.
     Attr(std::string const & class_name, std::string const & name)
-        : class_name(class_name), name(name), class_(), doc() {};
+        : class_name(class_name), name(name), arr1(), arr2(), doc(), class_(), symbol(), index(), offset() {};
 
     std::string class_name; //!< Name of the class of this attribute.
     std::string name;       //!< Name of this attribute.
+    //! Length, if the attribute is an array. It can refer to
+    //! attributes which precede this one.
+    boost::optional<Expr> arr1;
+    //! Second length, if the attribute is a two dimensional array
+    //! (which requires arr1): the array has arr1 times arr2 elements.
+    boost::optional<Expr> arr2;
     boost::optional<Doc> doc; //<! Documentation.
 
     //! Get a reference to the actual class.
     Class const & get_class() const;
 
+    //! Whether the attribute is an array.
+    bool is_array() const {
+        return static_cast<bool>(arr1);
+    };
+
+    //! Get the interned name, once the attribute is in an attribute
+    //! map.
+    Symbol get_symbol() const {
+        return symbol;
+    };
+
     //! Get the index.
     std::size_t get_index() const;
 
+    //! Get the offset in the layout of the class that declares this
+    //! attribute (only for classes that have a fixed size layout).
+    std::size_t get_offset() const;
+
     //! Equality operator.
     bool operator==(Attr const & other) const {
         return
             (class_name == other.class_name) &&
             (name == other.name) &&
+            (arr1 == other.arr1) &&
+            (arr2 == other.arr2) &&
             (doc == other.doc);
     };
 
@@ -90,10 +117,13 @@ public:
 
 private:
     Class const *class_; //!< Pointer to the actual class.
+    Symbol symbol; //!< Interned name.
     boost::optional<std::size_t> index; //!< Index in the attribute map.
+    boost::optional<std::size_t> offset; //!< Offset in the class layout.
 
-    friend class AttrMap; // sets index
+    friend class AttrMap; // sets symbol and index
     friend class declaration_compile_a_bc_visitor; // sets class_
+    friend class declaration_compile_l_o_visitor; // sets offset
 };
 
 } // namespace object_models
@@ -106,6 +136,8 @@ BOOST_FUSION_ADAPT_STRUCT(
     pyffi::object_models::Attr,
     (std::string, class_name)
     (std::string, name)
+    (boost::optional<pyffi::object_models::Expr>, arr1)
+    (boost::optional<pyffi::object_models::Expr>, arr2)
     (boost::optional<pyffi::object_models::Doc>, doc)
 )
 
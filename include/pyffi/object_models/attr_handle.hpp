@@ -0,0 +1,137 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_ATTR_HANDLE_HPP_INCLUDED
+#define PYFFI_OM_ATTR_HANDLE_HPP_INCLUDED
+
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+#include "pyffi/object_models/scope.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A handle to a primitive attribute of a compiled \ref Class "class",
+//! for fast repeated access to that attribute.
+/*!
+  The name is resolved, and the type is checked, only once, when the
+  handle is constructed. Access then takes constant time, without
+  hashing or string construction, in either representation (see
+  Class::set_flat).
+
+  A handle can be used on instances of its class, and on instances
+  of classes derived from it, as these keep the index and offset of
+  all inherited attributes.
+
+  \tparam ValueType The primitive type of the attribute.
+*/
+template<typename ValueType>
+class AttrHandle
+{
+public:
+    //! Resolve an attribute. Throws a runtime error if the class has
+    //! no such attribute, or if its type is not ValueType.
+    /*!
+      \param class_ The class, whose scope must have been compiled.
+      \param name The attribute name.
+    */
+    AttrHandle(Class const & class_, std::string const & name)
+        : index(), offset(), has_offset() {
+        Attr const & attr = class_.get_attr(name);
+        boost::optional<std::type_info const &> type = attr.get_class().get_type();
+        if (!type || type.get() != typeid(ValueType)) {
+            throw std::runtime_error(
+                "Type mismatch on attribute handle (required "
+                + (type ? std::string(type.get().name()) : attr.get_class().name)
+                + " but got " + std::string(typeid(ValueType).name()) + ").");
+        };
+        index = attr.get_index();
+        // all attributes of a class with a layout have an offset
+        if (class_.get_layout()) {
+            has_offset = true;
+            offset = attr.get_offset();
+        };
+    };
+
+    //! Get reference to the value of the attribute of an instance.
+    ValueType & operator()(Instance & instance) const {
+        return *const_cast<ValueType *>(
+                   get(const_cast<Instance const &>(instance).value));
+    };
+
+    //! Get const reference to the value of the attribute of an instance.
+    ValueType const & operator()(Instance const & instance) const {
+        return *get(instance.value);
+    };
+
+private:
+    std::size_t index;  //!< Index of the attribute.
+    std::size_t offset; //!< Offset of the attribute, if has_offset.
+    bool has_offset;    //!< Whether the class has a fixed size layout.
+
+    //! Get pointer to the value of the attribute.
+    ValueType const * get(Value const & value) const {
+        FlatBuffer const *data = value_cast<FlatBuffer>(&value);
+        if (data) {
+            // the buffer may belong to another, smaller, class
+            if (has_offset && offset + sizeof(ValueType) <= data->size()) {
+                return reinterpret_cast<ValueType const *>(data->data() + offset);
+            };
+            throw std::runtime_error("attribute handle does not match instance");
+        };
+        InstanceVector const *instances = value_cast<InstanceVector>(&value);
+        if (instances && index < instances->size()) {
+            ValueType const *result = value_cast<ValueType>(&(*instances)[index].value);
+            if (result) {
+                return result;
+            };
+        };
+        throw std::runtime_error("attribute handle does not match instance");
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
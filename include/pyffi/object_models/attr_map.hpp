@@ -39,10 +39,13 @@ POSSIBILITY OF SUCH DAMAGE.
 #define PYFFI_OM_ATTRMAP_HPP_INCLUDED
 
 #include <boost/multi_index_container.hpp>
-#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
-#include <boost/iterator/iterator_adaptor.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <vector>
 
 // needs full definition of Attr so we can hash the map by name
 #include "pyffi/object_models/attr.hpp"
@@ -55,6 +58,19 @@ namespace object_models
 
 //! An attribute map which remembers insertion order (like Python's
 //! OrderedDict). Use by the Class implementation.
+/*!
+  The map of a derived class shares the attributes of the map of its
+  base class (see set_base), rather than copying them, so a class
+  hierarchy stores every attribute only once.
+
+  Once complete, a map is frozen (see freeze) into a flat array of
+  its own attributes, along with a minimal perfect hash of their
+  names: a lookup is a single probe and a single compare per level of
+  the hierarchy, continuing in the base map on a miss, and no nodes
+  remain. Every map holds pointers only to its own attributes, so a
+  hierarchy takes memory and time to freeze in proportion to the
+  number of its attributes, whatever its depth.
+*/
 class AttrMap
 {
 private:
@@ -62,45 +78,112 @@ private:
     typedef boost::multi_index_container
     <Attr const *,
     boost::multi_index::indexed_by<
-    // hashed by name
+    // hashed by interned name
     boost::multi_index::hashed_unique<
-    boost::multi_index::member<Attr const, std::string const, &Attr::name> >,
+    boost::multi_index::member<Attr, Symbol const, &Attr::symbol> >,
     // ordered by insertion (which is the same as ordered by index)
-    boost::multi_index::sequenced<> > > Map;
+    boost::multi_index::random_access<> > > Map;
+
+    //! The map of the base class, if any.
+    AttrMap const *base;
 
-    //! The map data.
+    //! Number of attributes of the base map when it was set: these
+    //! come first.
+    std::size_t base_size;
+
+    //! The attributes which are not in the base map, until frozen.
     Map map;
 
+    //! Whether the map is frozen.
+    bool frozen;
+
+    //! The attributes which are not in the base map, in order, once
+    //! frozen.
+    std::vector<Attr const *> attrs;
+
+    //! Displacement of the hash of every bucket, once frozen.
+    std::vector<std::uint32_t> displacements;
+
+    //! Position in attrs of every slot of the hash, once frozen.
+    std::vector<std::uint32_t> slots;
+
+    //! Get the attribute at the given position.
+    Attr const & at(std::size_t i) const {
+        if (i < base_size) {
+            return base->at(i);
+        };
+        return frozen ? *attrs[i - base_size] : *map.get<1>()[i - base_size];
+    };
+
+    //! Get the slot of a symbol in a frozen map.
+    std::size_t get_slot(Symbol const & symbol) const;
+
 public:
     //! Constant iterator.
     class const_iterator
-        : public boost::iterator_adaptor<
+        : public boost::iterator_facade<
         const_iterator,
-        Map::nth_index<1>::type::const_iterator, // base_type
-        Attr const // value_type
+        Attr const, // value_type
+        boost::forward_traversal_tag
         >
     {
     public:
-        explicit const_iterator(const_iterator::base_type const & iter)
-            : const_iterator::iterator_adaptor_(iter) {}
+        const_iterator(AttrMap const & map, std::size_t i)
+            : map(&map), i(i) {}
     private:
         friend class boost::iterator_core_access;
         Attr const & dereference() const {
-            return **base();
+            return map->at(i);
+        }
+        void increment() {
+            i++;
+        }
+        bool equal(const_iterator const & other) const {
+            return map == other.map && i == other.i;
         }
+        AttrMap const *map; //!< The map.
+        std::size_t i;      //!< Position in the map.
     };
 
     //! Default constructor.
-    AttrMap() : map() {};
+    AttrMap()
+        : base(), base_size(0), map(), frozen(false),
+          attrs(), displacements(), slots() {};
+
+    //! Share the attributes of the map of a base class: they come
+    //! first, and are looked up in the base map instead of being
+    //! copied, also once frozen, so the base map must outlive this
+    //! one. Only the attributes which the base map has at this point
+    //! are shared. Must be called before push_back.
+    void set_base(AttrMap const & base);
+
+    //! Convert the map into its compact read only form. Called for
+    //! every class by Scope::compile; the maps of base classes may be
+    //! frozen before or after those of their derived classes.
+    void freeze();
+
+    //! Whether the map is frozen, see freeze.
+    bool is_frozen() const {
+        return frozen;
+    };
 
     //! Insert an attribute in the map, and sets the attribute's
-    //! index.  If an attribute with the same name already exists,
-    //! then the map remains unchanged.
+    //! symbol and index.  If an attribute with the same name already
+    //! exists, then the map remains unchanged.
     void push_back(Attr & attr);
 
     //! Get the attribute of the given name.
     Attr const & operator[](std::string const & name) const;
 
+    //! Get the attribute of the given interned name.
+    Attr const & operator[](Symbol const & symbol) const;
+
+    //! Find the attribute of the given name, if there is one.
+    boost::optional<Attr const &> find(std::string const & name) const;
+
+    //! Find the attribute of the given interned name, if there is one.
+    boost::optional<Attr const &> find(Symbol const & symbol) const;
+
     //! Iterator (by insertion order) begin.
     const_iterator begin() const;
 
@@ -0,0 +1,119 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_BLOCK_READER_HPP_INCLUDED
+#define PYFFI_OM_BLOCK_READER_HPP_INCLUDED
+
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <utility> // std::pair
+#include <vector>
+
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/endian.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! The location of a block: an instance of a given class, which is
+//! stored in a known range of bytes, independent of other blocks.
+class BlockSpan
+{
+public:
+    //! Constructor.
+    /*!
+      \param class_ The class of the block.
+      \param offset Start of the block, in bytes.
+      \param size Size of the block, in bytes.
+    */
+    BlockSpan(Class const & class_, std::size_t offset, std::size_t size)
+        : class_(&class_), offset(offset), size(size) {};
+
+    Class const *class_; //!< The class of the block.
+    std::size_t offset;  //!< Start of the block, in bytes.
+    std::size_t size;    //!< Size of the block, in bytes.
+};
+
+//! Reads the header of the next block, and returns the class and the
+//! size of the block which follows it, or none at the end of the
+//! blocks.
+typedef boost::function<boost::optional<std::pair<Class const *, std::size_t> >(ByteReader &)> BlockScanner;
+
+//! Find all blocks, without decoding them, by reading only their
+//! headers and skipping their data.
+/*!
+  \param reader The input buffer; offsets of the blocks are relative
+                to its start.
+  \param scan Reads the header of each block.
+  \return The blocks, in order.
+*/
+std::vector<BlockSpan> scan_blocks(ByteReader & reader, BlockScanner const & scan);
+
+//! Decode blocks concurrently, and gather the instances in order.
+/*!
+  Blocks are handed out to the threads one by one, so threads which
+  decode small blocks take more of them. Each block is decoded from
+  its own range of bytes: a block which needs more or fewer bytes
+  than its size throws. If any block fails, the error of the first such block
+  is thrown, after all threads have stopped.
+
+  All classes of the blocks must have been compiled, and must not be
+  changed while decoding.
+
+  \param data Start of the data, which the offsets are relative to.
+  \param blocks The blocks to decode.
+  \param endian Byte order of the data.
+  \param num_threads Number of threads; 0 to use one per processor.
+  \param globals Global variables for evaluating conditions, such
+                 as the file version; may be null.
+  \return The instances, on the heap, in the order of the blocks.
+*/
+std::vector<Instance> read_blocks(
+    void const * data, std::vector<BlockSpan> const & blocks,
+    Endian endian = Endian::NATIVE, std::size_t num_threads = 0,
+    Globals const * globals = 0);
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -0,0 +1,330 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_BYTE_STREAM_HPP_INCLUDED
+#define PYFFI_OM_BYTE_STREAM_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstring> // std::memcpy
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include "pyffi/object_models/endian.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+class Globals;
+
+//! A cursor for reading from a contiguous block of memory, as a light
+//! replacement for std::istream when all data is already in memory.
+/*!
+  The reader does not own the memory. Reads beyond the end throw a
+  runtime error, and leave the cursor unchanged. Instances are read
+  in the byte order of the reader, NATIVE unless set by set_endian.
+  Their conditions are evaluated with the global variables of the
+  reader, if set by set_globals.
+*/
+class ByteReader
+{
+public:
+    //! Constructor.
+    /*!
+      \param data Start of the memory.
+      \param size Size of the memory, in bytes.
+    */
+    ByteReader(void const * data, std::size_t size)
+        : begin(static_cast<char const *>(data)),
+          position(static_cast<char const *>(data)),
+          end(static_cast<char const *>(data) + size),
+          endian(Endian::NATIVE), globals(0) {};
+
+    //! Check that at least size bytes remain, so several reads can be
+    //! done with a single check.
+    void require(std::size_t size) const {
+        if (size > remaining()) {
+            throw std::runtime_error("read beyond end of buffer");
+        };
+    };
+
+    //! Get a pointer to the next size bytes, and skip them.
+    char const * take(std::size_t size) {
+        require(size);
+        char const *result = position;
+        position += size;
+        return result;
+    };
+
+    //! Copy the next size bytes, and skip them.
+    void read(void * data, std::size_t size) {
+        std::memcpy(data, take(size), size);
+    };
+
+    //! Number of bytes that remain to be read.
+    std::size_t remaining() const {
+        return end - position;
+    };
+
+    //! Number of bytes read so far.
+    std::size_t tell() const {
+        return position - begin;
+    };
+
+    //! Get the byte order of the data.
+    Endian get_endian() const {
+        return endian;
+    };
+
+    //! Set the byte order of the data.
+    void set_endian(Endian endian) {
+        this->endian = endian;
+    };
+
+    //! Get the global variables for evaluating conditions, null
+    //! unless set by set_globals.
+    Globals const * get_globals() const {
+        return globals;
+    };
+
+    //! Set the global variables for evaluating conditions, such as
+    //! the file version. The reader does not own them.
+    void set_globals(Globals const * globals) {
+        this->globals = globals;
+    };
+
+private:
+    char const *begin;      //!< Start of the memory.
+    char const *position;   //!< Current position.
+    char const *end;        //!< End of the memory.
+    Endian endian;          //!< Byte order of the data.
+    Globals const *globals; //!< Global variables, if any.
+};
+
+//! A cursor for writing to a contiguous block of memory, as a light
+//! replacement for std::ostream when the size is known in advance.
+/*!
+  The writer does not own the memory. Writes beyond the end throw a
+  runtime error, and leave the cursor unchanged. Instances are written
+  in the byte order of the writer, NATIVE unless set by set_endian.
+  Their conditions are evaluated with the global variables of the
+  writer, if set by set_globals.
+*/
+class ByteWriter
+{
+public:
+    //! Constructor.
+    /*!
+      \param data Start of the memory.
+      \param size Size of the memory, in bytes.
+    */
+    ByteWriter(void * data, std::size_t size)
+        : begin(static_cast<char *>(data)),
+          position(static_cast<char *>(data)),
+          end(static_cast<char *>(data) + size),
+          endian(Endian::NATIVE), globals(0) {};
+
+    //! Check that at least size bytes remain, so several writes can
+    //! be done with a single check.
+    void require(std::size_t size) const {
+        if (size > remaining()) {
+            throw std::runtime_error("write beyond end of buffer");
+        };
+    };
+
+    //! Get a pointer to the next size bytes, and skip them.
+    char * take(std::size_t size) {
+        require(size);
+        char *result = position;
+        position += size;
+        return result;
+    };
+
+    //! Copy size bytes to the buffer.
+    void write(void const * data, std::size_t size) {
+        std::memcpy(take(size), data, size);
+    };
+
+    //! Number of bytes that remain to be written.
+    std::size_t remaining() const {
+        return end - position;
+    };
+
+    //! Number of bytes written so far.
+    std::size_t tell() const {
+        return position - begin;
+    };
+
+    //! Get the byte order of the data.
+    Endian get_endian() const {
+        return endian;
+    };
+
+    //! Set the byte order of the data.
+    void set_endian(Endian endian) {
+        this->endian = endian;
+    };
+
+    //! Get the global variables for evaluating conditions, null
+    //! unless set by set_globals.
+    Globals const * get_globals() const {
+        return globals;
+    };
+
+    //! Set the global variables for evaluating conditions, such as
+    //! the file version. The reader does not own them.
+    void set_globals(Globals const * globals) {
+        this->globals = globals;
+    };
+
+private:
+    char *begin;            //!< Start of the memory.
+    char *position;         //!< Current position.
+    char *end;              //!< End of the memory.
+    Endian endian;          //!< Byte order of the data.
+    Globals const *globals; //!< Global variables, if any.
+};
+
+//! Read raw bytes from a stream; overloaded so that generic code can
+//! read from either a std::istream or a ByteReader.
+inline void read_raw(std::istream & is, void * data, std::size_t size)
+{
+    is.read(static_cast<char *>(data), size);
+};
+
+//! Read raw bytes from memory.
+inline void read_raw(ByteReader & reader, void * data, std::size_t size)
+{
+    reader.read(data, size);
+};
+
+//! Write raw bytes to a stream; overloaded so that generic code can
+//! write to either a std::ostream or a ByteWriter.
+inline void write_raw(std::ostream & os, void const * data, std::size_t size)
+{
+    os.write(static_cast<char const *>(data), size);
+};
+
+//! Write raw bytes to memory.
+inline void write_raw(ByteWriter & writer, void const * data, std::size_t size)
+{
+    writer.write(data, size);
+};
+
+//! Get the byte order of a reader; overloaded so that generic code
+//! can get the byte order of either a std::ios_base or a ByteReader.
+inline Endian get_endian(ByteReader const & reader)
+{
+    return reader.get_endian();
+};
+
+//! Get the byte order of a writer.
+inline Endian get_endian(ByteWriter const & writer)
+{
+    return writer.get_endian();
+};
+
+//! Get the global variables of a reader; overloaded so that generic
+//! code can get the global variables of either a std::ios_base or a
+//! ByteReader.
+inline Globals const * get_globals(ByteReader const & reader)
+{
+    return reader.get_globals();
+};
+
+//! Get the global variables of a writer.
+inline Globals const * get_globals(ByteWriter const & writer)
+{
+    return writer.get_globals();
+};
+
+//! Read a primitive value from a stream, swapping the bytes of each
+//! word if the stream has a foreign byte order.
+/*!
+  \param reader The input stream or buffer.
+  \param data The value.
+  \param size Size of the value, in bytes.
+  \param word_size Size of each word, in bytes; 1 if the bytes of the
+                   value must never be swapped.
+*/
+template <typename Reader>
+void read_words(Reader & reader, void * data, std::size_t size, std::size_t word_size)
+{
+    read_raw(reader, data, size);
+    if (word_size > 1 && is_swapped(get_endian(reader))) {
+        swap_bytes(data, word_size, size / word_size);
+    };
+};
+
+//! Write a primitive value to a stream, swapping the bytes of each
+//! word if the stream has a foreign byte order.
+/*!
+  \param writer The output stream or buffer.
+  \param data The value.
+  \param size Size of the value, in bytes.
+  \param word_size Size of each word, in bytes; 1 if the bytes of the
+                   value must never be swapped.
+*/
+template <typename Writer>
+void write_words(Writer & writer, void const * data, std::size_t size, std::size_t word_size)
+{
+    if (word_size > 1 && is_swapped(get_endian(writer))) {
+        // swap a copy, and write it in pieces if it is large
+        char buffer[256];
+        char const *bytes = static_cast<char const *>(data);
+        std::size_t const chunk = (sizeof(buffer) / word_size) * word_size;
+        while (size > 0) {
+            std::size_t const n = (size < chunk) ? size : chunk;
+            std::memcpy(buffer, bytes, n);
+            swap_bytes(buffer, word_size, n / word_size);
+            write_raw(writer, buffer, n);
+            bytes += n;
+            size -= n;
+        };
+    } else {
+        write_raw(writer, data, size);
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
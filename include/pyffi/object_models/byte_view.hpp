@@ -0,0 +1,246 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_BYTE_VIEW_HPP_INCLUDED
+#define PYFFI_OM_BYTE_VIEW_HPP_INCLUDED
+
+#include <algorithm> // std::min
+#include <boost/functional/hash.hpp>
+#include <cstddef>
+#include <cstring> // std::memcmp
+#include <ostream>
+#include <string>
+#include <utility> // std::move
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A string of bytes which refers to memory that it does not own,
+//! typically the input buffer or mapping that it was read from, so
+//! reading it costs no allocation or copy. The bytes are copied into
+//! storage of its own only when they are modified.
+/*!
+  A view remains valid only as long as the memory it refers to;
+  call own() to keep the bytes beyond that. Copies of a view refer to
+  the same memory; copies of an owning string own a copy.
+*/
+class ByteView
+{
+public:
+    //! Default constructor, an empty string.
+    ByteView() : begin(0), size_(0), storage() {};
+
+    //! Constructor, refers to the given memory without copying it.
+    ByteView(char const * data, std::size_t size)
+        : begin(data), size_(size), storage() {};
+
+    //! Constructor, owns a copy of the given string.
+    explicit ByteView(std::string const & str)
+        : begin(0), size_(0), storage(str) {
+        sync();
+    };
+
+    //! Copy constructor.
+    ByteView(ByteView const & other)
+        : begin(other.begin), size_(other.size_), storage(other.storage) {
+        if (other.is_owner()) {
+            sync();
+        };
+    };
+
+    //! Move constructor.
+    ByteView(ByteView && other) noexcept
+        : begin(other.begin), size_(other.size_), storage() {
+        if (other.is_owner()) {
+            storage = std::move(other.storage);
+            sync();
+            other.begin = 0;
+            other.size_ = 0;
+        };
+    };
+
+    //! Assignment operator.
+    ByteView & operator=(ByteView const & other) {
+        if (this != &other) {
+            storage = other.storage;
+            begin = other.begin;
+            size_ = other.size_;
+            if (other.is_owner()) {
+                sync();
+            };
+        };
+        return *this;
+    };
+
+    //! Move assignment operator.
+    ByteView & operator=(ByteView && other) noexcept {
+        if (this != &other) {
+            begin = other.begin;
+            size_ = other.size_;
+            if (other.is_owner()) {
+                storage = std::move(other.storage);
+                sync();
+                other.begin = 0;
+                other.size_ = 0;
+            } else {
+                storage.clear();
+            };
+        };
+        return *this;
+    };
+
+    //! Start of the bytes.
+    char const * data() const {
+        return begin;
+    };
+
+    //! Number of bytes.
+    std::size_t size() const {
+        return size_;
+    };
+
+    //! Whether the bytes are owned, rather than referred to.
+    bool is_owner() const {
+        return size_ > 0 && begin == storage.data();
+    };
+
+    //! Copy the bytes into storage of its own, if not done yet.
+    void own() {
+        if (!is_owner() && size_ > 0) {
+            storage.assign(begin, size_);
+            sync();
+        };
+    };
+
+    //! Get the bytes for modification, copying them first if they
+    //! are not owned.
+    char * mutable_data() {
+        own();
+        return size_ > 0 ? &storage[0] : 0;
+    };
+
+    //! Replace the bytes by an owned copy of the given string.
+    void assign(std::string const & str) {
+        storage = str;
+        sync();
+    };
+
+    //! Replace the bytes by the given string, taking over its storage.
+    void assign(std::string && str) {
+        storage = std::move(str);
+        sync();
+    };
+
+    //! Copy the bytes into a string.
+    std::string str() const {
+        return std::string(begin, size_);
+    };
+
+    //! Equality operator, compares the bytes.
+    bool operator==(ByteView const & other) const {
+        return size_ == other.size_
+               && (size_ == 0 || std::memcmp(begin, other.begin, size_) == 0);
+    };
+
+    //! Inequality operator.
+    bool operator!=(ByteView const & other) const {
+        return !(*this == other);
+    };
+
+    //! Lexicographic comparison of the bytes.
+    bool operator<(ByteView const & other) const {
+        int result = (size_ == 0 || other.size_ == 0) ? 0 :
+                     std::memcmp(begin, other.begin, std::min(size_, other.size_));
+        return result < 0 || (result == 0 && size_ < other.size_);
+    };
+
+private:
+    char const *begin;   //!< Start of the bytes.
+    std::size_t size_;   //!< Number of bytes.
+    std::string storage; //!< The bytes, if owned.
+
+    //! Refer to the storage.
+    void sync() {
+        begin = storage.data();
+        size_ = storage.size();
+    };
+};
+
+//! Equality with a string.
+inline bool operator==(ByteView const & view, std::string const & str)
+{
+    return view == ByteView(str.data(), str.size());
+};
+
+//! Equality with a string.
+inline bool operator==(std::string const & str, ByteView const & view)
+{
+    return view == str;
+};
+
+//! Inequality with a string.
+inline bool operator!=(ByteView const & view, std::string const & str)
+{
+    return !(view == str);
+};
+
+//! Inequality with a string.
+inline bool operator!=(std::string const & str, ByteView const & view)
+{
+    return !(view == str);
+};
+
+//! Hash of the bytes, for boost::hash and unordered containers.
+inline std::size_t hash_value(ByteView const & view)
+{
+    return boost::hash_range(view.data(), view.data() + view.size());
+};
+
+//! Output the bytes to a stream.
+inline std::ostream & operator<<(std::ostream & os, ByteView const & view)
+{
+    return os.write(view.data(), view.size());
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
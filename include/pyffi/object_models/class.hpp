@@ -38,14 +38,29 @@ POSSIBILITY OF SUCH DAMAGE.
 #ifndef PYFFI_OM_CLASS_HPP_INCLUDED
 #define PYFFI_OM_CLASS_HPP_INCLUDED
 
-#include <boost/any.hpp>
+#include <algorithm> // std::min
+#include <atomic>
 #include <boost/function.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/unordered_map.hpp>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
 
 #include "pyffi/object_models/attr_map.hpp"
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/byte_view.hpp"
 #include "pyffi/object_models/doc.hpp"
+#include "pyffi/object_models/layout.hpp"
+#include "pyffi/object_models/plan.hpp"
 #include "pyffi/object_models/scope.hpp"
+#include "pyffi/object_models/symbol.hpp"
+#include "pyffi/object_models/value.hpp"
 
 namespace pyffi
 {
@@ -58,10 +73,13 @@ namespace object_models
 //! Default init implementation for classes.
 /*!
   \param class_ The \ref Class "class" to create an instance from.
+  \param arena The \ref Arena "arena" to allocate from, or null to
+               allocate from the heap.
   \return A vector of \ref Instance "instances" for each \ref Attr
-          "attribute" in the class scope.
+          "attribute" in the class scope, including the attributes of
+          base classes.
 */
-boost::any class_init(Class const & class_);
+Value class_init(Class const & class_, Arena * arena);
 
 //! Default read implementation for classes.
 /*!
@@ -69,7 +87,7 @@ boost::any class_init(Class const & class_);
   \param value The internal representation of the instance.
   \param is The input stream.
 */
-void class_read(Class const & class_, boost::any & value, std::istream & is);
+void class_read(Class const & class_, Value & value, std::istream & is);
 
 //! Default write implementation for classes.
 /*!
@@ -77,7 +95,32 @@ void class_read(Class const & class_, boost::any & value, std::istream & is);
   \param value The internal representation of the instance.
   \param os The output stream.
 */
-void class_write(Class const & class_, boost::any const & value, std::ostream & os);
+void class_write(Class const & class_, Value const & value, std::ostream & os);
+
+//! Default read implementation for classes, from memory.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param reader The input buffer.
+*/
+void class_read_bytes(Class const & class_, Value & value, ByteReader & reader);
+
+//! Default write implementation for classes, to memory.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param writer The output buffer.
+*/
+void class_write_bytes(Class const & class_, Value const & value, ByteWriter & writer);
+
+//! Default size implementation for classes.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param globals The global variables for evaluating conditions.
+  \return The number of bytes that write produces.
+*/
+std::size_t class_size(Class const & class_, Value const & value, Globals const * globals);
 
 //! Default attribute implementation for classes.
 /*!
@@ -85,7 +128,7 @@ void class_write(Class const & class_, boost::any const & value, std::ostream &
   \param value The internal representation of the instance.
   \param name The attribute name.
 */
-Instance & class_attr(Class const & class_, boost::any & value, std::string const & name);
+Instance & class_attr(Class const & class_, Value & value, std::string const & name);
 
 //! Default const attribute implementation for classes.
 /*!
@@ -93,18 +136,171 @@ Instance & class_attr(Class const & class_, boost::any & value, std::string cons
   \param value The internal representation of the instance.
   \param name The attribute name.
 */
-Instance const & class_const_attr(Class const & class_, boost::any const & value, std::string const & name);
+Instance const & class_const_attr(Class const & class_, Value const & value, std::string const & name);
+
+//! The representation of instances of classes with a flat
+//! representation: the bytes of the layout, stored in words, so the
+//! buffer is aligned for all primitive types, also in an arena.
+class FlatBuffer
+{
+public:
+    //! Constructor, a zeroed buffer of the given size, allocating
+    //! from an arena (or from the heap if arena is null).
+    FlatBuffer(std::size_t size, Arena * arena)
+        : size_(size),
+          words((size + sizeof(long long) - 1) / sizeof(long long), 0,
+                ArenaAllocator<long long>(arena)) {};
+    //! Copy constructor, the copy resides in the arena of the given
+    //! allocator.
+    FlatBuffer(FlatBuffer const & other, ArenaAllocator<char> const & allocator)
+        : size_(other.size_), words(other.words, ArenaAllocator<long long>(allocator)) {};
+
+    //! Number of bytes.
+    std::size_t size() const {
+        return size_;
+    };
+
+    //! Whether the buffer has no bytes.
+    bool empty() const {
+        return size_ == 0;
+    };
+
+    //! Get the bytes.
+    char * data() {
+        return words.empty() ? 0 : reinterpret_cast<char *>(&words[0]);
+    };
+    //! Get the bytes.
+    char const * data() const {
+        return words.empty() ? 0 : reinterpret_cast<char const *>(&words[0]);
+    };
+
+    //! Get a byte.
+    char & operator[](std::size_t i) {
+        return data()[i];
+    };
+    //! Get a byte.
+    char const & operator[](std::size_t i) const {
+        return data()[i];
+    };
+
+private:
+    //! Storage, aligned for all primitive types.
+    typedef std::vector<long long, ArenaAllocator<long long> > WordVector;
+
+    std::size_t size_; //!< Number of bytes.
+    WordVector words;  //!< The bytes.
+};
+
+//! A run of bytes of a flat buffer, which are read and written at
+//! once (see Class::set_flat).
+class FlatRun
+{
+public:
+    //! Constructor.
+    FlatRun(std::size_t offset, std::size_t size, std::size_t word_size)
+        : offset(offset), size(size), word_size(word_size) {};
+
+    std::size_t offset;    //!< Offset in the buffer.
+    std::size_t size;      //!< Number of bytes.
+    std::size_t word_size; //!< Size of the words to swap, see type_word_size.
+};
+
+//! Init implementation for classes with a flat representation.
+/*!
+  \param class_ The \ref Class "class" to create an instance from.
+  \param arena The \ref Arena "arena" to allocate from, or null to
+               allocate from the heap.
+  \return A zero initialized buffer, of the size of the class layout,
+          which holds the data of all attributes at their offsets.
+*/
+Value flat_init(Class const & class_, Arena * arena);
+
+//! Read implementation for classes with a flat representation.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param is The input stream.
+*/
+void flat_read(Class const & class_, Value & value, std::istream & is);
+
+//! Write implementation for classes with a flat representation.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param os The output stream.
+*/
+void flat_write(Class const & class_, Value const & value, std::ostream & os);
+
+//! Read implementation for classes with a flat representation, from memory.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param reader The input buffer.
+*/
+void flat_read_bytes(Class const & class_, Value & value, ByteReader & reader);
+
+//! Write implementation for classes with a flat representation, to memory.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param writer The output buffer.
+*/
+void flat_write_bytes(Class const & class_, Value const & value, ByteWriter & writer);
+
+//! Size implementation for classes with a flat representation.
+/*!
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param globals The global variables for evaluating conditions.
+  \return The number of bytes that write produces, which excludes
+          the padding in the buffer.
+*/
+std::size_t flat_size(Class const & class_, Value const & value, Globals const * globals);
+
+//! Attribute implementation for classes with a flat representation.
+/*!
+  Always throws a runtime error, as flat instances do not store an
+  instance for each attribute; use Instance::get with an attribute
+  name instead.
+
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param name The attribute name.
+*/
+Instance & flat_attr(Class const & class_, Value & value, std::string const & name);
+
+//! Const attribute implementation for classes with a flat representation.
+/*!
+  Always throws a runtime error.
+
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param name The attribute name.
+*/
+Instance const & flat_const_attr(Class const & class_, Value const & value, std::string const & name);
+
+//! Size of the words whose bytes are swapped when a primitive type
+//! is read or written in a foreign byte order: the size of the type
+//! if it is a number, and 1 otherwise.
+template<class ValueType>
+std::size_t type_word_size()
+{
+    return (std::is_arithmetic<ValueType>::value || std::is_enum<ValueType>::value)
+           ? sizeof(ValueType) : 1;
+};
 
 //! Init implementation for primitive types.
 /*!
   \tparam ValueType The primitive type that is used to represent this class.
   \param class_ The \ref Class "class" to create an instance from.
+  \param arena The \ref Arena "arena" to allocate from, or null to
+               allocate from the heap.
   \return A ValueType instance, created by calling the default constructor.
 */
 template<class ValueType>
-boost::any type_init(Class const & class_)
+Value type_init(Class const & class_, Arena * arena)
 {
-    return boost::any(ValueType());
+    return Value(ValueType(), arena);
 };
 
 //! Read implementation for primitive types.
@@ -115,9 +311,9 @@ boost::any type_init(Class const & class_)
   \param is The input stream.
 */
 template<class ValueType>
-void type_read(Class const & class_, boost::any & value, std::istream & is)
+void type_read(Class const & class_, Value & value, std::istream & is)
 {
-    is.read((char *)boost::any_cast<ValueType>(&value), sizeof(ValueType));
+    read_words(is, value_cast<ValueType>(&value), sizeof(ValueType), type_word_size<ValueType>());
 };
 
 //! Write implementation for primitive types.
@@ -128,9 +324,49 @@ void type_read(Class const & class_, boost::any & value, std::istream & is)
   \param os The output stream.
 */
 template<class ValueType>
-void type_write(Class const & class_, boost::any const & value, std::ostream & os)
+void type_write(Class const & class_, Value const & value, std::ostream & os)
+{
+    write_words(os, value_cast<ValueType>(&value), sizeof(ValueType), type_word_size<ValueType>());
+};
+
+//! Read implementation for primitive types, from memory.
+/*!
+  \tparam ValueType The primitive type that is used to represent this class.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param reader The input buffer.
+*/
+template<class ValueType>
+void type_read_bytes(Class const & class_, Value & value, ByteReader & reader)
+{
+    read_words(reader, value_cast<ValueType>(&value), sizeof(ValueType), type_word_size<ValueType>());
+};
+
+//! Write implementation for primitive types, to memory.
+/*!
+  \tparam ValueType The primitive type that is used to represent this class.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param writer The output buffer.
+*/
+template<class ValueType>
+void type_write_bytes(Class const & class_, Value const & value, ByteWriter & writer)
 {
-    os.write((char *)boost::any_cast<ValueType>(&value), sizeof(ValueType));
+    write_words(writer, value_cast<ValueType>(&value), sizeof(ValueType), type_word_size<ValueType>());
+};
+
+//! Size implementation for primitive types.
+/*!
+  \tparam ValueType The primitive type that is used to represent this class.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param globals The global variables for evaluating conditions.
+  \return The number of bytes that write produces.
+*/
+template<class ValueType>
+std::size_t type_size(Class const & class_, Value const & value, Globals const * globals)
+{
+    return sizeof(ValueType);
 };
 
 //! Attribute implementation for primitive types.
@@ -143,7 +379,7 @@ void type_write(Class const & class_, boost::any const & value, std::ostream & o
   \param name The attribute name.
 */
 template<class ValueType>
-Instance & type_attr(Class const & class_, boost::any & value, std::string const & name)
+Instance & type_attr(Class const & class_, Value & value, std::string const & name)
 {
     throw std::runtime_error("class has no attributes");
 };
@@ -158,11 +394,174 @@ Instance & type_attr(Class const & class_, boost::any & value, std::string const
   \param name The attribute name.
 */
 template<class ValueType>
-Instance const & type_const_attr(Class const & class_, boost::any const & value, std::string const & name)
+Instance const & type_const_attr(Class const & class_, Value const & value, std::string const & name)
 {
     throw std::runtime_error("class has no attributes");
 };
 
+//! Init implementation for length prefixed strings.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The \ref Class "class" to create an instance from.
+  \param arena The \ref Arena "arena" to allocate from, or null to
+               allocate from the heap.
+  \return An empty ByteView.
+*/
+template<class LengthType>
+Value sized_string_init(Class const & class_, Arena * arena)
+{
+    return Value(ByteView(), arena);
+};
+
+//! Read implementation for length prefixed strings. A stream cannot
+//! be referred to, so the string owns a copy of its bytes.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param is The input stream.
+*/
+template<class LengthType>
+void sized_string_read(Class const & class_, Value & value, std::istream & is)
+{
+    LengthType length = 0;
+    read_words(is, &length, sizeof(LengthType), type_word_size<LengthType>());
+    // grow in bounded chunks, so a corrupt length cannot allocate
+    // more than the stream actually holds
+    std::size_t const chunk_size = 65536;
+    std::size_t size = static_cast<std::size_t>(length);
+    std::string str;
+    while (str.size() < size && is) {
+        std::size_t pos = str.size();
+        str.resize(pos + std::min(chunk_size, size - pos));
+        read_raw(is, &str[pos], str.size() - pos);
+        str.resize(pos + static_cast<std::size_t>(is.gcount()));
+    };
+    value_cast<ByteView &>(value).assign(std::move(str));
+};
+
+//! Length prefix of a length prefixed string. Throws a runtime error
+//! if the length does not fit the length type.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param view The string.
+  \return The length.
+*/
+template<class LengthType>
+LengthType sized_string_length(ByteView const & view)
+{
+    if (view.size() > static_cast<unsigned long long>(std::numeric_limits<LengthType>::max())) {
+        throw std::runtime_error("string too long for its length type");
+    };
+    return static_cast<LengthType>(view.size());
+};
+
+//! Write implementation for length prefixed strings.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param os The output stream.
+*/
+template<class LengthType>
+void sized_string_write(Class const & class_, Value const & value, std::ostream & os)
+{
+    ByteView const & view = value_cast<ByteView const &>(value);
+    LengthType length = sized_string_length<LengthType>(view);
+    write_words(os, &length, sizeof(LengthType), type_word_size<LengthType>());
+    write_raw(os, view.data(), view.size());
+};
+
+//! Read implementation for length prefixed strings, from memory. The
+//! string refers to the memory, without copying it, so the memory
+//! must outlive the instance (or ByteView::own must be called).
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param reader The input buffer.
+*/
+template<class LengthType>
+void sized_string_read_bytes(Class const & class_, Value & value, ByteReader & reader)
+{
+    LengthType length = 0;
+    read_words(reader, &length, sizeof(LengthType), type_word_size<LengthType>());
+    std::size_t size = static_cast<std::size_t>(length);
+    value_cast<ByteView &>(value) = ByteView(reader.take(size), size);
+};
+
+//! Write implementation for length prefixed strings, to memory.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param writer The output buffer.
+*/
+template<class LengthType>
+void sized_string_write_bytes(Class const & class_, Value const & value, ByteWriter & writer)
+{
+    ByteView const & view = value_cast<ByteView const &>(value);
+    LengthType length = sized_string_length<LengthType>(view);
+    write_words(writer, &length, sizeof(LengthType), type_word_size<LengthType>());
+    writer.write(view.data(), view.size());
+};
+
+//! Size implementation for length prefixed strings.
+/*!
+  \tparam LengthType The primitive type of the length.
+  \param class_ The class of the instance.
+  \param value The internal representation of the instance.
+  \param globals The global variables for evaluating conditions.
+  \return The number of bytes that write produces.
+*/
+template<class LengthType>
+std::size_t sized_string_size(Class const & class_, Value const & value, Globals const * globals)
+{
+    return sizeof(LengthType) + value_cast<ByteView const &>(value).size();
+};
+
+//! The specialized plan that a class last found for global variables
+//! (see Class::get_plan): the generation of the variables in the high
+//! 48 bits, and one plus the index of the plan in the low 16 bits, or
+//! zero for the plan that is not specialized. Both are updated at once,
+//! so threads can share it without a lock. Copies start empty.
+class PlanCache
+{
+public:
+    //! The number of bits that hold the index.
+    static int const index_bits = 16;
+
+    //! Default constructor.
+    PlanCache() : value(0) {};
+
+    //! Copy constructor.
+    PlanCache(PlanCache const &) : value(0) {};
+
+    //! Assignment operator.
+    PlanCache & operator=(PlanCache const &) {
+        reset();
+        return *this;
+    };
+
+    //! Get the cached value.
+    std::uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    };
+
+    //! Set the cached value.
+    void set(std::uint64_t new_value) {
+        value.store(new_value, std::memory_order_relaxed);
+    };
+
+    //! Forget the cached value.
+    void reset() {
+        set(0);
+    };
+
+private:
+    std::atomic<std::uint64_t> value; //!< The cached value.
+};
+
 //! A class declaration is a named scope, along with a base class.
 class Class
 {
@@ -171,14 +570,20 @@ public:
     Class()
         : name(), base_name(), doc(), scope(),
           init(&class_init), read(&class_read), write(&class_write),
-          attr(&class_attr), const_attr(&class_const_attr),
-          base_class() {};
+          read_bytes(&class_read_bytes), write_bytes(&class_write_bytes),
+          size(&class_size), attr(&class_attr), const_attr(&class_const_attr),
+          id(), symbol(), base_class(), layout(), type(), word_size(1),
+          min_size(0), sized_string(false), length_type(), plan(), specialized_plans(),
+          specialized_indices(), plan_cache(), prototype(), flat_runs() {};
     //! Constructor.
     Class(std::string const & name)
         : name(name), base_name(), doc(), scope(),
           init(&class_init), read(&class_read), write(&class_write),
-          attr(&class_attr), const_attr(&class_const_attr),
-          base_class() {};
+          read_bytes(&class_read_bytes), write_bytes(&class_write_bytes),
+          size(&class_size), attr(&class_attr), const_attr(&class_const_attr),
+          id(), symbol(), base_class(), layout(), type(), word_size(1),
+          min_size(0), sized_string(false), length_type(), plan(), specialized_plans(),
+          specialized_indices(), plan_cache(), prototype(), flat_runs() {};
 
     // information about the class which is stored in the format description
     std::string name;                       //!< Name of this class.
@@ -187,32 +592,181 @@ public:
     boost::optional<Scope> scope;           //!< Declarations of this class.
 
     //! Constructor method.
-    boost::function<boost::any(Class const &)> init;
+    boost::function<Value(Class const &, Arena *)> init;
     //! Read from stream method.
-    boost::function<void(Class const &, boost::any &, std::istream &)> read;
+    boost::function<void(Class const &, Value &, std::istream &)> read;
     //! Write to stream method.
-    boost::function<void(Class const &, boost::any const &, std::ostream &)> write;
+    boost::function<void(Class const &, Value const &, std::ostream &)> write;
+    //! Read from memory method.
+    boost::function<void(Class const &, Value &, ByteReader &)> read_bytes;
+    //! Write to memory method.
+    boost::function<void(Class const &, Value const &, ByteWriter &)> write_bytes;
+    //! Number of bytes written method.
+    boost::function<std::size_t(Class const &, Value const &, Globals const *)> size;
     //! Get attribute.
-    boost::function<Instance &(Class const &, boost::any &, std::string const &)> attr;
+    boost::function<Instance &(Class const &, Value &, std::string const &)> attr;
     //! Get const attribute.
-    boost::function<Instance const &(Class const &, boost::any const &, std::string const &)> const_attr;
+    boost::function<Instance const &(Class const &, Value const &, std::string const &)> const_attr;
 
-    //! Set default implementation for given type.
+    //! Set default implementation for given type. To be called
+    //! before the scope is compiled, so the layout of the type is
+    //! taken into account.
     template <class ValueType>
     void set_type() {
         init = &type_init<ValueType>;
         read = &type_read<ValueType>;
         write = &type_write<ValueType>;
+        read_bytes = &type_read_bytes<ValueType>;
+        write_bytes = &type_write_bytes<ValueType>;
+        size = &type_size<ValueType>;
         attr = &type_attr<ValueType>;
         const_attr = &type_const_attr<ValueType>;
+        layout = Layout(sizeof(ValueType), boost::alignment_of<ValueType>::value);
+        type = &typeid(ValueType);
+        word_size = type_word_size<ValueType>();
+        min_size = sizeof(ValueType);
+        sized_string = false;
+        length_type = 0;
+        prototype.reset();
+    };
+
+    //! Set implementation for strings and blobs which are stored as a
+    //! length followed by that many bytes; instances hold a ByteView.
+    //! Any attributes in the scope are ignored. To be called before
+    //! the scope is compiled, so the class is known to have no fixed
+    //! size.
+    template <class LengthType>
+    void set_sized_string() {
+        init = &sized_string_init<LengthType>;
+        read = &sized_string_read<LengthType>;
+        write = &sized_string_write<LengthType>;
+        read_bytes = &sized_string_read_bytes<LengthType>;
+        write_bytes = &sized_string_write_bytes<LengthType>;
+        size = &sized_string_size<LengthType>;
+        attr = &type_attr<ByteView>;
+        const_attr = &type_const_attr<ByteView>;
+        layout.reset();
+        type = 0;
+        word_size = 1;
+        min_size = sizeof(LengthType);
+        sized_string = true;
+        length_type = &typeid(LengthType);
+        prototype.reset();
+    };
+
+    //! Set flat implementation, which stores all attributes in one
+    //! contiguous buffer. Only for classes that have a fixed size
+    //! layout, so the scope must have been compiled. The buffer is
+    //! read and written in runs of bytes which are computed here:
+    //! a single run if the class is packed (see is_packed).
+    void set_flat();
+
+    //! Get the runs of bytes of a flat buffer, if set by set_flat.
+    std::vector<FlatRun> const & get_flat_runs() const {
+        return flat_runs;
+    };
+
+    //! Create the value of a new instance, by copying the prototype
+    //! of the class. The prototype is created by init, on first use,
+    //! and includes the prototypes of all attributes, so set_type and
+    //! set_flat should be called before any class is instantiated.
+    /*!
+      \param arena The \ref Arena "arena" to allocate from, or null to
+                   allocate from the heap.
+    */
+    Value instantiate(Arena * arena) const;
+
+    //! Get the id, which is unique among the classes of a top-level
+    //! scope, and dense: ids count from zero in order of declaration
+    //! (see Scope::get_class).
+    std::size_t get_id() const {
+        return id;
+    };
+
+    //! Get the interned name.
+    Symbol get_symbol() const {
+        return symbol;
     };
 
     //! Get a reference to the actual class.
     boost::optional<Class const &> get_base_class() const;
 
+    //! Get the layout, if the class has a fixed size.
+    boost::optional<Layout const &> get_layout() const;
+
+    //! Get the primitive type, if set by set_type.
+    boost::optional<std::type_info const &> get_type() const;
+
+    //! Whether the class is a length prefixed string, see set_sized_string.
+    bool is_sized_string() const {
+        return sized_string;
+    };
+
+    //! Get the primitive type of the length of a length prefixed
+    //! string, if set by set_sized_string.
+    boost::optional<std::type_info const &> get_length_type() const;
+
+    //! Get the size of the words whose bytes are swapped when
+    //! reading or writing in a foreign byte order, see type_word_size.
+    //! For other classes of fixed size, this is the size which all
+    //! their words share, or zero if they differ or if the layout has
+    //! padding.
+    std::size_t get_word_size() const {
+        return word_size;
+    };
+
+    //! Get the least number of bytes which an instance takes in a
+    //! file: the size of a primitive type, or of the length of a
+    //! length prefixed string, and for other classes, the sum for
+    //! their base class and for all attributes which are read
+    //! unconditionally, where arrays count as empty. Used to reject
+    //! corrupt array lengths before allocating the elements.
+    std::size_t get_min_size() const {
+        return min_size;
+    };
+
+    //! Whether instances are stored in memory exactly as in a file,
+    //! apart from the byte order: the class has a fixed size layout
+    //! without padding, and all its words have the same size. Arrays
+    //! of such classes are read and written in bulk, see \ref Array.
+    bool is_packed() const {
+        return layout && word_size;
+    };
+
+    //! Get the plan for reading and writing all attributes.
+    Plan const & get_plan() const;
+
+    //! Get the plan for reading and writing all attributes with the
+    //! given global variables: the plan specialized for exactly these
+    //! variables by Scope::compile(Globals const &), if any, and the
+    //! plan of get_plan() otherwise.
+    Plan const & get_plan(Globals const * globals) const {
+        if (!globals || specialized_plans.empty()) {
+            return plan;
+        };
+        // the variables are only hashed when their generation changes,
+        // not for every instance that is read with them
+        std::uint64_t const generation =
+            globals->get_generation() << PlanCache::index_bits;
+        std::uint64_t cached = plan_cache.get();
+        if ((cached >> PlanCache::index_bits) << PlanCache::index_bits != generation) {
+            cached = generation | find_specialized_plan(*globals);
+            plan_cache.set(cached);
+        };
+        std::size_t const index = static_cast<std::size_t>(
+                                      cached & ((1 << PlanCache::index_bits) - 1));
+        return index ? specialized_plans[index - 1] : plan;
+    };
+
     //! Get attribute (Attr, not Instance).
     Attr const & get_attr(std::string const & name) const;
 
+    //! Get attribute by its interned name.
+    Attr const & get_attr(Symbol const & symbol) const;
+
+    //! Get all attributes, including those of base classes.
+    AttrMap const & get_attr_map() const;
+
     //! Equality operator.
     bool operator==(Class const & other) const {
         return
@@ -229,10 +783,37 @@ public:
 
 private:
 
+    std::size_t id;          //!< Index in the top-level scope.
+    Symbol symbol;           //!< Interned name.
     Class const *base_class; //!< Pointer to the base class.
     AttrMap attr_map;        //!< Maps attribute names to attributes.
-
+    boost::optional<Layout> layout; //!< Layout, if of fixed size.
+    std::type_info const *type; //!< Primitive type, if set by set_type.
+    std::size_t word_size;   //!< Size of words to swap, see get_word_size.
+    std::size_t min_size;    //!< Least size in a file, see get_min_size.
+    bool sized_string;       //!< Whether set by set_sized_string.
+    std::type_info const *length_type; //!< Length type, if set by set_sized_string.
+    Plan plan;               //!< Plan for reading and writing.
+    //! Plans specialized for global variables, where they differ from plan.
+    std::vector<Plan> specialized_plans;
+    //! Index in specialized_plans of the plan for global variables.
+    boost::unordered_map<Globals, std::size_t> specialized_indices;
+    //! The specialized plan last found, see get_plan.
+    mutable PlanCache plan_cache;
+    //! Value of a default instance, created on first instantiation.
+    mutable boost::shared_ptr<Value const> prototype;
+    //! Runs of bytes of a flat buffer, if set by set_flat.
+    std::vector<FlatRun> flat_runs;
+
+    friend class declaration_compile_lcm_ps_visitor; // sets id and symbol
     friend class declaration_compile_a_bc_visitor; // sets base_class
+    friend class declaration_compile_f_visitor; // freezes attr_map
+    friend class declaration_compile_l_o_visitor; // sets layout, word_size and min_size
+    friend class declaration_compile_p_visitor; // sets plan and specialized_plans
+
+    //! Find the specialized plan for global variables, for PlanCache:
+    //! one plus its index, or zero if there is none.
+    std::uint64_t find_specialized_plan(Globals const & globals) const;
 };
 
 } // namespace object_models
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_EMBEDDED_SCHEMA_HPP_INCLUDED
+#define PYFFI_OM_EMBEDDED_SCHEMA_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+class Scope; // full declaration in scope.hpp
+
+//! A format description which is linked into the executable, as a
+//! \ref Scope::write_cache "schema cache" in a constant table, so it
+//! needs no file and no xml parsing at run time.
+/*!
+  Such tables are generated at build time by the pyffi_embed tool;
+  the pyffi_embed_schema CMake function sets this up. Being an
+  aggregate of constants, an embedded schema is initialized before
+  any code runs.
+
+  This is an embedded cache, not a compiled schema. The table holds
+  the syntax tree only. Scope::read_cache still deserializes it into a
+  Scope at run time, and Scope::compile must still run afterwards to
+  compute the layouts, offsets and read plans. Those hold function
+  hooks and pointers, so they are not emitted as constant data; the
+  start up cost of compiling remains. Formats which must not pay it
+  can be converted into C++ readers instead, see Scope::generate_cpp,
+  at the price of the dynamic object model.
+*/
+struct EmbeddedSchema {
+    unsigned char const *data; //!< The schema cache.
+    std::size_t size;          //!< Size of the schema cache, in bytes.
+    std::uint64_t source_hash; //!< Hash of the format description.
+};
+
+//! Write a C++ header and source which define an embedded schema,
+//! pyffi::schemas::name, for the given scope. Throws a runtime error
+//! if the name is not a C++ identifier.
+/*!
+  \param scope The syntax tree of the format description.
+  \param source_hash Hash of the format description, see Scope::hash_source.
+  \param name The name of the embedded schema.
+  \param header_filename The name of the header, as it is included
+                         by the source.
+  \param header The header is written to this stream.
+  \param source The source is written to this stream.
+*/
+void write_embedded_schema(
+    Scope const & scope, std::uint64_t source_hash,
+    std::string const & name, std::string const & header_filename,
+    std::ostream & header, std::ostream & source);
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
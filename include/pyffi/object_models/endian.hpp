@@ -0,0 +1,97 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_ENDIAN_HPP_INCLUDED
+#define PYFFI_OM_ENDIAN_HPP_INCLUDED
+
+#include <cstddef>
+#include <ios>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! The byte order of the data in a stream.
+enum class Endian {
+    NATIVE, //!< Byte order of the host, so no bytes are swapped.
+    LITTLE, //!< Least significant byte first.
+    BIG     //!< Most significant byte first.
+};
+
+//! Get the byte order of the host, LITTLE or BIG.
+inline Endian native_endian()
+{
+    unsigned short const one = 1;
+    return (*reinterpret_cast<unsigned char const *>(&one) == 1)
+           ? Endian::LITTLE : Endian::BIG;
+};
+
+//! Check whether data in the given byte order must be swapped on
+//! this host.
+inline bool is_swapped(Endian endian)
+{
+    return (endian != Endian::NATIVE) && (endian != native_endian());
+};
+
+//! Reverse the bytes of every word in an array, in place. Words of 2,
+//! 4, and 8 bytes are swapped by vectorized kernels, if the processor
+//! supports them; the best kernel is selected on first use.
+/*!
+  \param data Start of the array.
+  \param word_size Size of each word, in bytes.
+  \param count Number of words.
+*/
+void swap_bytes(void * data, std::size_t word_size, std::size_t count);
+
+//! Get the name of the kernel which swap_bytes uses for words of
+//! the given size, for diagnostics.
+char const * swap_kernel(std::size_t word_size);
+
+//! Get the byte order of a stream, NATIVE unless set by set_endian.
+Endian get_endian(std::ios_base & stream);
+
+//! Set the byte order in which instances are read from, and written
+//! to, a stream.
+void set_endian(std::ios_base & stream, Endian endian);
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
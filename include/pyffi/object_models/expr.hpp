@@ -0,0 +1,487 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_EXPR_HPP_INCLUDED
+#define PYFFI_OM_EXPR_HPP_INCLUDED
+
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! An expression, as used for the conditions of if and elif
+//! declarations.
+/*!
+  Expressions are written with the operators and precedence of C:
+  logical (!, &&, ||), bitwise (~, &, ^, |, <<, >>), comparison (==,
+  !=, <, <=, >, >=), and arithmetic (-, +, *, /, %), on integer
+  literals (decimal or hexadecimal), true, false, and names. A name
+  refers to an attribute of the class being read, or, if the class
+  has no attribute of that name, to a \ref Globals "global variable",
+  such as the file version. For example:
+
+  \code
+  version >= 0x0A000100 && (flags & 1) != 0
+  \endcode
+
+  Expressions are immutable trees, so copies are cheap and share
+  their nodes. They are compiled into an \ref ExprCode "ExprCode"
+  for evaluation.
+*/
+class Expr
+{
+public:
+    //! The kind of a node.
+    enum Op {
+        CONST,   //!< Integer literal.
+        NAME,    //!< Attribute or global variable.
+        NOT,     //!< Logical not.
+        NEG,     //!< Negation.
+        BIT_NOT, //!< Bitwise not.
+        MUL,     //!< Multiplication.
+        DIV,     //!< Division; zero if dividing by zero.
+        MOD,     //!< Remainder; zero if dividing by zero.
+        ADD,     //!< Addition.
+        SUB,     //!< Subtraction.
+        SHL,     //!< Shift left.
+        SHR,     //!< Shift right.
+        LT,      //!< Less than.
+        LE,      //!< Less than or equal.
+        GT,      //!< Greater than.
+        GE,      //!< Greater than or equal.
+        EQ,      //!< Equal.
+        NE,      //!< Not equal.
+        BIT_AND, //!< Bitwise and.
+        BIT_XOR, //!< Bitwise exclusive or.
+        BIT_OR,  //!< Bitwise or.
+        AND,     //!< Logical and.
+        OR       //!< Logical or.
+    };
+
+    //! Default constructor, for the constant false.
+    Expr();
+    //! Constructor for the constant true or false.
+    Expr(bool value);
+
+    //! Create an integer literal; hex only affects how it is written.
+    static Expr constant(long long value, bool hex = false);
+    //! Create a reference to an attribute or global variable.
+    static Expr name(std::string const & name);
+    //! Create a unary operation (NOT, NEG, or BIT_NOT).
+    static Expr unary(Op op, Expr const & operand);
+    //! Create a binary operation.
+    static Expr binary(Op op, Expr const & left, Expr const & right);
+
+    //! Parse an expression; throws a runtime error on syntax errors.
+    static Expr parse(std::string const & text);
+    //! Write the expression, with as few parentheses as possible.
+    std::string str() const;
+
+    //! The kind of the root node.
+    Op get_op() const;
+    //! Value of a CONST node.
+    long long get_value() const;
+    //! Whether a CONST node is written in hexadecimal.
+    bool is_hex() const;
+    //! Whether a CONST node is written as true or false.
+    bool is_boolean() const;
+    //! Name of a NAME node.
+    std::string const & get_name() const;
+    //! Operand of a unary node, or left operand of a binary node.
+    Expr get_left() const;
+    //! Right operand of a binary node.
+    Expr get_right() const;
+
+    //! Equality operator; compares structure, not how literals are written.
+    bool operator==(Expr const & other) const;
+
+    //! Inequality operator.
+    bool operator!=(Expr const & other) const {
+        return !(*this == other);
+    };
+
+private:
+    class Node;
+    boost::shared_ptr<Node const> node; //!< The root node.
+
+    //! Constructor from a node.
+    explicit Expr(boost::shared_ptr<Node const> const & node) : node(node) {};
+
+    //! Write the expression, in parentheses if it binds less tightly
+    //! than the given precedence.
+    void write(std::ostream & os, int context) const;
+};
+
+//! Values of the global variables of expressions, such as the file
+//! version. Names are resolved to slots once, when compiling, so
+//! evaluating a global is a single array lookup. Variables that are
+//! not set evaluate to zero.
+class Globals
+{
+public:
+    //! Default constructor.
+    Globals() : values(), generation(next_generation()) {};
+
+    //! Get the slot of a global variable name; the same name always
+    //! gets the same slot.
+    static std::size_t get_slot(std::string const & name);
+
+    //! Set a variable.
+    void set(std::string const & name, long long value);
+
+    //! Check whether the variable of a slot is set.
+    bool has(std::size_t slot) const {
+        return slot < values.size() && values[slot];
+    };
+
+    //! Get the value of the variable of a slot.
+    long long get(std::size_t slot) const {
+        return has(slot) ? values[slot].get() : 0;
+    };
+
+    //! Get the value of a variable.
+    long long get(std::string const & name) const {
+        return get(get_slot(name));
+    };
+
+    //! Equality operator: the same variables are set, to the same values.
+    bool operator==(Globals const & other) const {
+        return values == other.values;
+    };
+
+    //! Inequality operator.
+    bool operator!=(Globals const & other) const {
+        return !(*this == other);
+    };
+
+    //! Get the generation of the variables, which changes on every
+    //! set, and which no other variables share unless they are a
+    //! copy; so lookups by value can be cached by generation (see
+    //! Class::get_plan).
+    std::uint64_t get_generation() const {
+        return generation;
+    };
+
+    //! Hash, so global variables can be used as keys of unordered maps.
+    friend std::size_t hash_value(Globals const & globals);
+
+private:
+    std::vector<boost::optional<long long> > values; //!< Values by slot.
+    std::uint64_t generation; //!< Generation, see get_generation.
+
+    //! Get a generation that was never handed out before.
+    static std::uint64_t next_generation();
+};
+
+//! Get the global variables of a stream, null unless set by set_globals.
+Globals const * get_globals(std::ios_base & stream);
+
+//! Set the global variables for evaluating conditions when reading
+//! from, or writing to, a stream. The stream does not own them.
+void set_globals(std::ios_base & stream, Globals const * globals);
+
+//! A compiled expression: a program for a small stack machine, in
+//! which names are resolved to attribute indices or global slots, and
+//! in which constant subexpressions are folded.
+class ExprCode
+{
+public:
+    //! Type of a number loaded from an attribute.
+    enum Type {
+        BOOL, CHAR, SCHAR, UCHAR, SHORT, USHORT, INT, UINT,
+        LONG, ULONG, LLONG, ULLONG, FLOAT, DOUBLE
+    };
+
+    //! The kind of an instruction.
+    enum Code {
+        PUSH,   //!< Push value.
+        ATTR,   //!< Push the attribute at index value, of type.
+        GLOBAL, //!< Push the global variable at slot value.
+        UNARY,  //!< Apply op to the top of the stack.
+        BINARY  //!< Apply op to the top two values of the stack.
+    };
+
+    //! An instruction.
+    class Instr
+    {
+    public:
+        //! Constructor.
+        Instr(Code code, long long value = 0, Expr::Op op = Expr::CONST, Type type = BOOL)
+            : code(code), op(op), type(type), value(value) {};
+
+        Code code;       //!< The kind of instruction.
+        Expr::Op op;     //!< Operation, for UNARY and BINARY.
+        Type type;       //!< Type of the attribute, for ATTR.
+        long long value; //!< Value, index, or slot.
+
+        //! Equality operator.
+        bool operator==(Instr const & other) const {
+            return
+                (code == other.code) &&
+                (op == other.op) &&
+                (type == other.type) &&
+                (value == other.value);
+        };
+    };
+
+    //! Resolves an attribute name to its index and type, or none if
+    //! the name is not an attribute.
+    typedef boost::function<boost::optional<std::pair<std::size_t, Type> >(std::string const &)> Resolver;
+
+    //! Maximal depth of the stack.
+    static const std::size_t max_depth = 32;
+
+    //! Default constructor, for the constant false.
+    ExprCode() : instrs(1, Instr(PUSH, 0)) {};
+
+    //! Compile an expression.
+    /*!
+      \param expr The expression.
+      \param resolve Resolves attribute names.
+      \param constants Global variables whose values are known at
+                       compile time, and which are folded; may be null.
+    */
+    ExprCode(Expr const & expr, Resolver const & resolve, Globals const * constants = 0);
+
+    //! Get the type of numbers of the given C++ type, if it is an
+    //! arithmetic type.
+    static boost::optional<Type> get_type(std::type_info const & type);
+
+    //! Whether the expression folded into a constant.
+    bool is_constant() const {
+        return instrs.size() == 1 && instrs[0].code == PUSH;
+    };
+
+    //! Get the instructions.
+    std::vector<Instr> const & get_instrs() const {
+        return instrs;
+    };
+
+    //! Evaluate the expression.
+    /*!
+      \param load_attr Gets a pointer to the data of the attribute at
+                       the given index.
+      \param globals The global variables; may be null.
+    */
+    template <typename LoadAttr>
+    long long evaluate(LoadAttr const & load_attr, Globals const * globals) const {
+        long long stack[max_depth];
+        std::size_t top = 0;
+        for (std::vector<Instr>::const_iterator it = instrs.begin(); it != instrs.end(); ++it) {
+            switch (it->code) {
+            case PUSH:
+                stack[top++] = it->value;
+                break;
+            case ATTR:
+                stack[top++] = load(load_attr(static_cast<std::size_t>(it->value)), it->type);
+                break;
+            case GLOBAL:
+                stack[top++] = globals ? globals->get(static_cast<std::size_t>(it->value)) : 0;
+                break;
+            case UNARY:
+                stack[top - 1] = apply(it->op, stack[top - 1]);
+                break;
+            case BINARY:
+                top--;
+                stack[top - 1] = apply(it->op, stack[top - 1], stack[top]);
+                break;
+            };
+        };
+        return stack[0];
+    };
+
+    //! Apply a unary operation.
+    static long long apply(Expr::Op op, long long operand) {
+        switch (op) {
+        case Expr::NOT:
+            return !operand;
+        case Expr::NEG:
+            return static_cast<long long>(0ULL - static_cast<unsigned long long>(operand));
+        case Expr::BIT_NOT:
+            return ~operand;
+        default:
+            return operand;
+        };
+    };
+
+    //! Apply a binary operation. Arithmetic wraps around, and
+    //! dividing by zero gives zero.
+    static long long apply(Expr::Op op, long long left, long long right) {
+        unsigned long long const uleft = static_cast<unsigned long long>(left);
+        unsigned long long const uright = static_cast<unsigned long long>(right);
+        switch (op) {
+        case Expr::MUL:
+            return static_cast<long long>(uleft * uright);
+        case Expr::DIV:
+            return (right == 0) ? 0 : (right == -1) ? apply(Expr::NEG, left) : left / right;
+        case Expr::MOD:
+            return (right == 0 || right == -1) ? 0 : left % right;
+        case Expr::ADD:
+            return static_cast<long long>(uleft + uright);
+        case Expr::SUB:
+            return static_cast<long long>(uleft - uright);
+        case Expr::SHL:
+            return static_cast<long long>(uleft << (uright & 63));
+        case Expr::SHR:
+            return left >> (uright & 63);
+        case Expr::LT:
+            return left < right;
+        case Expr::LE:
+            return left <= right;
+        case Expr::GT:
+            return left > right;
+        case Expr::GE:
+            return left >= right;
+        case Expr::EQ:
+            return left == right;
+        case Expr::NE:
+            return left != right;
+        case Expr::BIT_AND:
+            return left & right;
+        case Expr::BIT_XOR:
+            return left ^ right;
+        case Expr::BIT_OR:
+            return left | right;
+        case Expr::AND:
+            return left && right;
+        case Expr::OR:
+            return left || right;
+        default:
+            return left;
+        };
+    };
+
+    //! Convert a floating point number, truncated towards zero.
+    //! Throws a runtime error if it is not a number or out of range,
+    //! rather than converting it, which is undefined.
+    static long long truncate(double value) {
+        // false for not a number, too
+        if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0)) {
+            throw std::runtime_error("number out of range in expression");
+        };
+        return static_cast<long long>(value);
+    };
+
+    //! Load a number of the given type.
+    static long long load(void const * data, Type type) {
+        switch (type) {
+        case BOOL:
+            return load_as<bool>(data);
+        case CHAR:
+            return load_as<char>(data);
+        case SCHAR:
+            return load_as<signed char>(data);
+        case UCHAR:
+            return load_as<unsigned char>(data);
+        case SHORT:
+            return load_as<short>(data);
+        case USHORT:
+            return load_as<unsigned short>(data);
+        case INT:
+            return load_as<int>(data);
+        case UINT:
+            return load_as<unsigned int>(data);
+        case LONG:
+            return load_as<long>(data);
+        case ULONG:
+            return load_as<unsigned long>(data);
+        case LLONG:
+            return load_as<long long>(data);
+        case ULLONG:
+            return load_as<unsigned long long>(data);
+        case FLOAT:
+            return load_float_as<float>(data);
+        case DOUBLE:
+            return load_float_as<double>(data);
+        };
+        return 0;
+    };
+
+    //! Equality operator.
+    bool operator==(ExprCode const & other) const {
+        return instrs == other.instrs;
+    };
+
+    //! Inequality operator.
+    bool operator!=(ExprCode const & other) const {
+        return !(*this == other);
+    };
+
+private:
+    std::vector<Instr> instrs; //!< The instructions, in postfix order.
+
+    //! Load a number of type T, from possibly unaligned data.
+    template <typename T>
+    static long long load_as(void const * data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return static_cast<long long>(value);
+    };
+
+    //! Load a floating point number of type T, from possibly
+    //! unaligned data (see truncate).
+    template <typename T>
+    static long long load_float_as(void const * data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return truncate(value);
+    };
+
+    //! Append the instructions of an expression, which must be
+    //! folded; return the depth of the stack it needs.
+    std::size_t append(Expr const & expr, Resolver const & resolve);
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -0,0 +1,219 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_GENERATED_HPP_INCLUDED
+#define PYFFI_OM_GENERATED_HPP_INCLUDED
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/byte_view.hpp"
+#include "pyffi/object_models/expr.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Support for the C++ code written by Scope::generate_cpp. The
+//! generated code reads and writes plain structs through these
+//! functions, which behave exactly like the read plans of the
+//! dynamic object model, but which the compiler can inline.
+namespace generated
+{
+
+//! The slot of a global variable, looked up once.
+class GlobalSlot
+{
+public:
+    //! Constructor.
+    explicit GlobalSlot(char const * name) : slot(Globals::get_slot(name)) {};
+
+    //! Get the value of the variable, zero if it is not set.
+    long long get(Globals const * globals) const {
+        return globals ? globals->get(slot) : 0;
+    };
+
+private:
+    std::size_t slot; //!< The slot.
+};
+
+//! The value of an attribute in an expression, as ExprCode::load.
+template <typename T>
+long long attr_value(T value)
+{
+    return static_cast<long long>(value);
+};
+
+//! The value of a floating point attribute in an expression.
+inline long long attr_value(float value)
+{
+    return ExprCode::truncate(value);
+};
+
+//! The value of a floating point attribute in an expression.
+inline long long attr_value(double value)
+{
+    return ExprCode::truncate(value);
+};
+
+//! Check the length of an array, as Plan::length.
+/*!
+  \param length The evaluated length.
+  \param element_size Size of each element, or zero if unknown.
+*/
+inline std::size_t array_length(long long length, std::size_t element_size)
+{
+    if (length < 0) {
+        throw std::runtime_error("negative array length");
+    };
+    if (element_size && static_cast<unsigned long long>(length)
+        > std::numeric_limits<std::size_t>::max() / element_size) {
+        throw std::runtime_error("array too large");
+    };
+    return static_cast<std::size_t>(length);
+};
+
+//! Check that an array has the length that is written for it.
+inline void check_length(std::size_t size, std::size_t length)
+{
+    if (size != length) {
+        throw std::runtime_error("array size does not match its length");
+    };
+};
+
+//! Read a number.
+template <typename T>
+void read_value(ByteReader & reader, T & value)
+{
+    read_words(reader, &value, sizeof(T), sizeof(T));
+};
+
+//! Write a number.
+template <typename T>
+void write_value(ByteWriter & writer, T const & value)
+{
+    write_words(writer, &value, sizeof(T), sizeof(T));
+};
+
+//! Read an array of numbers, or of packed structs, at once.
+/*!
+  \param reader The input buffer.
+  \param values The array.
+  \param length The number of elements.
+  \param word_size Size of the words whose bytes are swapped, see
+                   Class::get_word_size.
+*/
+template <typename T>
+void read_values(ByteReader & reader, std::vector<T> & values, std::size_t length,
+                 std::size_t word_size)
+{
+    reader.require(length * sizeof(T));
+    values.resize(length);
+    if (length) {
+        read_words(reader, &values[0], length * sizeof(T), word_size);
+    };
+};
+
+//! Read an array of booleans, which std::vector packs into bits.
+inline void read_values(ByteReader & reader, std::vector<bool> & values, std::size_t length,
+                        std::size_t)
+{
+    reader.require(length);
+    values.resize(length);
+    for (std::size_t i = 0; i < length; i++) {
+        bool value;
+        read_value(reader, value);
+        values[i] = value;
+    };
+};
+
+//! Write an array of numbers, or of packed structs, at once.
+template <typename T>
+void write_values(ByteWriter & writer, std::vector<T> const & values, std::size_t word_size)
+{
+    if (!values.empty()) {
+        write_words(writer, &values[0], values.size() * sizeof(T), word_size);
+    };
+};
+
+//! Write an array of booleans, which std::vector packs into bits.
+inline void write_values(ByteWriter & writer, std::vector<bool> const & values,
+                         std::size_t)
+{
+    for (std::size_t i = 0; i < values.size(); i++) {
+        bool value = values[i];
+        write_value(writer, value);
+    };
+};
+
+//! Read a length prefixed string, which refers to the memory of the
+//! reader, as Class::set_sized_string.
+template <typename LengthType>
+void read_sized_string(ByteReader & reader, ByteView & value)
+{
+    LengthType length = 0;
+    read_value(reader, length);
+    std::size_t size = static_cast<std::size_t>(length);
+    value = ByteView(reader.take(size), size);
+};
+
+//! Write a length prefixed string. Throws a runtime error if the
+//! length does not fit the length type.
+template <typename LengthType>
+void write_sized_string(ByteWriter & writer, ByteView const & value)
+{
+    if (value.size() > static_cast<unsigned long long>(std::numeric_limits<LengthType>::max())) {
+        throw std::runtime_error("string too long for its length type");
+    };
+    LengthType length = static_cast<LengthType>(value.size());
+    write_value(writer, length);
+    writer.write(value.data(), value.size());
+};
+
+} // namespace generated
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -42,6 +42,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <boost/optional.hpp>
 #include <vector>
 
+#include "pyffi/object_models/expr.hpp"
 #include "pyffi/object_models/scope.hpp"
 
 namespace pyffi
@@ -50,9 +51,6 @@ namespace pyffi
 namespace object_models
 {
 
-//! An expression (for now, simply defined as a primitive boolean type).
-typedef bool Expr;
-
 //! A simple if declaration: an expression and a scope.
 class If
 {
@@ -38,8 +38,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #ifndef PYFFI_OM_INSTANCE_HPP_INCLUDED
 #define PYFFI_OM_INSTANCE_HPP_INCLUDED
 
-#include <boost/any.hpp>
 #include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/value.hpp"
 
 namespace pyffi
 {
@@ -55,13 +59,38 @@ class Instance
 public:
     //! Instantiate a given class.
     Instance(Class const & class_);
-    //! Copy constructor.
+    //! Instantiate a given class, allocating from an arena. The
+    //! instance must not outlive the arena, but copies of the
+    //! instance reside on the heap.
+    Instance(Class const & class_, Arena & arena);
+    //! Copy constructor, the copy resides on the heap.
     Instance(Instance const & instance);
+    //! Move constructor, the instance remains in the arena of the
+    //! other instance (if any).
+    Instance(Instance && instance) noexcept;
+    //! Copy constructor, the copy resides in the given arena (or on
+    //! the heap if arena is null).
+    Instance(Instance const & instance, Arena * arena);
+    //! Move constructor, the instance moves to the given arena (or
+    //! to the heap if arena is null), copying only if it resides
+    //! elsewhere.
+    Instance(Instance && instance, Arena * arena);
+    //! Instantiate an empty \ref Array "array" of a given class,
+    //! allocating from an arena (or from the heap if arena is null).
+    static Instance array(Class const & class_, Arena * arena);
+    //! Get the class of this instance (of its elements, for arrays).
+    Class const & get_class() const {
+        return *class_;
+    };
+    //! Get the arena of this instance (or null if on the heap).
+    Arena * get_arena() const {
+        return value.get_arena();
+    };
     //! Get reference to value stored in the instance.
     template<typename ValueType> ValueType & get() {
         try {
-            return boost::any_cast<ValueType &>(value);
-        } catch (const boost::bad_any_cast &) {
+            return value_cast<ValueType &>(value);
+        } catch (const bad_value_cast &) {
             throw std::runtime_error(
                 "Type mismatch on value get (required "
                 + std::string(value.type().name()) + " but got "
@@ -71,19 +100,41 @@ public:
     //! Get const reference to value stored in the instance.
     template<typename ValueType> const ValueType & get() const {
         try {
-            return boost::any_cast<const ValueType &>(value);
-        } catch (const boost::bad_any_cast &) {
+            return value_cast<const ValueType &>(value);
+        } catch (const bad_value_cast &) {
             throw std::runtime_error(
                 "Type mismatch on value get (required "
                 + std::string(value.type().name()) + " but got "
                 + std::string(typeid(ValueType).name()) + ").");
         };
     };
+    //! Get reference to value stored in an attribute of the instance.
+    template<typename ValueType> ValueType & get(std::string const & name) {
+        if (is_flat()) {
+            return *static_cast<ValueType *>(
+                       flat_attr_data(name, typeid(ValueType)));
+        } else {
+            return attr(name).get<ValueType>();
+        };
+    };
+    //! Get const reference to value stored in an attribute of the instance.
+    template<typename ValueType> const ValueType & get(std::string const & name) const {
+        if (is_flat()) {
+            return *static_cast<ValueType const *>(
+                       flat_attr_data(name, typeid(ValueType)));
+        } else {
+            return attr(name).get<ValueType>();
+        };
+    };
+    //! Whether all data is stored in one contiguous buffer (see Class::set_flat).
+    bool is_flat() const;
     //! Override assignment operator so type cannot be changed.
     Instance & operator=(const Instance & instance);
+    //! Override move assignment operator so type cannot be changed.
+    Instance & operator=(Instance && instance);
     //! Override assignment operator so type cannot be changed.
     template<typename ValueType> Instance & operator=(const ValueType & value_) {
-        if (value.type() != typeid(value_)) {
+        if (!value.is<ValueType>()) {
             throw std::runtime_error(
                 "Type mismatch on value assignment (required "
                 + std::string(value.type().name()) + " but got "
@@ -96,16 +147,38 @@ public:
     void read(std::istream & is);
     //! Write to stream.
     void write(std::ostream & os) const;
+    //! Read from memory.
+    void read(ByteReader & reader);
+    //! Write to memory.
+    void write(ByteWriter & writer) const;
+    //! Number of bytes that write produces, so the output can be
+    //! allocated at once; conditions are evaluated with the given
+    //! global variables, as when writing with set_globals.
+    std::size_t size(Globals const * globals = 0) const;
     //! Get attribute.
     Instance & attr(std::string const & name);
     //! Get const attribute.
     Instance const & attr(std::string const & name) const;
 
-    Class const & class_; //!< Reference to the class of this instance.
 private:
-    boost::any value; //!< The value (actual data) of this instance.
+    Class const *class_; //!< Pointer to the class of this instance.
+    Value value; //!< The value (actual data) of this instance.
+
+    //! Constructor, for an instance with a value of its own.
+    Instance(Class const & class_, Value && value);
+
+    template<typename ValueType> friend class AttrHandle; // accesses value
+    friend class Plan; // accesses value
+
+    //! Get pointer to the data of a primitive attribute of a flat instance.
+    void * flat_attr_data(std::string const & name, std::type_info const & type);
+    //! Get const pointer to the data of a primitive attribute of a flat instance.
+    void const * flat_attr_data(std::string const & name, std::type_info const & type) const;
 };
 
+//! A vector of \ref Instance "instances", which can reside in an \ref Arena "arena".
+typedef std::vector<Instance, ArenaAllocator<Instance> > InstanceVector;
+
 }
 
 }
@@ -0,0 +1,134 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_INSTANCE_READER_HPP_INCLUDED
+#define PYFFI_OM_INSTANCE_READER_HPP_INCLUDED
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <iosfwd>
+
+#include "pyffi/object_models/arena.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Reads a sequence of top level \ref Instance "instances" from a
+//! stream, one at a time, on demand.
+/*!
+  Each instance is allocated in an \ref Arena "arena" which is
+  released before the next instance is read, so memory use is
+  bounded by the largest instance rather than by the size of the
+  stream. Copy an instance (or move it to another arena) to keep it
+  beyond the next call to next().
+
+  \code
+  InstanceReader reader(is, scope.get_class("Block"));
+  while (reader.next()) {
+      process(reader.get());
+  };
+  \endcode
+*/
+class InstanceReader : boost::noncopyable
+{
+public:
+    //! Selects the class of the next instance, or none at the end of
+    //! the sequence. It may read from the stream, for instance to
+    //! consume a type tag that precedes each instance.
+    typedef boost::function<boost::optional<Class const &>(std::istream &)> Selector;
+
+    //! Constructor, for a sequence of instances of various classes.
+    /*!
+      \param is The input stream.
+      \param select Selects the class of each instance.
+      \param block_size The block size of the arena, see Arena::Arena.
+    */
+    InstanceReader(std::istream & is, Selector const & select, std::size_t block_size = 65536);
+
+    //! Constructor, for a sequence of instances of a single class,
+    //! which ends at the end of the stream.
+    /*!
+      \param is The input stream.
+      \param class_ The class of all instances.
+      \param block_size The block size of the arena, see Arena::Arena.
+    */
+    InstanceReader(std::istream & is, Class const & class_, std::size_t block_size = 65536);
+
+    //! Release the current instance, and read the next one. Throws a
+    //! runtime error if the stream ends within the instance.
+    /*!
+      \return Whether an instance was read; false at the end of the
+              sequence.
+    */
+    bool next();
+
+    //! Get the current instance. Throws a runtime error if there is none.
+    Instance & get();
+
+    //! Release the current instance, and all of its memory, without
+    //! reading the next one.
+    void release();
+
+    //! Number of instances read so far.
+    std::size_t get_count() const {
+        return count;
+    };
+
+    //! Get the arena which holds the current instance.
+    Arena const & get_arena() const {
+        return arena;
+    };
+
+private:
+    std::istream & is;                  //!< The input stream.
+    Selector select;                    //!< Selects the class of each instance.
+    Arena arena;                        //!< Holds the current instance.
+    boost::optional<Instance> instance; //!< The current instance.
+    std::size_t count;                  //!< Number of instances read.
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
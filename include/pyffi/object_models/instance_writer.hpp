@@ -0,0 +1,87 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_INSTANCE_WRITER_HPP_INCLUDED
+#define PYFFI_OM_INSTANCE_WRITER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "pyffi/object_models/endian.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Write a sequence of \ref Instance "instances" into memory. The
+//! size of the output is calculated first (see Instance::size), so
+//! the buffer is allocated once and never grows.
+/*!
+  \param instances The instances.
+  \param endian Byte order of the output.
+  \param globals Global variables for evaluating conditions; may be null.
+  \return The data of all instances, one after the other.
+*/
+std::vector<char> write_buffer(
+    std::vector<Instance> const & instances, Endian endian = Endian::NATIVE,
+    Globals const * globals = 0);
+
+//! Write a sequence of \ref Instance "instances" into a file. The
+//! file is created at its final size (see Instance::size), and
+//! filled through a memory mapping (see MappedOutputFile), so no
+//! stream buffers are involved. The instances are written to a
+//! temporary file next to the file, which replaces the file only once
+//! it is completely written, so if writing throws then an existing
+//! file is kept.
+/*!
+  \param filename The name of the file.
+  \param instances The instances.
+  \param endian Byte order of the output.
+  \param globals Global variables for evaluating conditions; may be null.
+*/
+void write_file(
+    std::string const & filename, std::vector<Instance> const & instances,
+    Endian endian = Endian::NATIVE, Globals const * globals = 0);
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
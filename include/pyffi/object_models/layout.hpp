@@ -0,0 +1,105 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_LAYOUT_HPP_INCLUDED
+#define PYFFI_OM_LAYOUT_HPP_INCLUDED
+
+#include <algorithm> // std::max
+#include <cstddef>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A layout describes how the value of a fixed size class is stored
+//! in memory: its size and its alignment, both in bytes.
+class Layout
+{
+public:
+    //! Default constructor, an empty layout.
+    Layout() : size(0), alignment(1) {};
+    //! Constructor.
+    Layout(std::size_t size, std::size_t alignment)
+        : size(size), alignment(alignment) {};
+
+    std::size_t size;      //!< Size in bytes.
+    std::size_t alignment; //!< Alignment in bytes.
+
+    //! Append a member, padding for its alignment.
+    /*!
+      \param member The layout of the member.
+      \return The offset of the member.
+    */
+    std::size_t append(Layout const & member) {
+        std::size_t offset = align(size, member.alignment);
+        size = offset + member.size;
+        alignment = std::max(alignment, member.alignment);
+        return offset;
+    };
+
+    //! Pad the size to a multiple of the alignment, so that values
+    //! can be stored one after the other.
+    void pad() {
+        size = align(size, alignment);
+    };
+
+    //! Equality operator.
+    bool operator==(Layout const & other) const {
+        return
+            (size == other.size) &&
+            (alignment == other.alignment);
+    };
+
+    //! Inequality operator.
+    bool operator!=(Layout const & other) const {
+        return !(*this == other);
+    };
+
+private:
+    //! Round offset up to a multiple of alignment.
+    static std::size_t align(std::size_t offset, std::size_t alignment) {
+        return ((offset + alignment - 1) / alignment) * alignment;
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
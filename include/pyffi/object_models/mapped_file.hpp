@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_MAPPED_FILE_HPP_INCLUDED
+#define PYFFI_OM_MAPPED_FILE_HPP_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <string>
+
+#include "pyffi/object_models/byte_stream.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A file which is mapped read-only into memory, so \ref Instance
+//! "instances" can be read directly from the page cache through a
+//! \ref ByteReader "reader", without copying the file into a stream
+//! buffer first.
+class MappedFile : boost::noncopyable
+{
+public:
+    //! Map a file. Throws a runtime error if the file cannot be
+    //! opened or mapped.
+    /*!
+      \param filename The name of the file.
+      \param sequential Whether the file will be read from start to
+                        end, so the system can read ahead aggressively
+                        and drop pages that have been read.
+    */
+    explicit MappedFile(std::string const & filename, bool sequential = true);
+
+    //! Destructor, unmaps the file.
+    ~MappedFile();
+
+    //! Start of the mapped memory (null if the file is empty).
+    char const * data() const {
+        return begin;
+    };
+
+    //! Size of the file, in bytes.
+    std::size_t size() const {
+        return size_;
+    };
+
+    //! Get a reader for the whole file.
+    ByteReader reader() const {
+        return ByteReader(begin, size_);
+    };
+
+private:
+    char const *begin;  //!< Start of the mapped memory.
+    std::size_t size_;  //!< Size of the mapped memory.
+};
+
+//! A file which is created at a given size, and mapped into memory
+//! for writing, so \ref Instance "instances" can be written directly
+//! into the page cache through a \ref ByteWriter "writer", without
+//! going through a stream buffer.
+class MappedOutputFile : boost::noncopyable
+{
+public:
+    //! Create (or truncate) a file of the given size, and map it.
+    //! Throws a runtime error if the file cannot be created or mapped.
+    /*!
+      \param filename The name of the file.
+      \param size Size of the file, in bytes.
+    */
+    MappedOutputFile(std::string const & filename, std::size_t size);
+
+    //! Destructor, unmaps the file if it is still mapped; the system
+    //! writes it back, but write errors go unnoticed, so call close
+    //! first.
+    ~MappedOutputFile();
+
+    //! Write the mapped memory back to the file and wait for it,
+    //! then unmap it. Throws a runtime error if the system reports a
+    //! write error.
+    void close();
+
+    //! Start of the mapped memory (null if the file is empty).
+    char * data() const {
+        return begin;
+    };
+
+    //! Size of the file, in bytes.
+    std::size_t size() const {
+        return size_;
+    };
+
+    //! Get a writer for the whole file.
+    ByteWriter writer() const {
+        return ByteWriter(begin, size_);
+    };
+
+private:
+    std::string filename;   //!< Name of the file, for errors.
+    char *begin;            //!< Start of the mapped memory.
+    std::size_t size_;      //!< Size of the mapped memory.
+};
+
+//! Get a unique name for a temporary file next to the given file, so
+//! it can be renamed over the given file once it is complete.
+/*!
+  \param filename The name of the file.
+  \return The name of the temporary file.
+*/
+std::string temp_filename(std::string const & filename);
+
+//! Rename a complete temporary file over the given file, so readers
+//! see either the old or the new file. The temporary file is removed
+//! if it cannot be renamed.
+/*!
+  \param temp The name of the temporary file.
+  \param filename The name of the file.
+  \return Whether the file was replaced.
+*/
+bool replace_file(std::string const & temp, std::string const & filename);
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
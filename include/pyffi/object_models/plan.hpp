@@ -0,0 +1,160 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_PLAN_HPP_INCLUDED
+#define PYFFI_OM_PLAN_HPP_INCLUDED
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/expr.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A single instruction of a \ref Plan "plan".
+class PlanOp
+{
+public:
+    //! The kind of instruction.
+    enum Code {
+        READ,   //!< Read or write size bytes of the primitive attribute at index.
+        RUN,    //!< Read or write the READ instructions up to target as one block of size bytes.
+        CLASS,  //!< Read or write the attribute at index through its class.
+        ARRAY,  //!< Read or write the array at index, with expr elements of size bytes.
+        BRANCH, //!< Continue at target if expr evaluates to zero.
+        JUMP    //!< Continue at target.
+    };
+
+    //! Constructor.
+    PlanOp(Code code, std::size_t index = 0, std::size_t size = 0, std::size_t word_size = 1)
+        : code(code), index(index), size(size), word_size(word_size), target(0), expr() {};
+
+    Code code;          //!< The kind of instruction.
+    std::size_t index;  //!< Index of the attribute.
+    //! Number of bytes, for READ and RUN, and per element for ARRAY:
+    //! the least number if the elements are not packed, see
+    //! Class::get_min_size.
+    std::size_t size;
+    //! Size of the words to swap in a foreign byte order, for READ,
+    //! RUN and ARRAY: 1 if none, and 0 for a RUN of mixed word sizes,
+    //! or for an ARRAY whose elements are not packed (see
+    //! Class::is_packed), and so are read one by one.
+    std::size_t word_size;
+    std::size_t target; //!< Next instruction, for RUN, BRANCH and JUMP.
+    ExprCode expr;      //!< Compiled condition for BRANCH, and length for ARRAY.
+
+    //! Equality operator.
+    bool operator==(PlanOp const & other) const {
+        return
+            (code == other.code) &&
+            (index == other.index) &&
+            (size == other.size) &&
+            (word_size == other.word_size) &&
+            (target == other.target) &&
+            (expr == other.expr);
+    };
+
+    //! Inequality operator.
+    bool operator!=(PlanOp const & other) const {
+        return !(*this == other);
+    };
+};
+
+//! A read plan lists the instructions to read or write all attributes
+//! of a \ref Class "class", including those of its base classes and
+//! of its if/elif/else declarations, in order. It is created by
+//! Scope::compile, and executed in a single loop, without visiting
+//! the declarations.
+/*!
+  Consecutive primitive attributes are preceded by a RUN instruction,
+  so their bytes are fetched from the stream in a single call, and
+  then copied into the attributes. RUN can always be skipped: its
+  READ instructions also work on their own.
+
+  The elements of an ARRAY of a packed class are read in a single
+  call as well, directly into the storage of the \ref Array "array".
+*/
+class Plan : public std::vector<PlanOp>
+{
+public:
+    //! Default constructor.
+    Plan() : std::vector<PlanOp>() {};
+
+    //! Read the attribute instances from a stream. Conditions are
+    //! evaluated with the global variables of the stream, see
+    //! set_globals.
+    void read(InstanceVector & instances, std::istream & is) const;
+
+    //! Write the attribute instances to a stream.
+    void write(InstanceVector const & instances, std::ostream & os) const;
+
+    //! Read the attribute instances from memory.
+    void read(InstanceVector & instances, ByteReader & reader) const;
+
+    //! Write the attribute instances to memory.
+    void write(InstanceVector const & instances, ByteWriter & writer) const;
+
+    //! Number of bytes that write produces, for the given global
+    //! variables.
+    std::size_t write_size(InstanceVector const & instances, Globals const * globals = 0) const;
+
+private:
+    template <typename Reader>
+    void read_impl(InstanceVector & instances, Reader & reader) const;
+
+    template <typename Writer>
+    void write_impl(InstanceVector const & instances, Writer & writer) const;
+
+    //! Evaluate the condition of a BRANCH.
+    bool test(PlanOp const & op, InstanceVector const & instances, Globals const * globals) const;
+
+    //! Evaluate the length of an ARRAY.
+    std::size_t length(PlanOp const & op, InstanceVector const & instances, Globals const * globals) const;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -0,0 +1,123 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_PREFETCH_BUFFER_HPP_INCLUDED
+#define PYFFI_OM_PREFETCH_BUFFER_HPP_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A stream buffer which reads ahead from another stream buffer in a
+//! background thread, so input overlaps with decoding.
+/*!
+  The source is read in chunks of a fixed size. While the decoder
+  consumes one chunk, the background thread fills up to depth further
+  chunks. Errors of the source are passed on to the reading stream
+  (which sets its badbit). Only telling the position is supported,
+  not seeking.
+
+  \code
+  std::ifstream file("large.nif", std::ios::binary);
+  PrefetchBuffer buffer(*file.rdbuf());
+  std::istream is(&buffer);
+  instance.read(is);
+  \endcode
+
+  The source must not be used by anything else while the buffer
+  exists.
+*/
+class PrefetchBuffer : public std::streambuf, boost::noncopyable
+{
+public:
+    //! Constructor, starts the background thread.
+    /*!
+      \param source The stream buffer to read from.
+      \param chunk_size Number of bytes read from the source at once.
+      \param depth Number of chunks to read ahead; 1 gives classic
+                   double buffering.
+    */
+    explicit PrefetchBuffer(std::streambuf & source,
+                            std::size_t chunk_size = 1 << 20,
+                            std::size_t depth = 2);
+
+    //! Destructor, stops the background thread.
+    ~PrefetchBuffer();
+
+protected:
+    //! Switch to the next chunk, waiting for it if necessary.
+    int_type underflow();
+
+    //! Tell the position, as the number of bytes consumed.
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which = std::ios_base::in);
+
+private:
+    std::streambuf & source;         //!< The source.
+    std::vector<std::vector<char> > chunks; //!< Ring of chunks.
+    std::vector<std::size_t> sizes;  //!< Number of bytes in each chunk.
+    std::size_t first;               //!< Index of the oldest ready chunk.
+    std::size_t num_ready;           //!< Number of ready chunks, including the current one.
+    bool current;                    //!< Whether the get area is the oldest ready chunk.
+    bool done;                       //!< Whether the source is exhausted.
+    bool stop;                       //!< Whether the thread must stop.
+    std::exception_ptr error;        //!< Error of the source, if any.
+    std::streamoff consumed;         //!< Bytes in released chunks.
+    std::mutex mutex;                //!< Protects all of the above.
+    std::condition_variable changed; //!< Signals chunks filled or released.
+    std::thread thread;              //!< The background thread.
+
+    //! Body of the background thread.
+    void run();
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
@@ -38,11 +38,15 @@ POSSIBILITY OF SUCH DAMAGE.
 #ifndef PYFFI_OM_SCOPE_HPP_INCLUDED
 #define PYFFI_OM_SCOPE_HPP_INCLUDED
 
-#include <boost/any.hpp>
 #include <boost/unordered_map.hpp> // for LocalClassMap
 #include <boost/variant.hpp>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+#include "pyffi/object_models/instance.hpp"
+#include "pyffi/object_models/symbol.hpp"
+
 namespace pyffi
 {
 
@@ -53,8 +57,11 @@ namespace object_models
 class Attr; // full declaration included later
 class AttrMap;
 class Class; // full declaration included later
+class class_layout_compiler;
+class class_plan_compiler;
+struct EmbeddedSchema;
+class Globals;
 class IfElifsElse; // full declaration included later
-class Instance;
 
 //! A declaration: a \ref Class "class", \ref Attr "attribute", or \ref IfElifsElse "if/elif/.../else".
 typedef boost::make_recursive_variant<Class, Attr, IfElifsElse>::type Declaration;
@@ -64,12 +71,16 @@ class Scope : public std::vector<Declaration>
 {
 public:
     //! Constructor.
-    Scope() : std::vector<Declaration>(), local_class_map(), parent_scope() {};
+    Scope()
+        : std::vector<Declaration>(), versions(), local_class_map(),
+          class_map(), classes(), parent_scope() {};
 
     //! Convert format description to abstract syntax tree.
     bool parse(std::istream & in);
 
-    //! Convert xml format description to abstract syntax tree.
+    //! Convert xml format description to abstract syntax tree. The
+    //! version ranges of the format compare against the global
+    //! variable Version, which no attribute can hide.
     bool parse_xml(std::istream & in);
 
     //! Fix all names (CamelCase for classes
@@ -80,9 +91,65 @@ public:
     //! Convert abstract syntax tree to format description.
     bool generate(std::ostream & out) const;
 
+    //! Convert compiled scope to C++: a struct for every class, with
+    //! base classes as inheritance, and functions for reading and
+    //! writing them, in the given namespace. Primitive types and
+    //! strings (see Class::set_type and Class::set_sized_string)
+    //! become typedefs. The functions read and write exactly as the
+    //! read plans do, but without any indirection, so the compiler
+    //! can inline them. Throws a runtime error if a class has no C++
+    //! equivalent.
+    bool generate_cpp(std::ostream & out, std::string const & namespace_name) const;
+
+    //! Convert abstract syntax tree to a binary cache, which read_cache
+    //! converts back much faster than parse_xml parses the format
+    //! description. The cache has no pointers, so it can be mapped
+    //! anywhere, and it is tagged with the format version of the cache
+    //! and with a hash of the format description (see hash_source).
+    void write_cache(std::ostream & out, std::uint64_t source_hash) const;
+
+    //! Convert binary cache, as written by write_cache, to abstract
+    //! syntax tree. Returns false, leaving the scope unchanged, if the
+    //! cache has another format version or source hash, so it must be
+    //! parsed again. Throws a runtime error if the cache is corrupt.
+    bool read_cache(void const * data, std::size_t size, std::uint64_t source_hash);
+
+    //! Convert embedded schema to abstract syntax tree, as read_cache:
+    //! the scope must still be compiled.
+    bool read_cache(EmbeddedSchema const & schema);
+
+    //! Hash of a format description, for invalidating caches.
+    static std::uint64_t hash_source(std::string const & text);
+
+    //! Convert xml format description to abstract syntax tree, as
+    //! parse_xml, through a cache file: the file is read if it is up
+    //! to date, and written otherwise.
+    /*!
+      \param in The xml format description.
+      \param cache_filename The name of the cache file.
+    */
+    bool parse_xml_cached(std::istream & in, std::string const & cache_filename);
+
     //! Compile everything (only to be called on a top-level scope).
     void compile();
 
+    //! Compile read plans specialized for the given global variables,
+    //! such as a file version, after compile: conditions on these
+    //! variables are decided once, here, instead of on every read.
+    //! Instances use these plans when they are read or written with
+    //! exactly the same global variables (see set_globals).
+    /*!
+      Specialized plans are kept alongside each other, so files of a
+      few common versions can all be read with their own plan. Must
+      not be called while instances of the classes are read or
+      written.
+    */
+    void compile(Globals const & constants);
+
+    //! File versions listed by the format description, as numbers
+    //! (see parse_xml); not part of the syntax tree.
+    std::vector<long long> versions;
+
     //! Get locally defined class by name.
     Class const & get_local_class(std::string const & class_name) const;
 
@@ -92,14 +159,27 @@ public:
     //! Get class by name (also inspecting parent scopes).
     Class const & get_class(std::string const & class_name) const;
 
-    //! Instantiate and append all attributes.
-    void init(std::vector<Instance> & instances) const;
+    //! Get class by interned name (also inspecting parent scopes).
+    Class const & get_class(Symbol const & symbol) const;
+
+    //! Get class by id, see Class::get_id (only on a top-level scope).
+    Class const & get_class(std::size_t id) const;
+
+    //! Number of classes, including nested ones (only on a top-level
+    //! scope).
+    std::size_t get_num_classes() const {
+        return classes.size();
+    };
+
+    //! Instantiate and append all attributes which are not yet
+    //! instantiated, in the arena of the instances (if any).
+    void init(InstanceVector & instances) const;
 
     //! Read all attributes.
-    void read(std::vector<Instance> & instances, std::istream & is) const;
+    void read(InstanceVector & instances, std::istream & is) const;
 
     //! Write all attributes.
-    void write(std::vector<Instance> & instances, std::ostream & os) const;
+    void write(InstanceVector & instances, std::ostream & os) const;
 
     //! Equality operator.
     bool operator==(Scope const & other) const;
@@ -111,26 +191,51 @@ public:
 
 private:
     //! Type of local_class_map.
-    typedef boost::unordered_map<std::string, Class const *> LocalClassMap;
+    typedef boost::unordered_map<Symbol, Class const *> LocalClassMap;
 
     //! Map local class names to classes.
     LocalClassMap local_class_map;
 
+    //! Map class names to classes, as resolved while compiling, so
+    //! every name is looked up in the parent scopes only once.
+    LocalClassMap class_map;
+
+    //! All classes by id, including nested ones (only for a top-level
+    //! scope).
+    std::vector<Class const *> classes;
+
     //! The parent scope in the syntax tree hierarchy.
-    Scope const *parent_scope;
+    Scope *parent_scope;
+
+    //! Get class by interned name, as get_class, and remember it.
+    Class const & resolve_class(Symbol const & symbol);
 
-    //! Compile the local class maps (lcm) and parent scopes (ps).
-    void compile_lcm_ps();
+    //! Compile the local class maps (lcm) and parent scopes (ps), and
+    //! number all classes.
+    void compile_lcm_ps(std::vector<Class const *> & classes);
 
     //! Compile the class of every attribute (a) and every base class (bc).
     void compile_a_bc(AttrMap & attr_map);
 
+    //! Freeze (f) the attribute map of every class.
+    void compile_f();
+
+    //! Compile the layout (l) of every class of fixed size, and the
+    //! offset (o) of every attribute of such class.
+    void compile_l_o(class_layout_compiler & compiler);
+
+    //! Compile the read plan (p) of every class.
+    void compile_p(class_plan_compiler & compiler);
+
     // The next three methods are helper functions for class_init,
     // class_read, and class_write. Therefore their implementation
     // resides in ast_class.cpp.
 
     friend class declaration_compile_lcm_ps_visitor; // part of implementation of compile_lcm_ps
     friend class declaration_compile_a_bc_visitor; // part of implementation of compile_a_bc
+    friend class declaration_compile_f_visitor; // part of implementation of compile_f
+    friend class declaration_compile_l_o_visitor; // part of implementation of compile_l_o
+    friend class declaration_compile_p_visitor; // part of implementation of compile_p
 };
 
 } // namespace object_models
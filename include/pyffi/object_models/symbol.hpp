@@ -0,0 +1,112 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_SYMBOL_HPP_INCLUDED
+#define PYFFI_OM_SYMBOL_HPP_INCLUDED
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <string>
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! An interned name. Every distinct name is stored once, in a table
+//! which is shared by all scopes, and gets a small integer id, so
+//! symbols are copied, compared and hashed as integers. Class and
+//! attribute names are interned when the scope is compiled.
+class Symbol
+{
+public:
+    //! Default constructor, the empty name (whose id is zero).
+    Symbol();
+
+    //! Constructor, interns the name: the same name always gets the
+    //! same id.
+    explicit Symbol(std::string const & name);
+
+    //! Get the symbol of a name, without interning it: none if the
+    //! name was never interned, so nothing is declared by that name.
+    //! Takes no lock, so lookups by name scale across threads.
+    static boost::optional<Symbol> find(std::string const & name);
+
+    //! Get the id.
+    std::size_t get_id() const {
+        return id;
+    };
+
+    //! Get the name.
+    std::string const & str() const {
+        return *name;
+    };
+
+    //! Equality operator.
+    bool operator==(Symbol const & other) const {
+        return id == other.id;
+    };
+
+    //! Inequality operator.
+    bool operator!=(Symbol const & other) const {
+        return id != other.id;
+    };
+
+    //! Order by id, which is the order of interning.
+    bool operator<(Symbol const & other) const {
+        return id < other.id;
+    };
+
+    //! Hash, so symbols can be used as keys of unordered maps.
+    friend std::size_t hash_value(Symbol const & symbol) {
+        return symbol.id;
+    };
+
+private:
+    std::size_t id;          //!< Index in the table.
+    std::string const *name; //!< The name, owned by the table.
+
+    //! Constructor, for a symbol of the table.
+    Symbol(std::size_t id, std::string const * name) : id(id), name(name) {};
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
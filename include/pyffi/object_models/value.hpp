@@ -0,0 +1,374 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef PYFFI_OM_VALUE_HPP_INCLUDED
+#define PYFFI_OM_VALUE_HPP_INCLUDED
+
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+#include <new>
+#include <type_traits> // std::is_constructible
+#include <typeinfo>
+#include <utility> // std::forward
+
+#include "pyffi/object_models/arena.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Exception thrown when a \ref Value "value" does not hold the
+//! requested type.
+class bad_value_cast : public std::bad_cast
+{
+public:
+    virtual const char * what() const throw() {
+        return "pyffi::object_models::bad_value_cast: "
+               "failed conversion using pyffi::object_models::value_cast";
+    };
+};
+
+//! Holds a value of any type, much like boost::any, except that the
+//! value can be allocated from an \ref Arena "arena".
+/*!
+  Small plain old data values, such as those of primitive classes,
+  are stored inline, so they never allocate. Other values in an arena
+  are never freed individually, and they stay in the arena when they
+  are assigned to. Copies of a value always reside on the heap.
+*/
+class Value
+{
+public:
+    //! Maximal size of values that are stored inline.
+    static const std::size_t inline_size = 16;
+
+    //! Default constructor, an empty value on the heap.
+    Value() : tag(0), arena(0) {};
+    //! Constructor, an empty value in the given arena (or on the heap
+    //! if arena is null).
+    explicit Value(Arena * arena) : tag(0), arena(arena) {};
+    //! Constructor, a copy of the given value in the given arena (or
+    //! on the heap if arena is null).
+    template<typename ValueType>
+    Value(ValueType const & value, Arena * arena) : tag(0), arena(arena) {
+        emplace<ValueType>(value);
+    };
+    //! Copy constructor, the copy resides on the heap.
+    Value(Value const & other);
+    //! Copy constructor, the copy resides in the given arena (or on
+    //! the heap if arena is null), and so does all its content.
+    Value(Value const & other, Arena * arena);
+    //! Move constructor, the value remains in the arena of other.
+    Value(Value && other) noexcept
+        : tag(other.tag), storage(other.storage), arena(other.arena) {
+        other.tag = 0;
+    };
+    //! Move constructor, the value moves to the given arena (or to
+    //! the heap if arena is null), copying only if it resides elsewhere.
+    Value(Value && other, Arena * arena);
+    //! Destructor.
+    ~Value() {
+        clear();
+    };
+
+    //! Assignment, keeping this value's arena.
+    Value & operator=(Value const & other);
+    //! Move assignment, keeping this value's arena.
+    Value & operator=(Value && other);
+    //! Assignment, keeping this value's arena.
+    template<typename ValueType> Value & operator=(ValueType const & value) {
+        if (is<ValueType>()) {
+            *handler<ValueType>::get(*this) = value;
+        } else {
+            emplace<ValueType>(value);
+        };
+        return *this;
+    };
+
+    //! Construct a new value of the given type in place, with the
+    //! given constructor arguments.
+    template<typename ValueType, typename... Args>
+    ValueType & emplace(Args &&... args) {
+        return handler<ValueType>::create(*this, std::forward<Args>(args)...);
+    };
+
+    //! Whether the value is empty.
+    bool empty() const {
+        return !tag;
+    };
+
+    //! Whether the value holds the given type. Unlike comparing
+    //! type(), this is a single pointer comparison.
+    template<typename ValueType> bool is() const {
+        return tag == &handler<ValueType>::tag;
+    };
+
+    //! Whether the value is stored inline, without allocation.
+    bool is_inline() const {
+        return tag && tag->is_inline;
+    };
+
+    //! Pointer to the held value, or null if empty.
+    void * data() {
+        return tag ? (tag->is_inline ? &storage.buffer : storage.pointer) : 0;
+    };
+
+    //! Const pointer to the held value, or null if empty.
+    void const * data() const {
+        return const_cast<Value *>(this)->data();
+    };
+
+    //! Type of the value, typeid(void) if empty.
+    std::type_info const & type() const {
+        return tag ? tag->type() : typeid(void);
+    };
+
+    //! Get the arena (or null if allocating from the heap).
+    Arena * get_arena() const {
+        return arena;
+    };
+
+private:
+    //! Operations on held values of a particular type. There is
+    //! exactly one tag per type, so its address identifies the type.
+    struct Tag {
+        //! Type of the held value.
+        std::type_info const & (*type)();
+        //! Whether the held value is stored inline.
+        bool is_inline;
+        //! Copy the held value of source into an empty target.
+        void (*copy)(Value & target, Value const & source);
+        //! Assign the held value of source to that of target, which
+        //! must hold the same type.
+        void (*assign)(Value & target, Value const & source);
+        //! Destroy the held value.
+        void (*destroy)(Value & value);
+    };
+
+    //! Storage for the held value: inline, or a pointer to it.
+    union Storage {
+        void *pointer;
+        boost::aligned_storage<inline_size>::type buffer;
+    };
+
+    //! Whether values of the given type are stored inline.
+    template<typename ValueType>
+    struct fits_inline {
+        static const bool value =
+            (sizeof(ValueType) <= inline_size)
+            && (boost::alignment_of<Storage>::value
+                % boost::alignment_of<ValueType>::value == 0)
+            && boost::is_pod<ValueType>::value;
+    };
+
+    //! Implementation of the operations for a particular type.
+    template<typename ValueType, bool = fits_inline<ValueType>::value>
+    struct handler;
+
+    Tag const *tag;  //!< Operations on the held value, or null if empty.
+    Storage storage; //!< The held value.
+    Arena *arena;    //!< The arena, or null.
+
+    //! Destroy the held value.
+    void clear() {
+        if (tag) {
+            tag->destroy(*this);
+            tag = 0;
+        };
+    };
+
+    template<typename ValueType>
+    friend ValueType * value_cast(Value * operand);
+};
+
+//! Implementation for values that are stored inline.
+template<typename ValueType>
+struct Value::handler<ValueType, true> {
+    static ValueType * get(Value & value) {
+        return reinterpret_cast<ValueType *>(&value.storage.buffer);
+    };
+    static ValueType const * get(Value const & value) {
+        return reinterpret_cast<ValueType const *>(&value.storage.buffer);
+    };
+    template<typename... Args>
+    static ValueType & create(Value & value, Args &&... args) {
+        // arguments may refer to the current value, so construct first
+        ValueType held(std::forward<Args>(args)...);
+        value.clear();
+        value.tag = &tag;
+        return *new(&value.storage.buffer) ValueType(held);
+    };
+    static std::type_info const & type() {
+        return typeid(ValueType);
+    };
+    static void copy(Value & target, Value const & source) {
+        new(&target.storage.buffer) ValueType(*get(source));
+        target.tag = &tag;
+    };
+    static void assign(Value & target, Value const & source) {
+        *get(target) = *get(source);
+    };
+    static void destroy(Value &) {};
+    static const Tag tag;
+};
+
+template<typename ValueType>
+const Value::Tag Value::handler<ValueType, true>::tag = {
+    &type, true, &copy, &assign, &destroy
+};
+
+//! Implementation for values that are allocated, from the arena if
+//! there is one, or else from the heap.
+template<typename ValueType>
+struct Value::handler<ValueType, false> {
+    static ValueType * get(Value & value) {
+        return static_cast<ValueType *>(value.storage.pointer);
+    };
+    static ValueType const * get(Value const & value) {
+        return static_cast<ValueType const *>(value.storage.pointer);
+    };
+    //! Copy a value, passing the arena to containers with an arena
+    //! allocator, so their content resides in the same arena.
+    static ValueType * allocate_copy(Arena * arena, ValueType const & value) {
+        return allocate_copy(
+                   arena, value,
+                   std::is_constructible<ValueType, ValueType const &, ArenaAllocator<char> >());
+    };
+    static ValueType * allocate_copy(Arena * arena, ValueType const & value, std::true_type) {
+        return allocate(arena, value, ArenaAllocator<char>(arena));
+    };
+    static ValueType * allocate_copy(Arena * arena, ValueType const & value, std::false_type) {
+        return allocate(arena, value);
+    };
+    template<typename... Args>
+    static ValueType * allocate(Arena * arena, Args &&... args) {
+        if (arena) {
+            return new(arena->allocate(
+                           sizeof(ValueType),
+                           boost::alignment_of<ValueType>::value))
+                   ValueType(std::forward<Args>(args)...);
+        } else {
+            return new ValueType(std::forward<Args>(args)...);
+        };
+    };
+    template<typename... Args>
+    static ValueType & create(Value & value, Args &&... args) {
+        ValueType *held = allocate(value.arena, std::forward<Args>(args)...);
+        value.clear();
+        value.storage.pointer = held;
+        value.tag = &tag;
+        return *held;
+    };
+    static std::type_info const & type() {
+        return typeid(ValueType);
+    };
+    static void copy(Value & target, Value const & source) {
+        target.storage.pointer = allocate_copy(target.arena, *get(source));
+        target.tag = &tag;
+    };
+    static void assign(Value & target, Value const & source) {
+        *get(target) = *get(source);
+    };
+    static void destroy(Value & value) {
+        if (value.arena) {
+            // memory is reclaimed when the arena is released
+            get(value)->~ValueType();
+        } else {
+            delete get(value);
+        };
+    };
+    static const Tag tag;
+};
+
+template<typename ValueType>
+const Value::Tag Value::handler<ValueType, false>::tag = {
+    &type, false, &copy, &assign, &destroy
+};
+
+//! Get pointer to the held value, or null if the value does not hold
+//! the given type.
+template<typename ValueType>
+ValueType * value_cast(Value * operand)
+{
+    if (operand && operand->is<ValueType>()) {
+        return Value::handler<ValueType>::get(*operand);
+    } else {
+        return 0;
+    };
+};
+
+//! Get const pointer to the held value, or null if the value does
+//! not hold the given type.
+template<typename ValueType>
+ValueType const * value_cast(Value const * operand)
+{
+    return value_cast<ValueType>(const_cast<Value *>(operand));
+};
+
+//! Get the held value; throws bad_value_cast if the value does not
+//! hold the given type. Use a reference type to avoid a copy.
+template<typename ValueType>
+ValueType value_cast(Value & operand)
+{
+    typedef typename boost::remove_reference<ValueType>::type nonref;
+    typedef typename boost::remove_const<nonref>::type nonconst;
+    nonconst *result = value_cast<nonconst>(&operand);
+    if (!result) {
+        throw bad_value_cast();
+    };
+    return *result;
+};
+
+//! Get the held value; throws bad_value_cast if the value does not
+//! hold the given type. Use a const reference type to avoid a copy.
+template<typename ValueType>
+ValueType value_cast(Value const & operand)
+{
+    typedef typename boost::remove_reference<ValueType>::type nonref;
+    return value_cast<nonref const &>(const_cast<Value &>(operand));
+};
+
+} // namespace object_models
+
+} // namespace pyffi
+
+#endif
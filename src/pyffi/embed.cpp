@@ -0,0 +1,98 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+// pyffi_embed: convert a format description into a C++ header and
+// source which embed its schema cache (see
+// pyffi::object_models::EmbeddedSchema).
+//
+// usage: pyffi_embed <format.xml|format.ffi> <name> <header> <source>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/embedded_schema.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using namespace pyffi::object_models;
+
+//! Check whether a string ends with a suffix.
+static bool ends_with(std::string const & str, std::string const & suffix)
+{
+    return str.size() >= suffix.size()
+           && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+};
+
+int main(int argc, char ** argv)
+{
+    if (argc != 5) {
+        std::cerr << "usage: pyffi_embed <format.xml|format.ffi> <name> <header> <source>" << std::endl;
+        return 2;
+    };
+    std::string const input_filename = argv[1];
+    std::string const name = argv[2];
+    std::string const header_filename = argv[3];
+    std::string const source_filename = argv[4];
+    try {
+        std::ifstream input(input_filename.c_str(), std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("cannot open '" + input_filename + "'");
+        };
+        std::string const text(
+            (std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        Scope scope;
+        std::istringstream is(text);
+        if (!(ends_with(input_filename, ".xml") ? scope.parse_xml(is) : scope.parse(is))) {
+            throw std::runtime_error("cannot parse '" + input_filename + "'");
+        };
+        std::ofstream header(header_filename.c_str());
+        std::ofstream source(source_filename.c_str());
+        write_embedded_schema(
+            scope, Scope::hash_source(text), name,
+            header_filename.substr(header_filename.find_last_of("/\\") + 1),
+            header, source);
+        if (!header.good() || !source.good()) {
+            throw std::runtime_error("cannot write '" + header_filename + "' or '" + source_filename + "'");
+        };
+    } catch (std::exception const & e) {
+        std::cerr << "pyffi_embed: " << e.what() << std::endl;
+        return 1;
+    };
+    return 0;
+};
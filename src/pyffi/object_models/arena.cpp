@@ -0,0 +1,113 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm> // std::max
+#include <boost/foreach.hpp>
+
+#include "pyffi/object_models/arena.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Round pointer up to a multiple of alignment.
+static char * align(char * position, std::size_t alignment)
+{
+    std::size_t address = reinterpret_cast<std::size_t>(position);
+    return position + ((alignment - address % alignment) % alignment);
+};
+
+Arena::Arena(std::size_t block_size)
+    : block_size(block_size), blocks(), position(0), end(0) {};
+
+Arena::~Arena()
+{
+    BOOST_FOREACH(Block & block, blocks) {
+        delete[] block.first;
+    };
+};
+
+void * Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    char *result = align(position, alignment);
+    // aligning may pass the end of the block
+    if (!position || result > end || size > static_cast<std::size_t>(end - result)) {
+        // reserve room for alignment in the next block
+        next_block(size + alignment - 1);
+        result = align(position, alignment);
+    };
+    position = result + size;
+    return result;
+};
+
+void Arena::next_block(std::size_t size)
+{
+    if (!position && !blocks.empty() && blocks.front().second >= size) {
+        // reuse the block that was kept on release
+        position = blocks.front().first;
+        end = position + blocks.front().second;
+        return;
+    };
+    Block block(new char[std::max(block_size, size)], std::max(block_size, size));
+    blocks.push_back(block);
+    position = block.first;
+    end = block.first + block.second;
+};
+
+void Arena::release()
+{
+    // keep the first block for reuse
+    if (!blocks.empty()) {
+        for (std::size_t i = 1; i < blocks.size(); i++) {
+            delete[] blocks[i].first;
+        };
+        blocks.resize(1);
+    };
+    position = 0;
+    end = 0;
+};
+
+std::size_t Arena::get_num_blocks() const
+{
+    return blocks.size();
+};
+
+} // namespace object_models
+
+} // namespace pyffi
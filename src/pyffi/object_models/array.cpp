@@ -0,0 +1,156 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cstring> // std::memset
+
+#include "pyffi/object_models/array.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+Array::Array(Class const & class_, Arena * arena)
+    : class_(&class_), packed(class_.is_packed()), length(0),
+      element_size(packed ? class_.get_layout().get().size : 0),
+      words(ArenaAllocator<long long>(arena)),
+      instances(ArenaAllocator<Instance>(arena)) {};
+
+Array::Array(Array const & other)
+    : class_(other.class_), packed(other.packed), length(other.length),
+      element_size(other.element_size), words(other.words),
+      instances(other.instances) {};
+
+Array::Array(Array const & other, ArenaAllocator<char> const & allocator)
+    : class_(other.class_), packed(other.packed), length(other.length),
+      element_size(other.element_size),
+      words(other.words, ArenaAllocator<long long>(allocator)),
+      instances(other.instances, ArenaAllocator<Instance>(allocator)) {};
+
+Array::Array(Array && other) noexcept
+    : class_(other.class_), packed(other.packed), length(other.length),
+      element_size(other.element_size), words(std::move(other.words)),
+      instances(std::move(other.instances))
+{
+    other.length = 0;
+};
+
+Array & Array::operator=(Array const & other)
+{
+    if (class_ != other.class_)
+        throw std::runtime_error(
+            "Type mismatch on array assignment (required "
+            + class_->name + " but got " + other.class_->name + ").");
+    length = other.length;
+    words = other.words;
+    instances = other.instances;
+    return *this;
+};
+
+void Array::resize(std::size_t size)
+{
+    if (packed) {
+        std::size_t old_bytes = length * element_size;
+        std::size_t new_bytes = size * element_size;
+        words.resize((new_bytes + sizeof(long long) - 1) / sizeof(long long));
+        if (new_bytes > old_bytes) {
+            // the last word may hold bytes of removed elements
+            std::memset(data() + old_bytes, 0, new_bytes - old_bytes);
+        };
+    } else if (size < instances.size()) {
+        instances.erase(instances.begin() + size, instances.end());
+    } else {
+        instances.reserve(size);
+        Arena *arena = instances.get_allocator().get_arena();
+        while (instances.size() < size) {
+            if (arena) {
+                instances.emplace_back(*class_, *arena);
+            } else {
+                instances.emplace_back(*class_);
+            };
+        };
+    };
+    length = size;
+};
+
+char * Array::data()
+{
+    return const_cast<char *>(static_cast<Array const &>(*this).data());
+};
+
+char const * Array::data() const
+{
+    if (!packed) {
+        throw std::runtime_error(
+            "array of class '" + class_->name + "' is not packed");
+    };
+    return words.empty() ? 0 : reinterpret_cast<char const *>(&words[0]);
+};
+
+Instance & Array::at(std::size_t i)
+{
+    return const_cast<Instance &>(static_cast<Array const &>(*this).at(i));
+};
+
+Instance const & Array::at(std::size_t i) const
+{
+    if (packed) {
+        throw std::runtime_error(
+            "array of class '" + class_->name + "' is packed");
+    };
+    if (i >= length) {
+        throw std::out_of_range("array index out of range");
+    };
+    return instances[i];
+};
+
+void Array::check_type(std::type_info const & type, std::size_t size) const
+{
+    boost::optional<std::type_info const &> class_type = class_->get_type();
+    if (!packed || size != element_size || (class_type && class_type.get() != type)) {
+        throw std::runtime_error(
+            "Type mismatch on array get (required "
+            + (class_type ? std::string(class_type.get().name()) : class_->name)
+            + " but got " + std::string(type.name()) + ").");
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
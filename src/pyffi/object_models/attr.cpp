@@ -63,6 +63,15 @@ std::size_t Attr::get_index() const
     };
 }
 
+std::size_t Attr::get_offset() const
+{
+    if (offset) {
+        return offset.get();
+    } else {
+        throw std::runtime_error("attribute has no offset");
+    };
+}
+
 } // namespace object_models
 
 } // namespace pyffi
@@ -35,6 +35,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <algorithm> // std::find, std::stable_sort
+#include <boost/foreach.hpp>
 #include <stdexcept>
 
 #include "pyffi/object_models/attr_map.hpp"
@@ -45,46 +47,187 @@ namespace pyffi
 namespace object_models
 {
 
+//! Hash a symbol id with a seed; the seeds of the buckets of a
+//! perfect hash are chosen so that all ids of a map have distinct
+//! hashes.
+static std::size_t hash_id(std::size_t id, std::uint32_t seed)
+{
+    // finalizer of splitmix64
+    std::uint64_t h = (static_cast<std::uint64_t>(id) << 32) ^ seed;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<std::size_t>(h ^ (h >> 31));
+}
+
+void AttrMap::freeze()
+{
+    if (frozen) {
+        return;
+    }
+    // only the attributes of this level: those of the base are
+    // looked up in the base
+    Map::nth_index<1>::type const & ordered = map.get<1>();
+    std::vector<Attr const *> all(ordered.begin(), ordered.end());
+    // hash and displace: place the largest buckets first, each with
+    // the first seed that maps all its ids to free slots
+    std::size_t const n = all.size();
+    std::size_t const num_buckets = n / 2 + 1;
+    std::vector<std::vector<std::uint32_t> > buckets(num_buckets);
+    for (std::size_t i = 0; i < n; i++) {
+        buckets[hash_id(all[i]->symbol.get_id(), 0) % num_buckets].push_back(i);
+    }
+    std::vector<std::size_t> order(num_buckets);
+    for (std::size_t b = 0; b < num_buckets; b++) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](std::size_t lhs, std::size_t rhs) {
+                         return buckets[lhs].size() > buckets[rhs].size();
+                     });
+    std::vector<std::uint32_t> new_displacements(num_buckets, 0);
+    std::vector<std::uint32_t> new_slots(n, 0);
+    std::vector<bool> taken(n, false);
+    std::vector<std::size_t> positions;
+    BOOST_FOREACH(std::size_t b, order) {
+        if (buckets[b].empty()) {
+            break;
+        }
+        for (std::uint32_t seed = 1; ; seed++) {
+            if (seed == 0) {
+                throw std::runtime_error("cannot hash attribute map");
+            }
+            positions.clear();
+            BOOST_FOREACH(std::uint32_t i, buckets[b]) {
+                std::size_t pos = hash_id(all[i]->symbol.get_id(), seed) % n;
+                if (taken[pos] || std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+                    break;
+                }
+                positions.push_back(pos);
+            }
+            if (positions.size() == buckets[b].size()) {
+                for (std::size_t j = 0; j < positions.size(); j++) {
+                    taken[positions[j]] = true;
+                    new_slots[positions[j]] = buckets[b][j];
+                }
+                new_displacements[b] = seed;
+                break;
+            }
+        }
+    }
+    attrs.swap(all);
+    displacements.swap(new_displacements);
+    slots.swap(new_slots);
+    // release the nodes
+    Map().swap(map);
+    frozen = true;
+}
+
+std::size_t AttrMap::get_slot(Symbol const & symbol) const
+{
+    std::size_t const id = symbol.get_id();
+    std::uint32_t const seed = displacements[hash_id(id, 0) % displacements.size()];
+    return hash_id(id, seed) % slots.size();
+}
+
+void AttrMap::set_base(AttrMap const & base)
+{
+    if (frozen || !map.empty()) {
+        throw std::runtime_error("base of attribute map set after insertion");
+    }
+    this->base = &base;
+    base_size = base.size();
+}
+
 void AttrMap::push_back(Attr & attr)
 {
+    if (frozen) {
+        throw std::runtime_error("attribute map is frozen");
+    }
     // make sure the attribute has not been indexed already
     if (attr.index) {
         throw std::runtime_error("attribute already indexed");
     }
-    std::pair<AttrMap::Map::const_iterator, bool> ret = map.insert(&attr);
-    if (!ret.second) {
-        // insert failed, so it existed already
-        attr.index = (*ret.first)->index;
+    attr.symbol = Symbol(attr.name);
+    boost::optional<Attr const &> existing = find(attr.symbol);
+    if (existing) {
+        // it existed already
+        attr.index = existing.get().index;
         // TODO we allow duplicates, but we should still check here
         // if the attribute definition is identical!! (same class etc.)
     } else {
-        attr.index = map.size() - 1;
+        map.insert(&attr);
+        attr.index = size() - 1;
     }
 }
 
 Attr const & AttrMap::operator[](std::string const & name) const
 {
-    // use (default) unique hash by name view for performance
-    AttrMap::Map::const_iterator it = map.find(name);
-    if (it == map.end()) {
+    boost::optional<Attr const &> attr = find(name);
+    if (!attr) {
         throw std::runtime_error("attribute '" + name + "'not found");
     }
-    return *(*it);
+    return attr.get();
+}
+
+Attr const & AttrMap::operator[](Symbol const & symbol) const
+{
+    boost::optional<Attr const &> attr = find(symbol);
+    if (!attr) {
+        throw std::runtime_error("attribute '" + symbol.str() + "'not found");
+    }
+    return attr.get();
+}
+
+boost::optional<Attr const &> AttrMap::find(std::string const & name) const
+{
+    // names which were never interned cannot be in the map
+    boost::optional<Symbol> symbol = Symbol::find(name);
+    if (!symbol) {
+        return boost::optional<Attr const &>();
+    }
+    return find(symbol.get());
+}
+
+boost::optional<Attr const &> AttrMap::find(Symbol const & symbol) const
+{
+    if (frozen) {
+        // a single probe per level
+        if (!attrs.empty()) {
+            Attr const & attr = *attrs[slots[get_slot(symbol)]];
+            if (attr.symbol == symbol) {
+                return attr;
+            }
+        }
+    } else {
+        // use (default) unique hash by symbol view for performance
+        AttrMap::Map::const_iterator it = map.find(symbol);
+        if (it != map.end()) {
+            return *(*it);
+        }
+    }
+    if (base) {
+        // only the attributes which were shared
+        boost::optional<Attr const &> attr = base->find(symbol);
+        if (attr && attr.get().get_index() < base_size) {
+            return attr;
+        }
+    }
+    return boost::optional<Attr const &>();
 }
 
 AttrMap::const_iterator AttrMap::begin() const
 {
-    return AttrMap::const_iterator(map.get<1>().begin());
+    return AttrMap::const_iterator(*this, 0);
 }
 
 AttrMap::const_iterator AttrMap::end() const
 {
-    return AttrMap::const_iterator(map.get<1>().end());
+    return AttrMap::const_iterator(*this, size());
 }
 
 std::size_t AttrMap::size() const
 {
-    return map.size();
+    return base_size + (frozen ? attrs.size() : map.size());
 }
 
 } // namespace object_models
@@ -0,0 +1,155 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm> // std::min
+#include <atomic>
+#include <boost/foreach.hpp>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include "pyffi/object_models/block_reader.hpp"
+#include "pyffi/object_models/class.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+std::vector<BlockSpan> scan_blocks(ByteReader & reader, BlockScanner const & scan)
+{
+    std::vector<BlockSpan> blocks;
+    while (true) {
+        boost::optional<std::pair<Class const *, std::size_t> > header = scan(reader);
+        if (!header) {
+            break;
+        };
+        blocks.push_back(BlockSpan(*header.get().first, reader.tell(), header.get().second));
+        reader.take(header.get().second);
+    };
+    return blocks;
+};
+
+//! Decodes blocks, taking the next one that is not yet claimed by
+//! another thread, until all are done or one fails.
+class block_decoder
+{
+public:
+    //! Constructor.
+    block_decoder(char const * data, std::vector<BlockSpan> const & blocks,
+                  Endian endian, Globals const * globals)
+        : data(data), blocks(blocks), endian(endian), globals(globals), next(0), failed(false),
+          instances(blocks.size()), errors(blocks.size()) {};
+
+    //! Body of each thread.
+    void run() {
+        while (!failed) {
+            std::size_t i = next++;
+            if (i >= blocks.size()) {
+                return;
+            };
+            BlockSpan const & block = blocks[i];
+            try {
+                ByteReader reader(data + block.offset, block.size);
+                reader.set_endian(endian);
+                reader.set_globals(globals);
+                instances[i] = Instance(*block.class_);
+                instances[i].get().read(reader);
+                if (reader.remaining() != 0) {
+                    // the span does not match the block: corrupt offsets
+                    throw std::runtime_error(
+                        "block of class '" + block.class_->name
+                        + "' is shorter than its span");
+                };
+            } catch (...) {
+                errors[i] = std::current_exception();
+                failed = true;
+            };
+        };
+    };
+
+    char const *data;
+    std::vector<BlockSpan> const & blocks;
+    Endian endian;
+    Globals const *globals;
+    std::atomic<std::size_t> next;  //!< Index of the next unclaimed block.
+    std::atomic<bool> failed;       //!< Whether any block failed.
+    //! Decoded instances; each is only touched by the thread that claimed it.
+    std::vector<boost::optional<Instance> > instances;
+    std::vector<std::exception_ptr> errors; //!< Error of each block.
+};
+
+std::vector<Instance> read_blocks(
+    void const * data, std::vector<BlockSpan> const & blocks,
+    Endian endian, std::size_t num_threads, Globals const * globals)
+{
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    };
+    num_threads = std::min(num_threads, blocks.size());
+    block_decoder decoder(static_cast<char const *>(data), blocks, endian, globals);
+    std::vector<std::thread> threads;
+    try {
+        for (std::size_t i = 1; i < num_threads; i++) {
+            threads.push_back(std::thread(&block_decoder::run, &decoder));
+        };
+    } catch (std::system_error const &) {
+        // out of threads: decode with those we have
+    };
+    // the calling thread decodes too
+    decoder.run();
+    BOOST_FOREACH(std::thread & thread, threads) {
+        thread.join();
+    };
+    BOOST_FOREACH(std::exception_ptr const & error, decoder.errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        };
+    };
+    std::vector<Instance> result;
+    result.reserve(blocks.size());
+    BOOST_FOREACH(boost::optional<Instance> & instance, decoder.instances) {
+        result.push_back(std::move(instance.get()));
+    };
+    return result;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -46,53 +46,226 @@ namespace pyffi
 namespace object_models
 {
 
-boost::any class_init(Class const & class_)
+//! Instantiate the attributes of a class, and of its base classes.
+void class_init_instances(Class const & class_, InstanceVector & instances)
 {
-    std::vector<Instance> instances;
     // instantiate base class attributes
     boost::optional<Class const &> base_class = class_.get_base_class();
     if (base_class) {
-        instances =
-            boost::any_cast<std::vector<Instance> >(
-                base_class.get().init(base_class.get()));
+        class_init_instances(base_class.get(), instances);
     };
     // instantiate class attributes
     if (class_.scope) {
         class_.scope.get().init(instances);
     };
-    return boost::any(instances);
 };
 
-void class_read(Class const & class_, boost::any & value, std::istream & is)
+Value class_init(Class const & class_, Arena * arena)
 {
-    std::vector<Instance> & instances
-    = boost::any_cast<std::vector<Instance> &>(value);
-    BOOST_FOREACH(Declaration const & decl, class_.scope.get()) {
-        //boost::apply_visitor(declaration_read_visitor(result), decl);
+    Value value(arena);
+    InstanceVector & instances =
+        value.emplace<InstanceVector>(ArenaAllocator<Instance>(arena));
+    // allocate all at once, so instances are never relocated
+    instances.reserve(class_.get_attr_map().size());
+    class_init_instances(class_, instances);
+    return value;
+};
+
+void class_read(Class const & class_, Value & value, std::istream & is)
+{
+    InstanceVector & instances
+    = value_cast<InstanceVector &>(value);
+    class_.get_plan(get_globals(is)).read(instances, is);
+};
+
+void class_write(Class const & class_, Value const & value, std::ostream & os)
+{
+    InstanceVector const & instances
+    = value_cast<InstanceVector const &>(value);
+    class_.get_plan(get_globals(os)).write(instances, os);
+};
+
+void class_read_bytes(Class const & class_, Value & value, ByteReader & reader)
+{
+    InstanceVector & instances
+    = value_cast<InstanceVector &>(value);
+    class_.get_plan(get_globals(reader)).read(instances, reader);
+};
+
+void class_write_bytes(Class const & class_, Value const & value, ByteWriter & writer)
+{
+    InstanceVector const & instances
+    = value_cast<InstanceVector const &>(value);
+    class_.get_plan(get_globals(writer)).write(instances, writer);
+};
+
+std::size_t class_size(Class const & class_, Value const & value, Globals const * globals)
+{
+    InstanceVector const & instances
+    = value_cast<InstanceVector const &>(value);
+    return class_.get_plan(globals).write_size(instances, globals);
+};
+
+Instance & class_attr(Class const & class_, Value & value, std::string const & name)
+{
+    InstanceVector & instances
+    = value_cast<InstanceVector &>(value);
+    return instances[class_.get_attr(name).get_index()];
+}
+
+Instance const & class_const_attr(Class const & class_, Value const & value, std::string const & name)
+{
+    InstanceVector const & instances
+    = value_cast<InstanceVector const &>(value);
+    return instances[class_.get_attr(name).get_index()];
+}
+
+//! Read the runs of bytes of a flat buffer.
+template <typename Reader>
+void flat_read_runs(Class const & class_, char * data, Reader & reader)
+{
+    BOOST_FOREACH(FlatRun const & run, class_.get_flat_runs()) {
+        read_words(reader, data + run.offset, run.size, run.word_size);
     };
 };
 
-void class_write(Class const & class_, boost::any const & value, std::ostream & os)
+//! Write the runs of bytes of a flat buffer.
+template <typename Writer>
+void flat_write_runs(Class const & class_, char const * data, Writer & writer)
 {
-    std::vector<Instance> const & instances
-    = boost::any_cast<std::vector<Instance> const &>(value);
-    BOOST_FOREACH(Declaration const & decl, class_.scope.get()) {
-        //boost::apply_visitor(declaration_write_visitor(result), decl);
+    BOOST_FOREACH(FlatRun const & run, class_.get_flat_runs()) {
+        write_words(writer, data + run.offset, run.size, run.word_size);
     };
 };
 
-Instance & class_attr(Class const & class_, boost::any & value, std::string const & name)
+//! Append the runs of bytes of a class with a fixed size layout,
+//! whose data starts at the given offset. Adjacent primitives of the
+//! same word size join a single run, so a class without padding and
+//! with a single word size has a single run.
+static void flat_append_runs(Class const & class_, std::size_t offset, std::vector<FlatRun> & runs)
 {
-    std::vector<Instance> & instances
-    = boost::any_cast<std::vector<Instance> &>(value);
-    return instances[class_.get_attr(name).get_index()];
+    if (class_.get_type()) {
+        std::size_t size = class_.get_layout().get().size;
+        std::size_t word_size = class_.get_word_size();
+        if (!runs.empty() && runs.back().offset + runs.back().size == offset
+                && runs.back().word_size == word_size) {
+            runs.back().size += size;
+        } else {
+            runs.push_back(FlatRun(offset, size, word_size));
+        };
+        return;
+    };
+    // base class attributes reside at the start of the buffer
+    boost::optional<Class const &> base_class = class_.get_base_class();
+    if (base_class) {
+        flat_append_runs(base_class.get(), offset, runs);
+    };
+    if (class_.scope) {
+        BOOST_FOREACH(Declaration const & decl, class_.scope.get()) {
+            // classes with a layout have no arrays and no if/elif/else
+            Attr const *attr = boost::get<Attr>(&decl);
+            if (attr) {
+                flat_append_runs(attr->get_class(), offset + attr->get_offset(), runs);
+            };
+        };
+    };
+};
+
+Value flat_init(Class const & class_, Arena * arena)
+{
+    Value value(arena);
+    value.emplace<FlatBuffer>(class_.get_layout().get().size, arena);
+    return value;
+};
+
+void flat_read(Class const & class_, Value & value, std::istream & is)
+{
+    FlatBuffer & data = value_cast<FlatBuffer &>(value);
+    if (!data.empty()) {
+        flat_read_runs(class_, data.data(), is);
+    };
+};
+
+void flat_write(Class const & class_, Value const & value, std::ostream & os)
+{
+    FlatBuffer const & data = value_cast<FlatBuffer const &>(value);
+    if (!data.empty()) {
+        flat_write_runs(class_, data.data(), os);
+    };
+};
+
+void flat_read_bytes(Class const & class_, Value & value, ByteReader & reader)
+{
+    FlatBuffer & data = value_cast<FlatBuffer &>(value);
+    if (!data.empty()) {
+        flat_read_runs(class_, data.data(), reader);
+    };
+};
+
+void flat_write_bytes(Class const & class_, Value const & value, ByteWriter & writer)
+{
+    FlatBuffer const & data = value_cast<FlatBuffer const &>(value);
+    if (!data.empty()) {
+        flat_write_runs(class_, data.data(), writer);
+    };
+};
+
+std::size_t flat_size(Class const & class_, Value const &, Globals const *)
+{
+    // padding is not written
+    std::size_t result = 0;
+    BOOST_FOREACH(FlatRun const & run, class_.get_flat_runs()) {
+        result += run.size;
+    };
+    return result;
+};
+
+Instance & flat_attr(Class const & class_, Value &, std::string const &)
+{
+    throw std::runtime_error("flat class '" + class_.name + "' has no attribute instances");
 }
 
-Instance const & class_const_attr(Class const &, boost::any const &, std::string const &)
+Instance const & flat_const_attr(Class const & class_, Value const &, std::string const &)
 {
-    throw std::runtime_error("not yet implemented");
+    throw std::runtime_error("flat class '" + class_.name + "' has no attribute instances");
 }
 
+void Class::set_flat()
+{
+    if (type) {
+        throw std::runtime_error("primitive class '" + name + "' cannot be flat");
+    };
+    if (!layout) {
+        throw std::runtime_error("class '" + name + "' has no fixed size layout");
+    };
+    if (layout.get().alignment > boost::alignment_of<long long>::value) {
+        throw std::runtime_error("class '" + name + "' is aligned beyond a flat buffer");
+    };
+    flat_runs.clear();
+    flat_append_runs(*this, 0, flat_runs);
+    init = &flat_init;
+    read = &flat_read;
+    write = &flat_write;
+    read_bytes = &flat_read_bytes;
+    write_bytes = &flat_write_bytes;
+    size = &flat_size;
+    attr = &flat_attr;
+    const_attr = &flat_const_attr;
+    prototype.reset();
+};
+
+Value Class::instantiate(Arena * arena) const
+{
+    // classes may be instantiated concurrently, so access the
+    // prototype atomically; at worst it is created more than once
+    boost::shared_ptr<Value const> result = boost::atomic_load(&prototype);
+    if (!result) {
+        result.reset(new Value(init(*this, 0)));
+        boost::atomic_store(&prototype, result);
+    };
+    return Value(*result, arena);
+};
+
 boost::optional<Class const &> Class::get_base_class() const
 {
     if (base_class) {
@@ -102,11 +275,60 @@ boost::optional<Class const &> Class::get_base_class() const
     };
 };
 
+boost::optional<Layout const &> Class::get_layout() const
+{
+    if (layout) {
+        return boost::optional<Layout const &>(layout.get());
+    } else {
+        return boost::optional<Layout const &>();
+    };
+};
+
+boost::optional<std::type_info const &> Class::get_type() const
+{
+    if (type) {
+        return boost::optional<std::type_info const &>(*type);
+    } else {
+        return boost::optional<std::type_info const &>();
+    };
+};
+
+boost::optional<std::type_info const &> Class::get_length_type() const
+{
+    if (length_type) {
+        return boost::optional<std::type_info const &>(*length_type);
+    } else {
+        return boost::optional<std::type_info const &>();
+    };
+};
+
+Plan const & Class::get_plan() const
+{
+    return plan;
+};
+
+std::uint64_t Class::find_specialized_plan(Globals const & globals) const
+{
+    boost::unordered_map<Globals, std::size_t>::const_iterator it =
+        specialized_indices.find(globals);
+    return (it != specialized_indices.end()) ? it->second + 1 : 0;
+};
+
 Attr const & Class::get_attr(std::string const & name) const
 {
     return attr_map[name];
 };
 
+Attr const & Class::get_attr(Symbol const & symbol) const
+{
+    return attr_map[symbol];
+};
+
+AttrMap const & Class::get_attr_map() const
+{
+    return attr_map;
+};
+
 } // namespace object_models
 
 } // namespace pyffi
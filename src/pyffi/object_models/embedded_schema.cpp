@@ -0,0 +1,116 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <cctype> // std::isalpha, std::isalnum
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/embedded_schema.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Check that a name is a C++ identifier.
+static bool is_identifier(std::string const & name)
+{
+    if (name.empty() || !(std::isalpha(name[0]) || name[0] == '_')) {
+        return false;
+    };
+    for (std::size_t i = 1; i < name.size(); i++) {
+        if (!(std::isalnum(name[i]) || name[i] == '_')) {
+            return false;
+        };
+    };
+    return true;
+};
+
+void write_embedded_schema(
+    Scope const & scope, std::uint64_t source_hash,
+    std::string const & name, std::string const & header_filename,
+    std::ostream & header, std::ostream & source)
+{
+    if (!is_identifier(name)) {
+        throw std::runtime_error("invalid schema name '" + name + "'");
+    };
+    std::ostringstream cache;
+    scope.write_cache(cache, source_hash);
+    std::string const data = cache.str();
+
+    header
+            << "// generated by pyffi_embed, do not edit\n"
+            << "#ifndef PYFFI_SCHEMA_" << name << "_HPP_INCLUDED\n"
+            << "#define PYFFI_SCHEMA_" << name << "_HPP_INCLUDED\n"
+            << "\n"
+            << "#include \"pyffi/object_models/embedded_schema.hpp\"\n"
+            << "\n"
+            << "namespace pyffi\n{\n\nnamespace schemas\n{\n\n"
+            << "extern pyffi::object_models::EmbeddedSchema const " << name << ";\n"
+            << "\n} // namespace schemas\n\n} // namespace pyffi\n\n#endif\n";
+
+    source
+            << "// generated by pyffi_embed, do not edit\n"
+            << "#include \"" << header_filename << "\"\n"
+            << "\n"
+            << "namespace pyffi\n{\n\nnamespace schemas\n{\n\n"
+            << "static constexpr unsigned char " << name << "_data[] = {";
+    for (std::size_t i = 0; i < data.size(); i++) {
+        source
+                << ((i % 16) ? " " : "\n    ")
+                << static_cast<unsigned int>(static_cast<unsigned char>(data[i]))
+                << ",";
+    };
+    source
+            << "\n};\n\n"
+            << "pyffi::object_models::EmbeddedSchema const " << name << " = {\n"
+            << "    " << name << "_data, sizeof(" << name << "_data), "
+            << source_hash << "ULL\n"
+            << "};\n"
+            << "\n} // namespace schemas\n\n} // namespace pyffi\n";
+};
+
+bool Scope::read_cache(EmbeddedSchema const & schema)
+{
+    return read_cache(schema.data, schema.size, schema.source_hash);
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -0,0 +1,269 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm> // std::reverse
+#include <boost/cstdint.hpp>
+#include <cstring> // std::memcpy
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PYFFI_OM_SWAP_X86
+#include <immintrin.h>
+#endif
+
+#include "pyffi/object_models/endian.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A kernel which swaps count words, of a fixed size, in place.
+typedef void (*SwapKernel)(char * data, std::size_t count);
+
+//! Reverse the bytes of a 16 bit word.
+static inline boost::uint16_t swap_word(boost::uint16_t x)
+{
+    return static_cast<boost::uint16_t>((x >> 8) | (x << 8));
+};
+
+//! Reverse the bytes of a 32 bit word.
+static inline boost::uint32_t swap_word(boost::uint32_t x)
+{
+#ifdef __GNUC__
+    return __builtin_bswap32(x);
+#else
+    return
+        (x >> 24) | ((x >> 8) & 0x0000ff00u) |
+        ((x << 8) & 0x00ff0000u) | (x << 24);
+#endif
+};
+
+//! Reverse the bytes of a 64 bit word.
+static inline boost::uint64_t swap_word(boost::uint64_t x)
+{
+#ifdef __GNUC__
+    return __builtin_bswap64(x);
+#else
+    return
+        (static_cast<boost::uint64_t>(swap_word(static_cast<boost::uint32_t>(x))) << 32) |
+        swap_word(static_cast<boost::uint32_t>(x >> 32));
+#endif
+};
+
+//! Portable kernel, one word at a time.
+template <typename Word>
+static void swap_scalar(char * data, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++, data += sizeof(Word)) {
+        // memcpy, because data need not be aligned
+        Word word;
+        std::memcpy(&word, data, sizeof(Word));
+        word = swap_word(word);
+        std::memcpy(data, &word, sizeof(Word));
+    };
+};
+
+#ifdef PYFFI_OM_SWAP_X86
+
+//! Shuffle mask which reverses every word of a 16 byte block.
+template <typename Word>
+static inline char const * swap_mask()
+{
+    static char const masks[3][16] = {
+        {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+        {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+        {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8}
+    };
+    return masks[(sizeof(Word) == 2) ? 0 : (sizeof(Word) == 4) ? 1 : 2];
+};
+
+//! SSSE3 kernel, 16 bytes at a time.
+template <typename Word>
+__attribute__((target("ssse3")))
+static void swap_ssse3(char * data, std::size_t count)
+{
+    __m128i const mask = _mm_loadu_si128(
+                             reinterpret_cast<__m128i const *>(swap_mask<Word>()));
+    std::size_t const words_per_block = 16 / sizeof(Word);
+    for (; count >= words_per_block; count -= words_per_block, data += 16) {
+        __m128i *block = reinterpret_cast<__m128i *>(data);
+        _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+    };
+    swap_scalar<Word>(data, count);
+};
+
+//! AVX2 kernel, 32 bytes at a time. Words never cross the 16 byte
+//! lanes of the shuffle, so both lanes use the same mask.
+template <typename Word>
+__attribute__((target("avx2")))
+static void swap_avx2(char * data, std::size_t count)
+{
+    __m128i const half = _mm_loadu_si128(
+                             reinterpret_cast<__m128i const *>(swap_mask<Word>()));
+    __m256i const mask = _mm256_broadcastsi128_si256(half);
+    std::size_t const words_per_block = 32 / sizeof(Word);
+    for (; count >= words_per_block; count -= words_per_block, data += 32) {
+        __m256i *block = reinterpret_cast<__m256i *>(data);
+        _mm256_storeu_si256(block, _mm256_shuffle_epi8(_mm256_loadu_si256(block), mask));
+    };
+    if (count >= 16 / sizeof(Word)) {
+        __m128i *block = reinterpret_cast<__m128i *>(data);
+        _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), half));
+        count -= 16 / sizeof(Word);
+        data += 16;
+    };
+    swap_scalar<Word>(data, count);
+};
+
+#endif
+
+//! The kernels for words of 2, 4, and 8 bytes.
+class SwapKernels
+{
+public:
+    //! Constructor, selects the best kernels for this processor.
+    SwapKernels() {
+        kernels[0] = &swap_scalar<boost::uint16_t>;
+        kernels[1] = &swap_scalar<boost::uint32_t>;
+        kernels[2] = &swap_scalar<boost::uint64_t>;
+        name = "scalar";
+#ifdef PYFFI_OM_SWAP_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernels[0] = &swap_avx2<boost::uint16_t>;
+            kernels[1] = &swap_avx2<boost::uint32_t>;
+            kernels[2] = &swap_avx2<boost::uint64_t>;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("ssse3")) {
+            kernels[0] = &swap_ssse3<boost::uint16_t>;
+            kernels[1] = &swap_ssse3<boost::uint32_t>;
+            kernels[2] = &swap_ssse3<boost::uint64_t>;
+            name = "ssse3";
+        };
+#endif
+    };
+
+    //! Get the kernel for the given word size, or null if there is none.
+    SwapKernel get(std::size_t word_size) const {
+        switch (word_size) {
+        case 2:
+            return kernels[0];
+        case 4:
+            return kernels[1];
+        case 8:
+            return kernels[2];
+        default:
+            return 0;
+        };
+    };
+
+    //! Get the portable kernel for the given word size, or null if
+    //! there is none.
+    static SwapKernel get_scalar(std::size_t word_size) {
+        switch (word_size) {
+        case 2:
+            return &swap_scalar<boost::uint16_t>;
+        case 4:
+            return &swap_scalar<boost::uint32_t>;
+        case 8:
+            return &swap_scalar<boost::uint64_t>;
+        default:
+            return 0;
+        };
+    };
+
+    SwapKernel kernels[3]; //!< Kernels for 2, 4, and 8 byte words.
+    char const *name;      //!< Name of the selected kernels.
+};
+
+//! Get the kernels, which are selected on first use.
+static SwapKernels const & get_swap_kernels()
+{
+    static SwapKernels const kernels;
+    return kernels;
+};
+
+void swap_bytes(void * data, std::size_t word_size, std::size_t count)
+{
+    char *bytes = static_cast<char *>(data);
+    if (word_size <= 1) {
+        return;
+    };
+    // single words are too short for the vectorized kernels
+    SwapKernel kernel =
+        (count == 1) ? SwapKernels::get_scalar(word_size)
+        : get_swap_kernels().get(word_size);
+    if (kernel) {
+        kernel(bytes, count);
+        return;
+    };
+    // unusual word size: reverse one word at a time
+    for (std::size_t i = 0; i < count; i++, bytes += word_size) {
+        std::reverse(bytes, bytes + word_size);
+    };
+};
+
+char const * swap_kernel(std::size_t word_size)
+{
+    if (get_swap_kernels().get(word_size)) {
+        return get_swap_kernels().name;
+    } else {
+        return "scalar";
+    };
+};
+
+//! Index of the byte order in the private storage of every stream.
+static int endian_index()
+{
+    static int const index = std::ios_base::xalloc();
+    return index;
+};
+
+Endian get_endian(std::ios_base & stream)
+{
+    return static_cast<Endian>(stream.iword(endian_index()));
+};
+
+void set_endian(std::ios_base & stream, Endian endian)
+{
+    stream.iword(endian_index()) = static_cast<long>(endian);
+};
+
+} // namespace object_models
+
+} // namespace pyffi
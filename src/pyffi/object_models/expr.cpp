@@ -0,0 +1,580 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <boost/spirit/include/qi.hpp>
+#include <boost/spirit/include/phoenix_core.hpp>
+#include <boost/spirit/include/phoenix_function.hpp>
+#include <boost/spirit/include/phoenix_operator.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/expr.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A node of an expression tree.
+class Expr::Node
+{
+public:
+    //! Constructor.
+    Node(Op op, long long value = 0, bool hex = false, bool boolean = false)
+        : op(op), value(value), hex(hex), boolean(boolean), name(), left(), right() {};
+
+    Op op;            //!< The kind of node.
+    long long value;  //!< Value, for CONST.
+    bool hex;         //!< Whether a CONST is written in hexadecimal.
+    bool boolean;     //!< Whether a CONST is written as true or false.
+    std::string name; //!< Name, for NAME.
+    boost::shared_ptr<Node const> left;  //!< Operand, or left operand.
+    boost::shared_ptr<Node const> right; //!< Right operand.
+};
+
+Expr::Expr()
+    : node(new Node(CONST, 0, false, true)) {};
+
+Expr::Expr(bool value)
+    : node(new Node(CONST, value ? 1 : 0, false, true)) {};
+
+Expr Expr::constant(long long value, bool hex)
+{
+    return Expr(boost::shared_ptr<Node const>(new Node(CONST, value, hex)));
+};
+
+Expr Expr::name(std::string const & name)
+{
+    boost::shared_ptr<Node> node(new Node(NAME));
+    node->name = name;
+    return Expr(node);
+};
+
+Expr Expr::unary(Op op, Expr const & operand)
+{
+    boost::shared_ptr<Node> node(new Node(op));
+    node->left = operand.node;
+    return Expr(node);
+};
+
+Expr Expr::binary(Op op, Expr const & left, Expr const & right)
+{
+    boost::shared_ptr<Node> node(new Node(op));
+    node->left = left.node;
+    node->right = right.node;
+    return Expr(node);
+};
+
+Expr::Op Expr::get_op() const
+{
+    return node->op;
+};
+
+long long Expr::get_value() const
+{
+    return node->value;
+};
+
+bool Expr::is_hex() const
+{
+    return node->hex;
+};
+
+bool Expr::is_boolean() const
+{
+    return node->boolean;
+};
+
+std::string const & Expr::get_name() const
+{
+    return node->name;
+};
+
+Expr Expr::get_left() const
+{
+    return Expr(node->left);
+};
+
+Expr Expr::get_right() const
+{
+    return Expr(node->right);
+};
+
+bool Expr::operator==(Expr const & other) const
+{
+    if (node == other.node) {
+        return true;
+    };
+    if (node->op != other.node->op) {
+        return false;
+    };
+    switch (node->op) {
+    case CONST:
+        return node->value == other.node->value;
+    case NAME:
+        return node->name == other.node->name;
+    case NOT:
+    case NEG:
+    case BIT_NOT:
+        return get_left() == other.get_left();
+    default:
+        return
+            (get_left() == other.get_left()) &&
+            (get_right() == other.get_right());
+    };
+};
+
+//! Precedence of an operation; higher binds tighter.
+static int precedence(Expr::Op op)
+{
+    switch (op) {
+    case Expr::OR:
+        return 1;
+    case Expr::AND:
+        return 2;
+    case Expr::BIT_OR:
+        return 3;
+    case Expr::BIT_XOR:
+        return 4;
+    case Expr::BIT_AND:
+        return 5;
+    case Expr::EQ:
+    case Expr::NE:
+        return 6;
+    case Expr::LT:
+    case Expr::LE:
+    case Expr::GT:
+    case Expr::GE:
+        return 7;
+    case Expr::SHL:
+    case Expr::SHR:
+        return 8;
+    case Expr::ADD:
+    case Expr::SUB:
+        return 9;
+    case Expr::MUL:
+    case Expr::DIV:
+    case Expr::MOD:
+        return 10;
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT:
+        return 11;
+    default:
+        return 12;
+    };
+};
+
+//! Symbol of an operation.
+static char const * symbol(Expr::Op op)
+{
+    static char const * const symbols[] = {
+        "", "", "!", "-", "~", "*", "/", "%", "+", "-", "<<", ">>",
+        "<", "<=", ">", ">=", "==", "!=", "&", "^", "|", "&&", "||"
+    };
+    return symbols[op];
+};
+
+void Expr::write(std::ostream & os, int context) const
+{
+    int const prec = precedence(node->op);
+    bool const parens = (prec < context);
+    if (parens) {
+        os << '(';
+    };
+    switch (node->op) {
+    case CONST:
+        if (node->boolean) {
+            os << (node->value ? "true" : "false");
+        } else if (node->hex) {
+            // whole bytes, so versions read naturally
+            std::ostringstream digits;
+            digits << std::hex << std::uppercase << node->value;
+            os << ((digits.str().size() % 2) ? "0x0" : "0x") << digits.str();
+        } else {
+            os << node->value;
+        };
+        break;
+    case NAME:
+        os << node->name;
+        break;
+    case NOT:
+    case NEG:
+    case BIT_NOT:
+        os << symbol(node->op);
+        get_left().write(os, prec);
+        break;
+    default:
+        // binary operators are left associative
+        get_left().write(os, prec);
+        os << ' ' << symbol(node->op) << ' ';
+        get_right().write(os, prec + 1);
+        break;
+    };
+    if (parens) {
+        os << ')';
+    };
+};
+
+std::string Expr::str() const
+{
+    std::ostringstream os;
+    write(os, 0);
+    return os.str();
+};
+
+namespace engine = boost::spirit::qi;
+namespace phoenix = boost::phoenix;
+
+//! Function object for creating literals in semantic actions.
+struct make_constant_impl {
+    typedef Expr result_type;
+    Expr operator()(unsigned long long value, bool hex) const {
+        return Expr::constant(static_cast<long long>(value), hex);
+    };
+};
+
+//! Function object for creating booleans in semantic actions.
+struct make_bool_impl {
+    typedef Expr result_type;
+    Expr operator()(bool value) const {
+        return Expr(value);
+    };
+};
+
+//! Function object for creating names in semantic actions.
+struct make_name_impl {
+    typedef Expr result_type;
+    Expr operator()(std::string const & name) const {
+        return Expr::name(name);
+    };
+};
+
+//! Function object for creating unary operations in semantic actions.
+struct make_unary_impl {
+    typedef Expr result_type;
+    Expr operator()(Expr::Op op, Expr const & operand) const {
+        return Expr::unary(op, operand);
+    };
+};
+
+//! Function object for creating binary operations in semantic actions.
+struct make_binary_impl {
+    typedef Expr result_type;
+    Expr operator()(Expr::Op op, Expr const & left, Expr const & right) const {
+        return Expr::binary(op, left, right);
+    };
+};
+
+template <typename Iterator>
+class expr_grammar : public engine::grammar<Iterator, Expr(), engine::ascii::space_type>
+{
+public:
+    typedef engine::rule<Iterator, Expr(), engine::ascii::space_type> Rule;
+
+    Rule start, or_, and_, bit_or, bit_xor, bit_and, equality, relational;
+    Rule shift, additive, multiplicative, unary, primary;
+    engine::rule<Iterator, std::string()> name;
+    engine::rule<Iterator> keyword_end;
+
+    phoenix::function<make_constant_impl> make_constant;
+    phoenix::function<make_bool_impl> make_bool;
+    phoenix::function<make_name_impl> make_name;
+    phoenix::function<make_unary_impl> make_unary;
+    phoenix::function<make_binary_impl> make_binary;
+
+    expr_grammar() : expr_grammar::base_type(start) {
+        using engine::_1;
+        using engine::_val;
+        using engine::lexeme;
+        using engine::lit;
+        engine::uint_parser<unsigned long long, 10> const dec;
+        engine::uint_parser<unsigned long long, 16> const hex;
+
+        start = or_[_val = _1];
+        or_ =
+            and_[_val = _1]
+            >> *(lit("||") >> and_[_val = make_binary(Expr::OR, _val, _1)]);
+        and_ =
+            bit_or[_val = _1]
+            >> *(lit("&&") >> bit_or[_val = make_binary(Expr::AND, _val, _1)]);
+        bit_or =
+            bit_xor[_val = _1]
+            >> *(lexeme[lit('|') >> !lit('|')]
+                 >> bit_xor[_val = make_binary(Expr::BIT_OR, _val, _1)]);
+        bit_xor =
+            bit_and[_val = _1]
+            >> *(lit('^') >> bit_and[_val = make_binary(Expr::BIT_XOR, _val, _1)]);
+        bit_and =
+            equality[_val = _1]
+            >> *(lexeme[lit('&') >> !lit('&')]
+                 >> equality[_val = make_binary(Expr::BIT_AND, _val, _1)]);
+        equality =
+            relational[_val = _1]
+            >> *((lit("==") >> relational[_val = make_binary(Expr::EQ, _val, _1)])
+                 | (lit("!=") >> relational[_val = make_binary(Expr::NE, _val, _1)]));
+        relational =
+            shift[_val = _1]
+            >> *((lit("<=") >> shift[_val = make_binary(Expr::LE, _val, _1)])
+                 | (lit(">=") >> shift[_val = make_binary(Expr::GE, _val, _1)])
+                 | (lexeme[lit('<') >> !lit('<')]
+                    >> shift[_val = make_binary(Expr::LT, _val, _1)])
+                 | (lexeme[lit('>') >> !lit('>')]
+                    >> shift[_val = make_binary(Expr::GT, _val, _1)]));
+        shift =
+            additive[_val = _1]
+            >> *((lit("<<") >> additive[_val = make_binary(Expr::SHL, _val, _1)])
+                 | (lit(">>") >> additive[_val = make_binary(Expr::SHR, _val, _1)]));
+        additive =
+            multiplicative[_val = _1]
+            >> *((lit('+') >> multiplicative[_val = make_binary(Expr::ADD, _val, _1)])
+                 | (lit('-') >> multiplicative[_val = make_binary(Expr::SUB, _val, _1)]));
+        multiplicative =
+            unary[_val = _1]
+            >> *((lit('*') >> unary[_val = make_binary(Expr::MUL, _val, _1)])
+                 | (lit('/') >> unary[_val = make_binary(Expr::DIV, _val, _1)])
+                 | (lit('%') >> unary[_val = make_binary(Expr::MOD, _val, _1)]));
+        unary =
+            (lit('!') >> unary[_val = make_unary(Expr::NOT, _1)])
+            | (lit('~') >> unary[_val = make_unary(Expr::BIT_NOT, _1)])
+            | (lit('-') >> unary[_val = make_unary(Expr::NEG, _1)])
+            | primary[_val = _1];
+        primary =
+            lexeme[engine::no_case["0x"] >> hex][_val = make_constant(_1, true)]
+            | lexeme[dec >> keyword_end][_val = make_constant(_1, false)]
+            | lexeme[lit("true") >> keyword_end][_val = make_bool(true)]
+            | lexeme[lit("false") >> keyword_end][_val = make_bool(false)]
+            | name[_val = make_name(_1)]
+            | (lit('(') >> or_[_val = _1] >> lit(')'));
+        name %= engine::char_("a-zA-Z_") >> *engine::char_("a-zA-Z0-9_");
+        keyword_end = !engine::char_("a-zA-Z0-9_");
+    };
+};
+
+Expr Expr::parse(std::string const & text)
+{
+    static expr_grammar<std::string::const_iterator> const grammar;
+    std::string::const_iterator first = text.begin();
+    Expr result;
+    bool const ok = engine::phrase_parse(
+                        first, text.end(), grammar, engine::ascii::space, result);
+    if (!ok || first != text.end()) {
+        throw std::runtime_error("syntax error in expression '" + text + "'");
+    };
+    return result;
+};
+
+//! Protects the slots of the global variable names.
+static std::mutex & globals_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+};
+
+std::size_t Globals::get_slot(std::string const & name)
+{
+    static boost::unordered_map<std::string, std::size_t> slots;
+    std::lock_guard<std::mutex> lock(globals_mutex());
+    return slots.insert(std::make_pair(name, slots.size())).first->second;
+};
+
+void Globals::set(std::string const & name, long long value)
+{
+    std::size_t const slot = get_slot(name);
+    if (slot >= values.size()) {
+        values.resize(slot + 1);
+    };
+    values[slot] = value;
+    generation = next_generation();
+};
+
+std::uint64_t Globals::next_generation()
+{
+    static std::atomic<std::uint64_t> counter(1);
+    return counter++;
+};
+
+std::size_t hash_value(Globals const & globals)
+{
+    std::size_t seed = 0;
+    for (std::size_t slot = 0; slot < globals.values.size(); slot++) {
+        if (globals.values[slot]) {
+            boost::hash_combine(seed, slot);
+            boost::hash_combine(seed, globals.values[slot].get());
+        };
+    };
+    return seed;
+};
+
+//! Index of the global variables in the storage of a stream.
+static int globals_index()
+{
+    static int const index = std::ios_base::xalloc();
+    return index;
+};
+
+Globals const * get_globals(std::ios_base & stream)
+{
+    return static_cast<Globals const *>(stream.pword(globals_index()));
+};
+
+void set_globals(std::ios_base & stream, Globals const * globals)
+{
+    stream.pword(globals_index()) = const_cast<Globals *>(globals);
+};
+
+boost::optional<ExprCode::Type> ExprCode::get_type(std::type_info const & type)
+{
+    static std::pair<std::type_info const *, Type> const types[] = {
+        std::make_pair(&typeid(bool), BOOL),
+        std::make_pair(&typeid(char), CHAR),
+        std::make_pair(&typeid(signed char), SCHAR),
+        std::make_pair(&typeid(unsigned char), UCHAR),
+        std::make_pair(&typeid(short), SHORT),
+        std::make_pair(&typeid(unsigned short), USHORT),
+        std::make_pair(&typeid(int), INT),
+        std::make_pair(&typeid(unsigned int), UINT),
+        std::make_pair(&typeid(long), LONG),
+        std::make_pair(&typeid(unsigned long), ULONG),
+        std::make_pair(&typeid(long long), LLONG),
+        std::make_pair(&typeid(unsigned long long), ULLONG),
+        std::make_pair(&typeid(float), FLOAT),
+        std::make_pair(&typeid(double), DOUBLE)
+    };
+    for (std::size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (*types[i].first == type) {
+            return types[i].second;
+        };
+    };
+    return boost::optional<Type>();
+};
+
+//! Fold the constant subexpressions of an expression. Globals with
+//! known values are constants too. Logical operations are folded if
+//! either operand decides the result, as expressions have no side
+//! effects.
+static Expr fold(Expr const & expr, ExprCode::Resolver const & resolve, Globals const * constants)
+{
+    switch (expr.get_op()) {
+    case Expr::CONST:
+        return expr;
+    case Expr::NAME:
+        if (constants && !resolve(expr.get_name())) {
+            std::size_t const slot = Globals::get_slot(expr.get_name());
+            if (constants->has(slot)) {
+                return Expr::constant(constants->get(slot));
+            };
+        };
+        return expr;
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT: {
+        Expr const operand = fold(expr.get_left(), resolve, constants);
+        if (operand.get_op() == Expr::CONST) {
+            return Expr::constant(ExprCode::apply(expr.get_op(), operand.get_value()));
+        };
+        return Expr::unary(expr.get_op(), operand);
+    }
+    default: {
+        Expr const left = fold(expr.get_left(), resolve, constants);
+        Expr const right = fold(expr.get_right(), resolve, constants);
+        bool const left_const = (left.get_op() == Expr::CONST);
+        bool const right_const = (right.get_op() == Expr::CONST);
+        if (left_const && right_const) {
+            return Expr::constant(
+                       ExprCode::apply(expr.get_op(), left.get_value(), right.get_value()));
+        };
+        if (expr.get_op() == Expr::AND
+                && ((left_const && !left.get_value()) || (right_const && !right.get_value()))) {
+            return Expr(false);
+        };
+        if (expr.get_op() == Expr::OR
+                && ((left_const && left.get_value()) || (right_const && right.get_value()))) {
+            return Expr(true);
+        };
+        return Expr::binary(expr.get_op(), left, right);
+    }
+    };
+};
+
+ExprCode::ExprCode(Expr const & expr, Resolver const & resolve, Globals const * constants)
+    : instrs()
+{
+    if (append(fold(expr, resolve, constants), resolve) > max_depth) {
+        throw std::runtime_error("expression '" + expr.str() + "' is too deeply nested");
+    };
+};
+
+std::size_t ExprCode::append(Expr const & expr, Resolver const & resolve)
+{
+    switch (expr.get_op()) {
+    case Expr::CONST:
+        instrs.push_back(Instr(PUSH, expr.get_value()));
+        return 1;
+    case Expr::NAME: {
+        boost::optional<std::pair<std::size_t, Type> > attr = resolve(expr.get_name());
+        if (attr) {
+            instrs.push_back(Instr(ATTR, attr.get().first, Expr::CONST, attr.get().second));
+        } else {
+            instrs.push_back(Instr(GLOBAL, Globals::get_slot(expr.get_name())));
+        };
+        return 1;
+    }
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT: {
+        std::size_t const depth = append(expr.get_left(), resolve);
+        instrs.push_back(Instr(UNARY, 0, expr.get_op()));
+        return depth;
+    }
+    default: {
+        std::size_t const left = append(expr.get_left(), resolve);
+        std::size_t const right = append(expr.get_right(), resolve) + 1;
+        instrs.push_back(Instr(BINARY, 0, expr.get_op()));
+        return (left > right) ? left : right;
+    }
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
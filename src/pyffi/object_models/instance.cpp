@@ -37,6 +37,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/foreach.hpp>
 
+#include "pyffi/object_models/array.hpp"
 #include "pyffi/object_models/scope.hpp"
 #include "pyffi/object_models/instance.hpp"
 
@@ -48,39 +49,111 @@ namespace object_models
 
 
 Instance::Instance(Class const & class_)
-    : class_(class_), value(class_.init(class_)) {};
+    : class_(&class_), value(class_.instantiate(0)) {};
+
+Instance::Instance(Class const & class_, Arena & arena)
+    : class_(&class_), value(class_.instantiate(&arena)) {};
+
+Instance::Instance(Class const & class_, Value && value)
+    : class_(&class_), value(std::move(value)) {};
+
+Instance Instance::array(Class const & class_, Arena * arena)
+{
+    Value value(arena);
+    value.emplace<Array>(class_, arena);
+    return Instance(class_, std::move(value));
+};
 
 Instance::Instance(Instance const & instance)
     : class_(instance.class_), value(instance.value) {};
 
+Instance::Instance(Instance && instance) noexcept
+    : class_(instance.class_), value(std::move(instance.value)) {};
+
+Instance::Instance(Instance const & instance, Arena * arena)
+    : class_(instance.class_), value(instance.value, arena) {};
+
+Instance::Instance(Instance && instance, Arena * arena)
+    : class_(instance.class_), value(std::move(instance.value), arena) {};
+
 Instance & Instance::operator=(const Instance & instance)
 {
-    if (&class_ != &instance.class_)
+    if (class_ != instance.class_)
         throw std::runtime_error(
             "Type mismatch on instance assignment (required "
-            + class_.name + " but got " + instance.class_.name + ").");
+            + class_->name + " but got " + instance.class_->name + ").");
     value = instance.value;
     return *this;
 };
 
+Instance & Instance::operator=(Instance && instance)
+{
+    if (class_ != instance.class_)
+        throw std::runtime_error(
+            "Type mismatch on instance assignment (required "
+            + class_->name + " but got " + instance.class_->name + ").");
+    value = std::move(instance.value);
+    return *this;
+};
+
 void Instance::read(std::istream & is)
 {
-    class_.read(class_, value, is);
+    class_->read(*class_, value, is);
 };
 
 void Instance::write(std::ostream & os) const
 {
-    class_.write(class_, value, os);
+    class_->write(*class_, value, os);
+};
+
+void Instance::read(ByteReader & reader)
+{
+    class_->read_bytes(*class_, value, reader);
+};
+
+void Instance::write(ByteWriter & writer) const
+{
+    class_->write_bytes(*class_, value, writer);
+};
+
+std::size_t Instance::size(Globals const * globals) const
+{
+    return class_->size(*class_, value, globals);
 };
 
 Instance & Instance::attr(std::string const & name)
 {
-    return class_.attr(class_, value, name);
+    return class_->attr(*class_, value, name);
 }
 
 Instance const & Instance::attr(std::string const & name) const
 {
-    return class_.const_attr(class_, value, name);
+    return class_->const_attr(*class_, value, name);
+}
+
+bool Instance::is_flat() const
+{
+    return value.is<FlatBuffer>();
+}
+
+void * Instance::flat_attr_data(std::string const & name, std::type_info const & type)
+{
+    return const_cast<void *>(
+               static_cast<Instance const &>(*this).flat_attr_data(name, type));
+}
+
+void const * Instance::flat_attr_data(std::string const & name, std::type_info const & type) const
+{
+    Attr const & attr = class_->get_attr(name);
+    Class const & attr_class = attr.get_class();
+    boost::optional<std::type_info const &> attr_type = attr_class.get_type();
+    if (!attr_type || attr_type.get() != type) {
+        throw std::runtime_error(
+            "Type mismatch on value get (required "
+            + (attr_type ? std::string(attr_type.get().name()) : attr_class.name)
+            + " but got " + std::string(type.name()) + ").");
+    };
+    return &value_cast<FlatBuffer const &>(value)[attr.get_offset()];
 }
 
 } // namespace object_models
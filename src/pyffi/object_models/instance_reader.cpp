@@ -0,0 +1,108 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <istream>
+#include <stdexcept>
+
+#include "pyffi/object_models/instance_reader.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! A selector which selects the same class until the end of the stream.
+class select_until_end
+{
+public:
+    //! Constructor.
+    select_until_end(Class const & class_) : class_(class_) {};
+
+    //! Select the class, unless at the end of the stream.
+    boost::optional<Class const &> operator()(std::istream & is) const {
+        if (is.peek() == std::istream::traits_type::eof()) {
+            return boost::optional<Class const &>();
+        };
+        return boost::optional<Class const &>(class_);
+    };
+
+    Class const & class_;
+};
+
+InstanceReader::InstanceReader(std::istream & is, Selector const & select, std::size_t block_size)
+    : is(is), select(select), arena(block_size), instance(), count(0) {};
+
+InstanceReader::InstanceReader(std::istream & is, Class const & class_, std::size_t block_size)
+    : is(is), select(select_until_end(class_)),
+      arena(block_size), instance(), count(0) {};
+
+bool InstanceReader::next()
+{
+    release();
+    boost::optional<Class const &> class_ = select(is);
+    if (!class_) {
+        return false;
+    };
+    instance = Instance(class_.get(), arena);
+    instance.get().read(is);
+    if (!is) {
+        release();
+        throw std::runtime_error("unexpected end of stream");
+    };
+    count++;
+    return true;
+};
+
+Instance & InstanceReader::get()
+{
+    if (!instance) {
+        throw std::runtime_error("no instance");
+    };
+    return instance.get();
+};
+
+void InstanceReader::release()
+{
+    // destroy the instance before its memory goes
+    instance = boost::none;
+    arena.release();
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -0,0 +1,104 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <boost/foreach.hpp>
+#include <cstdio> // std::remove
+#include <stdexcept>
+
+#include "pyffi/object_models/instance_writer.hpp"
+#include "pyffi/object_models/mapped_file.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Total number of bytes of a sequence of instances.
+static std::size_t instances_size(std::vector<Instance> const & instances, Globals const * globals)
+{
+    std::size_t result = 0;
+    BOOST_FOREACH(Instance const & instance, instances) {
+        result += instance.size(globals);
+    };
+    return result;
+};
+
+//! Write a sequence of instances, which must fill the writer exactly.
+static void write_instances(std::vector<Instance> const & instances, ByteWriter & writer)
+{
+    BOOST_FOREACH(Instance const & instance, instances) {
+        instance.write(writer);
+    };
+    if (writer.remaining() != 0) {
+        throw std::runtime_error("instances wrote fewer bytes than their size");
+    };
+};
+
+std::vector<char> write_buffer(std::vector<Instance> const & instances, Endian endian, Globals const * globals)
+{
+    std::vector<char> buffer(instances_size(instances, globals));
+    ByteWriter writer(buffer.empty() ? 0 : &buffer[0], buffer.size());
+    writer.set_endian(endian);
+    writer.set_globals(globals);
+    write_instances(instances, writer);
+    return buffer;
+};
+
+void write_file(std::string const & filename, std::vector<Instance> const & instances, Endian endian, Globals const * globals)
+{
+    // write a temporary file, so a failed write keeps the old file
+    std::string const temp = temp_filename(filename);
+    try {
+        MappedOutputFile file(temp, instances_size(instances, globals));
+        ByteWriter writer = file.writer();
+        writer.set_endian(endian);
+        writer.set_globals(globals);
+        write_instances(instances, writer);
+        file.close();
+    } catch (...) {
+        std::remove(temp.c_str());
+        throw;
+    };
+    if (!replace_file(temp, filename)) {
+        throw std::runtime_error("cannot replace '" + filename + "'");
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -0,0 +1,275 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <atomic>
+#include <cstdio> // std::rename, std::remove
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h> // _getpid
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "pyffi/object_models/mapped_file.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string const & filename, bool sequential)
+    : begin(0), size_(0)
+{
+    HANDLE file = CreateFileA(
+                      filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                      sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("cannot open '" + filename + "'");
+    };
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("cannot get size of '" + filename + "'");
+    };
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        // empty files cannot be mapped
+        CloseHandle(file);
+        return;
+    };
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(file);
+    if (!mapping) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+    begin = static_cast<char const *>(
+                MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    // the view keeps the mapping alive
+    CloseHandle(mapping);
+    if (!begin) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+};
+
+MappedFile::~MappedFile()
+{
+    if (begin) {
+        UnmapViewOfFile(begin);
+    };
+};
+
+MappedOutputFile::MappedOutputFile(std::string const & filename, std::size_t size)
+    : filename(filename), begin(0), size_(size)
+{
+    HANDLE file = CreateFileA(
+                      filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0,
+                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("cannot create '" + filename + "'");
+    };
+    if (size_ == 0) {
+        // empty files cannot be mapped
+        CloseHandle(file);
+        return;
+    };
+    // the mapping extends the file to its size
+    HANDLE mapping = CreateFileMappingA(
+                         file, 0, PAGE_READWRITE,
+                         static_cast<DWORD>(static_cast<unsigned long long>(size_) >> 32),
+                         static_cast<DWORD>(size_), 0);
+    CloseHandle(file);
+    if (!mapping) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+    begin = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!begin) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+};
+
+MappedOutputFile::~MappedOutputFile()
+{
+    if (begin) {
+        UnmapViewOfFile(begin);
+    };
+};
+
+void MappedOutputFile::close()
+{
+    if (!begin) {
+        return;
+    };
+    bool flushed = FlushViewOfFile(begin, 0) != 0;
+    bool unmapped = UnmapViewOfFile(begin) != 0;
+    begin = 0;
+    if (!flushed || !unmapped) {
+        throw std::runtime_error("cannot write '" + filename + "'");
+    };
+};
+
+#else
+
+MappedFile::MappedFile(std::string const & filename, bool sequential)
+    : begin(0), size_(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("cannot open '" + filename + "'");
+    };
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("cannot get size of '" + filename + "'");
+    };
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) {
+        // empty files cannot be mapped
+        close(fd);
+        return;
+    };
+    void *address = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+    begin = static_cast<char const *>(address);
+    // only a hint, so failure is harmless
+    madvise(address, size_, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+};
+
+MappedFile::~MappedFile()
+{
+    if (begin) {
+        munmap(const_cast<char *>(begin), size_);
+    };
+};
+
+MappedOutputFile::MappedOutputFile(std::string const & filename, std::size_t size)
+    : filename(filename), begin(0), size_(size)
+{
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        throw std::runtime_error("cannot create '" + filename + "'");
+    };
+    if (size_ == 0) {
+        // empty files cannot be mapped
+        ::close(fd);
+        return;
+    };
+    if (ftruncate(fd, static_cast<off_t>(size_)) == -1) {
+        ::close(fd);
+        throw std::runtime_error("cannot resize '" + filename + "'");
+    };
+    void *address = mmap(0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps the file alive
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("cannot map '" + filename + "'");
+    };
+    begin = static_cast<char *>(address);
+    // written front to back, once
+    madvise(address, size_, MADV_SEQUENTIAL);
+};
+
+MappedOutputFile::~MappedOutputFile()
+{
+    if (begin) {
+        munmap(begin, size_);
+    };
+};
+
+void MappedOutputFile::close()
+{
+    if (!begin) {
+        return;
+    };
+    bool synced = msync(begin, size_, MS_SYNC) == 0;
+    bool unmapped = munmap(begin, size_) == 0;
+    begin = 0;
+    if (!synced || !unmapped) {
+        throw std::runtime_error("cannot write '" + filename + "'");
+    };
+};
+
+#endif
+
+// The name holds the process id, a random number and a counter, so
+// processes and threads which write the same file at once never share
+// a temporary file.
+std::string temp_filename(std::string const & filename)
+{
+    static std::atomic<unsigned int> counter(0);
+    std::random_device random;
+#ifdef _WIN32
+    int const pid = _getpid();
+#else
+    int const pid = static_cast<int>(getpid());
+#endif
+    std::ostringstream name;
+    name << filename << "." << pid << "." << std::hex << random()
+         << "." << counter++ << ".tmp";
+    return name.str();
+};
+
+bool replace_file(std::string const & temp, std::string const & filename)
+{
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+        // some platforms do not replace existing files
+        std::remove(filename.c_str());
+        if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        };
+    };
+    return true;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
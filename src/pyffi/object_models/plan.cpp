@@ -0,0 +1,380 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm> // std::max, std::min
+#include <cstring> // std::memcpy
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include "pyffi/object_models/array.hpp"
+#include "pyffi/object_models/instance.hpp"
+#include "pyffi/object_models/plan.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Largest run which is buffered when reading from or writing to a
+//! stream; larger runs fall back to reading attributes one by one.
+static const std::size_t run_buffer_size = 256;
+
+//! Number of bytes by which an array grows at first when reading
+//! from a stream, see grow_array.
+static const std::size_t array_chunk_size = 65536;
+
+//! Get a pointer to the next size bytes of a stream, through a buffer.
+static char const * take_run(std::istream & is, std::size_t size, char * buffer)
+{
+    if (size > run_buffer_size) {
+        return 0;
+    };
+    is.read(buffer, size);
+    return buffer;
+};
+
+//! Get a pointer to the next size bytes of memory, without copying.
+static char const * take_run(ByteReader & reader, std::size_t size, char *)
+{
+    return reader.take(size);
+};
+
+//! Get a pointer to a buffer for the next size bytes of a stream.
+static char * begin_run(std::ostream &, std::size_t size, char * buffer)
+{
+    return (size > run_buffer_size) ? 0 : buffer;
+};
+
+//! Get a pointer to the next size bytes of memory, without copying.
+static char * begin_run(ByteWriter & writer, std::size_t size, char *)
+{
+    return writer.take(size);
+};
+
+//! Flush the buffer of a run to a stream.
+static void end_run(std::ostream & os, std::size_t size, char * buffer)
+{
+    os.write(buffer, size);
+};
+
+//! Nothing to flush when writing to memory.
+static void end_run(ByteWriter &, std::size_t, char *)
+{
+};
+
+//! Nothing to check for a stream: reading beyond its end fails.
+static void require(std::istream &, std::size_t)
+{
+};
+
+//! Check that size bytes remain in memory, before allocating them.
+static void require(ByteReader & reader, std::size_t size)
+{
+    reader.require(size);
+};
+
+//! Get the number of elements to grow an array to, when done of its
+//! length elements have been read from a stream: its size is unknown,
+//! so the array at most doubles, and a corrupt length cannot allocate
+//! much more than the stream holds. It stops growing once the stream
+//! has failed.
+static std::size_t grow_array(std::istream & is, std::size_t done,
+                              std::size_t length, std::size_t element_size)
+{
+    if (!is) {
+        return done;
+    };
+    std::size_t const chunk = std::max(
+                                  array_chunk_size / std::max(element_size, std::size_t(1)), done);
+    return done + std::min(chunk, length - done);
+};
+
+//! Get the number of elements to grow an array to, in memory: all of
+//! them at once, since require has checked that they are there.
+static std::size_t grow_array(ByteReader &, std::size_t,
+                              std::size_t length, std::size_t)
+{
+    return length;
+};
+
+bool Plan::test(PlanOp const & op, InstanceVector const & instances, Globals const * globals) const
+{
+    return op.expr.evaluate(
+               [&instances](std::size_t index) {
+                   return instances[index].value.data();
+               }, globals) != 0;
+};
+
+std::size_t Plan::length(PlanOp const & op, InstanceVector const & instances, Globals const * globals) const
+{
+    long long result = op.expr.evaluate(
+                           [&instances](std::size_t index) {
+                               return instances[index].value.data();
+                           }, globals);
+    if (result < 0) {
+        throw std::runtime_error("negative array length");
+    };
+    if (op.size && static_cast<unsigned long long>(result)
+        > std::numeric_limits<std::size_t>::max() / op.size) {
+        throw std::runtime_error("array too large");
+    };
+    return static_cast<std::size_t>(result);
+};
+
+template <typename Reader>
+void Plan::read_impl(InstanceVector & instances, Reader & reader) const
+{
+    Globals const * const globals = get_globals(reader);
+    char buffer[run_buffer_size];
+    std::size_t i = 0;
+    while (i < size()) {
+        PlanOp const & op = (*this)[i];
+        switch (op.code) {
+        case PlanOp::READ:
+            read_words(reader, instances[op.index].value.data(), op.size, op.word_size);
+            i++;
+            break;
+        case PlanOp::RUN: {
+            bool const swapped = (op.word_size != 1) && is_swapped(get_endian(reader));
+            // swapping needs a writable copy
+            char const *data =
+                (swapped && op.size > run_buffer_size)
+                ? 0 : take_run(reader, op.size, buffer);
+            if (!data) {
+                // too large to buffer: read attributes one by one
+                i++;
+                break;
+            };
+            if (swapped) {
+                if (data != buffer) {
+                    std::memcpy(buffer, data, op.size);
+                    data = buffer;
+                };
+                if (op.word_size) {
+                    // all words of the run are swapped at once
+                    swap_bytes(buffer, op.word_size, op.size / op.word_size);
+                };
+            };
+            for (i++; i < op.target; i++) {
+                PlanOp const & read_op = (*this)[i];
+                void *value = instances[read_op.index].value.data();
+                std::memcpy(value, data, read_op.size);
+                if (swapped && !op.word_size) {
+                    swap_bytes(value, read_op.word_size, read_op.size / read_op.word_size);
+                };
+                data += read_op.size;
+            };
+            break;
+        }
+        case PlanOp::CLASS:
+            instances[op.index].read(reader);
+            i++;
+            break;
+        case PlanOp::ARRAY: {
+            Array & array = value_cast<Array &>(instances[op.index].value);
+            std::size_t const n = length(op, instances, globals);
+            // the length comes from the file, so it is checked against
+            // the remaining bytes before allocating the elements; each
+            // element counts as at least one byte, so elements of
+            // unknown size cannot allocate without bound either
+            require(reader, n * std::max<std::size_t>(op.size, 1));
+            std::size_t done = 0;
+            std::size_t next = grow_array(reader, done, n, op.size);
+            array.resize(next);
+            while (done < next) {
+                if (op.word_size) {
+                    // packed: read all elements at once
+                    read_words(reader, array.data() + done * op.size,
+                               (next - done) * op.size, op.word_size);
+                } else {
+                    for (std::size_t j = done; j < next; j++) {
+                        array.at(j).read(reader);
+                    };
+                };
+                done = next;
+                next = grow_array(reader, done, n, op.size);
+                if (next > done) {
+                    array.resize(next);
+                };
+            };
+            i++;
+            break;
+        }
+        case PlanOp::BRANCH:
+            i = test(op, instances, globals) ? i + 1 : op.target;
+            break;
+        case PlanOp::JUMP:
+            i = op.target;
+            break;
+        };
+    };
+};
+
+template <typename Writer>
+void Plan::write_impl(InstanceVector const & instances, Writer & writer) const
+{
+    Globals const * const globals = get_globals(writer);
+    char buffer[run_buffer_size];
+    std::size_t i = 0;
+    while (i < size()) {
+        PlanOp const & op = (*this)[i];
+        switch (op.code) {
+        case PlanOp::READ:
+            write_words(writer, instances[op.index].value.data(), op.size, op.word_size);
+            i++;
+            break;
+        case PlanOp::RUN: {
+            bool const swapped = (op.word_size != 1) && is_swapped(get_endian(writer));
+            char *data = begin_run(writer, op.size, buffer);
+            if (!data) {
+                // too large to buffer: write attributes one by one
+                i++;
+                break;
+            };
+            char *start = data;
+            for (i++; i < op.target; i++) {
+                PlanOp const & write_op = (*this)[i];
+                std::memcpy(data, instances[write_op.index].value.data(), write_op.size);
+                if (swapped && !op.word_size) {
+                    swap_bytes(data, write_op.word_size, write_op.size / write_op.word_size);
+                };
+                data += write_op.size;
+            };
+            if (swapped && op.word_size) {
+                // all words of the run are swapped at once
+                swap_bytes(start, op.word_size, op.size / op.word_size);
+            };
+            end_run(writer, op.size, buffer);
+            break;
+        }
+        case PlanOp::CLASS:
+            instances[op.index].write(writer);
+            i++;
+            break;
+        case PlanOp::ARRAY: {
+            Array const & array = value_cast<Array const &>(instances[op.index].value);
+            if (array.size() != length(op, instances, globals)) {
+                throw std::runtime_error("array size does not match its length");
+            };
+            if (op.word_size) {
+                // packed: write all elements at once
+                write_words(writer, array.data(), array.size() * op.size, op.word_size);
+            } else {
+                for (std::size_t j = 0; j < array.size(); j++) {
+                    array.at(j).write(writer);
+                };
+            };
+            i++;
+            break;
+        }
+        case PlanOp::BRANCH:
+            i = test(op, instances, globals) ? i + 1 : op.target;
+            break;
+        case PlanOp::JUMP:
+            i = op.target;
+            break;
+        };
+    };
+};
+
+std::size_t Plan::write_size(InstanceVector const & instances, Globals const * globals) const
+{
+    std::size_t result = 0;
+    std::size_t i = 0;
+    while (i < size()) {
+        PlanOp const & op = (*this)[i];
+        switch (op.code) {
+        case PlanOp::READ:
+            result += op.size;
+            i++;
+            break;
+        case PlanOp::RUN:
+            result += op.size;
+            i = op.target;
+            break;
+        case PlanOp::CLASS:
+            result += instances[op.index].size(globals);
+            i++;
+            break;
+        case PlanOp::ARRAY: {
+            Array const & array = value_cast<Array const &>(instances[op.index].value);
+            if (op.word_size) {
+                result += array.size() * op.size;
+            } else {
+                for (std::size_t j = 0; j < array.size(); j++) {
+                    result += array.at(j).size(globals);
+                };
+            };
+            i++;
+            break;
+        }
+        case PlanOp::BRANCH:
+            i = test(op, instances, globals) ? i + 1 : op.target;
+            break;
+        case PlanOp::JUMP:
+            i = op.target;
+            break;
+        };
+    };
+    return result;
+};
+
+void Plan::read(InstanceVector & instances, std::istream & is) const
+{
+    read_impl(instances, is);
+};
+
+void Plan::write(InstanceVector const & instances, std::ostream & os) const
+{
+    write_impl(instances, os);
+};
+
+void Plan::read(InstanceVector & instances, ByteReader & reader) const
+{
+    read_impl(instances, reader);
+};
+
+void Plan::write(InstanceVector const & instances, ByteWriter & writer) const
+{
+    write_impl(instances, writer);
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -0,0 +1,157 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <stdexcept>
+
+#include "pyffi/object_models/prefetch_buffer.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+PrefetchBuffer::PrefetchBuffer(std::streambuf & source, std::size_t chunk_size, std::size_t depth)
+    : source(source), chunks(), sizes(), first(0), num_ready(0),
+      current(false), done(false), stop(false), error(), consumed(0),
+      mutex(), changed(), thread()
+{
+    if (chunk_size == 0 || depth == 0) {
+        throw std::runtime_error("prefetch chunk size and depth must be positive");
+    };
+    // one chunk for the reader, depth chunks ahead of it
+    chunks.resize(depth + 1, std::vector<char>(chunk_size));
+    sizes.resize(depth + 1, 0);
+    // start only after all members are initialized
+    thread = std::thread(&PrefetchBuffer::run, this);
+};
+
+PrefetchBuffer::~PrefetchBuffer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    changed.notify_all();
+    thread.join();
+};
+
+PrefetchBuffer::int_type PrefetchBuffer::underflow()
+{
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    };
+    std::unique_lock<std::mutex> lock(mutex);
+    if (current) {
+        // give the consumed chunk back to the thread
+        consumed += sizes[first];
+        first = (first + 1) % chunks.size();
+        num_ready--;
+        current = false;
+        setg(0, 0, 0);
+        changed.notify_all();
+    };
+    while (num_ready == 0 && !done) {
+        changed.wait(lock);
+    };
+    if (num_ready == 0) {
+        if (error) {
+            std::exception_ptr e = error;
+            error = std::exception_ptr();
+            std::rethrow_exception(e);
+        };
+        return traits_type::eof();
+    };
+    current = true;
+    char *begin = &chunks[first][0];
+    setg(begin, begin, begin + sizes[first]);
+    return traits_type::to_int_type(*gptr());
+};
+
+PrefetchBuffer::pos_type PrefetchBuffer::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (off != 0 || dir != std::ios_base::cur || which != std::ios_base::in) {
+        return pos_type(off_type(-1));
+    };
+    std::lock_guard<std::mutex> lock(mutex);
+    return pos_type(consumed + (gptr() - eback()));
+};
+
+void PrefetchBuffer::run()
+{
+    while (true) {
+        std::size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stop && num_ready == chunks.size()) {
+                changed.wait(lock);
+            };
+            if (stop) {
+                return;
+            };
+            // the reader never touches chunks which are not ready
+            index = (first + num_ready) % chunks.size();
+        }
+        std::streamsize size = 0;
+        std::exception_ptr e;
+        try {
+            size = source.sgetn(&chunks[index][0], chunks[index].size());
+        } catch (...) {
+            e = std::current_exception();
+        };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size > 0) {
+                sizes[index] = static_cast<std::size_t>(size);
+                num_ready++;
+            } else {
+                // a short chunk need not be the last, an empty one is
+                done = true;
+                error = e;
+            };
+        }
+        changed.notify_all();
+        if (size <= 0) {
+            return;
+        };
+    };
+};
+
+} // namespace object_models
+
+} // namespace pyffi
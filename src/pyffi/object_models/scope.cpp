@@ -48,7 +48,9 @@ namespace object_models
 
 Class const & Scope::get_local_class(std::string const & class_name) const
 {
-    LocalClassMap::const_iterator it = local_class_map.find(class_name);
+    boost::optional<Symbol> symbol = Symbol::find(class_name);
+    LocalClassMap::const_iterator it =
+        symbol ? local_class_map.find(symbol.get()) : local_class_map.end();
     if (it != local_class_map.end()) {
         return *(it->second);
     } else {
@@ -67,25 +69,66 @@ Scope const & Scope::get_parent_scope() const
 
 Class const & Scope::get_class(std::string const & class_name) const
 {
-    LocalClassMap::const_iterator it = local_class_map.find(class_name);
+    // names which were never interned cannot be declared
+    boost::optional<Symbol> symbol = Symbol::find(class_name);
+    if (!symbol) {
+        throw std::runtime_error("class '" + class_name + "' not found");
+    };
+    return get_class(symbol.get());
+};
+
+Class const & Scope::get_class(Symbol const & symbol) const
+{
+    LocalClassMap::const_iterator it = class_map.find(symbol);
+    if (it != class_map.end()) {
+        return *(it->second);
+    };
+    it = local_class_map.find(symbol);
     if (it != local_class_map.end()) {
         return *(it->second);
     } else {
         if (parent_scope) {
-            return parent_scope->get_class(class_name);
+            return parent_scope->get_class(symbol);
         } else {
-            throw std::runtime_error("class '" + class_name + "' not found");
+            throw std::runtime_error("class '" + symbol.str() + "' not found");
         };
     };
 };
 
+Class const & Scope::get_class(std::size_t id) const
+{
+    if (id >= classes.size()) {
+        throw std::runtime_error("class id out of range");
+    };
+    return *classes[id];
+};
+
+Class const & Scope::resolve_class(Symbol const & symbol)
+{
+    LocalClassMap::const_iterator it = class_map.find(symbol);
+    if (it != class_map.end()) {
+        return *(it->second);
+    };
+    Class const *result;
+    it = local_class_map.find(symbol);
+    if (it != local_class_map.end()) {
+        result = it->second;
+    } else if (parent_scope) {
+        result = &parent_scope->resolve_class(symbol);
+    } else {
+        throw std::runtime_error("class '" + symbol.str() + "' not found");
+    };
+    class_map[symbol] = result;
+    return *result;
+};
+
 //! A visitor for initializing all attributes of a scope.
 class declaration_init_visitor
     : public boost::static_visitor<void>
 {
 public:
     //! Constructor.
-    declaration_init_visitor(std::vector<Instance> & instances)
+    declaration_init_visitor(InstanceVector & instances)
         : instances(instances) {};
 
     //! A class.
@@ -93,8 +136,21 @@ public:
 
     //! An attribute.
     void operator()(Attr const & attr) const {
-        // instantiate
-        instances.push_back(Instance(attr.get_class()));
+        // attributes with the same name share their index, so only
+        // instantiate the first one
+        if (attr.get_index() != instances.size()) {
+            return;
+        };
+        // instantiate (in place, so arena instances are not copied)
+        Arena *arena = instances.get_allocator().get_arena();
+        if (attr.is_array()) {
+            // the elements are instantiated when the array is read
+            instances.push_back(Instance::array(attr.get_class(), arena));
+        } else if (arena) {
+            instances.emplace_back(attr.get_class(), *arena);
+        } else {
+            instances.emplace_back(attr.get_class());
+        };
     };
 
     //! An if/elif/.../else structure.
@@ -112,10 +168,10 @@ public:
     //! Documentation.
     void operator()(Doc const & doc) const {};
 
-    std::vector<Instance> & instances;
+    InstanceVector & instances;
 };
 
-void Scope::init(std::vector<Instance> & instances) const
+void Scope::init(InstanceVector & instances) const
 {
     BOOST_FOREACH(Declaration const & decl, *this) {
         boost::apply_visitor(declaration_init_visitor(instances), decl);
@@ -0,0 +1,400 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <boost/foreach.hpp>
+#include <cstdio> // std::remove
+#include <cstring> // std::memcmp
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/byte_stream.hpp"
+#include "pyffi/object_models/mapped_file.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+// The cache starts with a header: the magic bytes, the format version
+// of the cache, and the hash of the format description. Then follows
+// the scope: its versions, and its declarations, each tagged with its
+// type. All integers are little endian, and strings, lists, and
+// scopes are prefixed with their size, so the cache can be read from
+// any address.
+
+//! Magic bytes at the start of every cache.
+static char const cache_magic[8] = {'P', 'Y', 'F', 'F', 'I', 'S', 'C', '\0'};
+
+//! Format version of the cache; increase it on every change of the
+//! format, or of what parse_xml makes of a source, so old caches are
+//! parsed again.
+static std::uint32_t const cache_version = 3;
+
+//! Size of the header.
+static std::size_t const cache_header_size = sizeof(cache_magic) + 4 + 8;
+
+//! Tags of the declaration types.
+enum CacheTag {
+    CACHE_CLASS,
+    CACHE_ATTR,
+    CACHE_IF_ELIFS_ELSE
+};
+
+//! Write an integer.
+template <typename T>
+static void cache_write(std::ostream & os, T value)
+{
+    write_words(os, &value, sizeof(T), sizeof(T));
+};
+
+//! Read an integer.
+template <typename T>
+static T cache_read(ByteReader & reader)
+{
+    T value;
+    read_words(reader, &value, sizeof(T), sizeof(T));
+    return value;
+};
+
+//! Read a size, and check that the data has room for at least so many
+//! elements of at least one byte each, so corrupt sizes fail before
+//! anything is allocated.
+static std::size_t cache_read_size(ByteReader & reader)
+{
+    std::size_t size = cache_read<std::uint32_t>(reader);
+    reader.require(size);
+    return size;
+};
+
+static void cache_write(std::ostream & os, std::string const & str)
+{
+    cache_write<std::uint32_t>(os, str.size());
+    os.write(str.data(), str.size());
+};
+
+static std::string cache_read_string(ByteReader & reader)
+{
+    std::size_t size = cache_read_size(reader);
+    return std::string(reader.take(size), size);
+};
+
+static void cache_write(std::ostream & os, Doc const & doc)
+{
+    cache_write<std::uint32_t>(os, doc.size());
+    BOOST_FOREACH(std::string const & line, doc) {
+        cache_write(os, line);
+    };
+};
+
+static Doc cache_read_doc(ByteReader & reader)
+{
+    Doc doc;
+    for (std::size_t i = cache_read_size(reader); i > 0; i--) {
+        doc.push_back(cache_read_string(reader));
+    };
+    return doc;
+};
+
+static void cache_write(std::ostream & os, Expr const & expr)
+{
+    cache_write<std::uint8_t>(os, expr.get_op());
+    switch (expr.get_op()) {
+    case Expr::CONST:
+        cache_write<std::int64_t>(os, expr.get_value());
+        cache_write<std::uint8_t>(os, (expr.is_hex() ? 1 : 0) | (expr.is_boolean() ? 2 : 0));
+        break;
+    case Expr::NAME:
+        cache_write(os, expr.get_name());
+        break;
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT:
+        cache_write(os, expr.get_left());
+        break;
+    default:
+        cache_write(os, expr.get_left());
+        cache_write(os, expr.get_right());
+    };
+};
+
+static Expr cache_read_expr(ByteReader & reader)
+{
+    std::uint8_t op = cache_read<std::uint8_t>(reader);
+    switch (op) {
+    case Expr::CONST: {
+        long long value = cache_read<std::int64_t>(reader);
+        std::uint8_t flags = cache_read<std::uint8_t>(reader);
+        if (flags & 2) {
+            return Expr(value != 0);
+        };
+        return Expr::constant(value, (flags & 1) != 0);
+    }
+    case Expr::NAME:
+        return Expr::name(cache_read_string(reader));
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT:
+        return Expr::unary(Expr::Op(op), cache_read_expr(reader));
+    default:
+        if (op > Expr::OR) {
+            throw std::runtime_error("corrupt schema cache (invalid operator)");
+        };
+        Expr left = cache_read_expr(reader);
+        Expr right = cache_read_expr(reader);
+        return Expr::binary(Expr::Op(op), left, right);
+    };
+};
+
+static void cache_write(std::ostream & os, Scope const & scope);
+static void cache_read_scope(ByteReader & reader, Scope & scope);
+
+//! Write an optional value, prefixed with whether it is set.
+template <typename T>
+static void cache_write(std::ostream & os, boost::optional<T> const & value)
+{
+    cache_write<std::uint8_t>(os, value ? 1 : 0);
+    if (value) {
+        cache_write(os, value.get());
+    };
+};
+
+//! Read whether an optional value is set.
+static bool cache_read_flag(ByteReader & reader)
+{
+    return cache_read<std::uint8_t>(reader) != 0;
+};
+
+//! Write a declaration, prefixed with its tag.
+class declaration_cache_write_visitor
+    : public boost::static_visitor<void>
+{
+public:
+    declaration_cache_write_visitor(std::ostream & os) : os(os) {};
+
+    void operator()(Class const & class_) const {
+        cache_write<std::uint8_t>(os, CACHE_CLASS);
+        cache_write(os, class_.name);
+        cache_write(os, class_.base_name);
+        cache_write(os, class_.doc);
+        cache_write(os, class_.scope);
+    };
+
+    void operator()(Attr const & attr) const {
+        cache_write<std::uint8_t>(os, CACHE_ATTR);
+        cache_write(os, attr.class_name);
+        cache_write(os, attr.name);
+        cache_write(os, attr.arr1);
+        cache_write(os, attr.arr2);
+        cache_write(os, attr.doc);
+    };
+
+    void operator()(IfElifsElse const & ifelifselse) const {
+        cache_write<std::uint8_t>(os, CACHE_IF_ELIFS_ELSE);
+        cache_write<std::uint32_t>(os, ifelifselse.ifs_.size());
+        BOOST_FOREACH(If const & if_, ifelifselse.ifs_) {
+            cache_write(os, if_.expr);
+            cache_write(os, if_.scope);
+        };
+        cache_write(os, ifelifselse.else_);
+    };
+
+    std::ostream & os;
+};
+
+static void cache_write(std::ostream & os, Scope const & scope)
+{
+    cache_write<std::uint32_t>(os, scope.versions.size());
+    BOOST_FOREACH(long long version, scope.versions) {
+        cache_write<std::int64_t>(os, version);
+    };
+    cache_write<std::uint32_t>(os, scope.size());
+    declaration_cache_write_visitor visitor(os);
+    BOOST_FOREACH(Declaration const & decl, scope) {
+        boost::apply_visitor(visitor, decl);
+    };
+};
+
+static void cache_read_class(ByteReader & reader, Class & class_)
+{
+    class_.name = cache_read_string(reader);
+    if (cache_read_flag(reader)) {
+        class_.base_name = cache_read_string(reader);
+    };
+    if (cache_read_flag(reader)) {
+        class_.doc = cache_read_doc(reader);
+    };
+    if (cache_read_flag(reader)) {
+        class_.scope = Scope();
+        cache_read_scope(reader, class_.scope.get());
+    };
+};
+
+static void cache_read_attr(ByteReader & reader, Attr & attr)
+{
+    attr.class_name = cache_read_string(reader);
+    attr.name = cache_read_string(reader);
+    if (cache_read_flag(reader)) {
+        attr.arr1 = cache_read_expr(reader);
+    };
+    if (cache_read_flag(reader)) {
+        attr.arr2 = cache_read_expr(reader);
+    };
+    if (cache_read_flag(reader)) {
+        attr.doc = cache_read_doc(reader);
+    };
+};
+
+static void cache_read_if_elifs_else(ByteReader & reader, IfElifsElse & ifelifselse)
+{
+    ifelifselse.ifs_.resize(cache_read_size(reader));
+    BOOST_FOREACH(If & if_, ifelifselse.ifs_) {
+        if_.expr = cache_read_expr(reader);
+        cache_read_scope(reader, if_.scope);
+    };
+    if (cache_read_flag(reader)) {
+        ifelifselse.else_ = Scope();
+        cache_read_scope(reader, ifelifselse.else_.get());
+    };
+};
+
+static void cache_read_scope(ByteReader & reader, Scope & scope)
+{
+    for (std::size_t i = cache_read_size(reader); i > 0; i--) {
+        scope.versions.push_back(cache_read<std::int64_t>(reader));
+    };
+    std::size_t size = cache_read_size(reader);
+    scope.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        switch (cache_read<std::uint8_t>(reader)) {
+        case CACHE_CLASS:
+            scope.push_back(Class());
+            cache_read_class(reader, boost::get<Class>(scope.back()));
+            break;
+        case CACHE_ATTR:
+            scope.push_back(Attr());
+            cache_read_attr(reader, boost::get<Attr>(scope.back()));
+            break;
+        case CACHE_IF_ELIFS_ELSE:
+            scope.push_back(IfElifsElse());
+            cache_read_if_elifs_else(reader, boost::get<IfElifsElse>(scope.back()));
+            break;
+        default:
+            throw std::runtime_error("corrupt schema cache (invalid declaration)");
+        };
+    };
+};
+
+void Scope::write_cache(std::ostream & out, std::uint64_t source_hash) const
+{
+    Endian endian = get_endian(out);
+    set_endian(out, Endian::LITTLE);
+    out.write(cache_magic, sizeof(cache_magic));
+    cache_write<std::uint32_t>(out, cache_version);
+    cache_write<std::uint64_t>(out, source_hash);
+    cache_write(out, *this);
+    set_endian(out, endian);
+};
+
+bool Scope::read_cache(void const * data, std::size_t size, std::uint64_t source_hash)
+{
+    ByteReader reader(data, size);
+    reader.set_endian(Endian::LITTLE);
+    if (size < cache_header_size
+            || std::memcmp(reader.take(sizeof(cache_magic)), cache_magic, sizeof(cache_magic)) != 0
+            || cache_read<std::uint32_t>(reader) != cache_version
+            || cache_read<std::uint64_t>(reader) != source_hash) {
+        return false;
+    };
+    Scope scope;
+    cache_read_scope(reader, scope);
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("corrupt schema cache (trailing data)");
+    };
+    *this = std::move(scope);
+    return true;
+};
+
+std::uint64_t Scope::hash_source(std::string const & text)
+{
+    // 64 bit FNV-1a: stable across platforms and releases, unlike
+    // boost::hash
+    std::uint64_t hash = 14695981039346656037ULL;
+    BOOST_FOREACH(char c, text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    };
+    return hash;
+};
+
+bool Scope::parse_xml_cached(std::istream & in, std::string const & cache_filename)
+{
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::uint64_t source_hash = hash_source(text);
+    try {
+        MappedFile file(cache_filename);
+        if (read_cache(file.data(), file.size(), source_hash)) {
+            return true;
+        };
+    } catch (std::runtime_error const &) {
+        // missing or corrupt cache: parse again
+    };
+    std::istringstream xml(text);
+    if (!parse_xml(xml)) {
+        return false;
+    };
+    // write to a temporary file first, so a cache is never seen half
+    // written; failing to write it is not an error
+    std::string const temp = temp_filename(cache_filename);
+    {
+        std::ofstream out(temp.c_str(), std::ios::binary);
+        write_cache(out, source_hash);
+        if (!out.good()) {
+            out.close();
+            std::remove(temp.c_str());
+            return true;
+        };
+    }
+    replace_file(temp, cache_filename);
+    return true;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -35,7 +35,9 @@ POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <algorithm> // std::max
 #include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "pyffi/object_models/scope.hpp"
 
@@ -52,25 +54,29 @@ class declaration_compile_lcm_ps_visitor
 {
 public:
     //! Constructor.
-    declaration_compile_lcm_ps_visitor(Scope & scope)
-        : scope(scope) {};
+    declaration_compile_lcm_ps_visitor(Scope & scope, std::vector<Class const *> & classes)
+        : scope(scope), classes(classes) {};
 
     //! A class.
     void operator()(Class & class_) const {
-        // update the local class map
+        // intern the name, and update the local class map
+        class_.symbol = Symbol(class_.name);
         std::pair<Scope::LocalClassMap::iterator, bool> ret =
             scope.local_class_map.insert(
-                std::make_pair(class_.name, &class_));
+                std::make_pair(class_.symbol, &class_));
         if (!ret.second) {
             // insert failed
             throw std::runtime_error(
                 "duplicate definition of class '" + class_.name + "'.");
         };
+        // number the class
+        class_.id = classes.size();
+        classes.push_back(&class_);
         if (class_.scope) {
             // set the class's parent scope
             class_.scope.get().parent_scope = &scope;
             // compile the nested scope
-            class_.scope.get().compile_lcm_ps();
+            class_.scope.get().compile_lcm_ps(classes);
         };
     };
 
@@ -83,25 +89,26 @@ public:
             // set the if's parent scope
             if_.scope.parent_scope = &scope;
             // compile this if's scope
-            if_.scope.compile_lcm_ps();
+            if_.scope.compile_lcm_ps(classes);
         };
         if (ifelifselse.else_) {
             // set the if's parent scope
             ifelifselse.else_.get().parent_scope = &scope;
             // compile the else's scope
-            ifelifselse.else_.get().compile_lcm_ps();
+            ifelifselse.else_.get().compile_lcm_ps(classes);
         };
     };
 
     Scope & scope;
+    std::vector<Class const *> & classes;
 };
 
-void Scope::compile_lcm_ps()
+void Scope::compile_lcm_ps(std::vector<Class const *> & classes)
 {
     BOOST_FOREACH(Declaration & decl, *this) {
         // compile all declarations
         boost::apply_visitor(
-            declaration_compile_lcm_ps_visitor(*this), decl);
+            declaration_compile_lcm_ps_visitor(*this, classes), decl);
     };
 }
 
@@ -119,8 +126,9 @@ public:
     void operator()(Class & class_) const {
         // find base class
         if (class_.base_name) {
-            class_.base_class = &scope.get_class(class_.base_name.get());
-            class_.attr_map = class_.base_class->attr_map;
+            class_.base_class = &scope.resolve_class(Symbol(class_.base_name.get()));
+            // share the attributes of the base class, without copying
+            class_.attr_map.set_base(class_.base_class->attr_map);
         };
         // compile the nested scope
         if (class_.scope) {
@@ -130,7 +138,7 @@ public:
 
     //! An attribute.
     void operator()(Attr & attr) const {
-        attr.class_ = &scope.get_class(attr.class_name);
+        attr.class_ = &scope.resolve_class(Symbol(attr.class_name));
         attr_map.push_back(attr);
     };
 
@@ -159,15 +167,614 @@ void Scope::compile_a_bc(AttrMap & attr_map)
     };
 }
 
+//! A visitor for freezing (f) the attribute map of every class.
+class declaration_compile_f_visitor
+    : public boost::static_visitor<void>
+{
+public:
+    //! A class.
+    void operator()(Class & class_) const {
+        class_.attr_map.freeze();
+        // compile the nested scope
+        if (class_.scope) {
+            class_.scope.get().compile_f();
+        };
+    };
+
+    //! An attribute.
+    void operator()(Attr &) const {};
+
+    //! An if/elif/.../else structure.
+    void operator()(IfElifsElse & ifelifselse) const {
+        BOOST_FOREACH(If & if_, ifelifselse.ifs_) {
+            // compile this if's scope
+            if_.scope.compile_f();
+        };
+        if (ifelifselse.else_) {
+            // compile the else's scope
+            ifelifselse.else_.get().compile_f();
+        };
+    };
+};
+
+void Scope::compile_f()
+{
+    BOOST_FOREACH(Declaration & decl, *this) {
+        // compile all declarations
+        boost::apply_visitor(declaration_compile_f_visitor(), decl);
+    };
+}
+
+//! Calculates the layout of classes, and the offsets of their
+//! attributes. A class has a fixed size layout if it is primitive, or
+//! if its base class and the classes of all its attributes have a
+//! fixed size layout, and if it has no arrays and no if/elif/else
+//! declarations. Also calculates the least size of every class in a
+//! file (see Class::get_min_size).
+class class_layout_compiler
+{
+public:
+    //! Constructor.
+    class_layout_compiler() : layouts(), offsets(), word_sizes(), min_sizes() {};
+
+    //! Get the layout of a class, if it has a fixed size.
+    boost::optional<Layout> operator()(Class const & class_) {
+        LayoutMap::const_iterator it = layouts.find(&class_);
+        if (it != layouts.end()) {
+            return it->second;
+        };
+        // mark class as being calculated: a class which (indirectly)
+        // contains itself does not have a fixed size
+        layouts[&class_] = boost::optional<Layout>();
+        boost::optional<Layout> layout = calculate(class_);
+        layouts[&class_] = layout;
+        return layout;
+    };
+
+    //! Get the offset of an attribute, if its class has a fixed size.
+    boost::optional<std::size_t> get_offset(Attr const & attr) const {
+        OffsetMap::const_iterator it = offsets.find(&attr);
+        if (it != offsets.end()) {
+            return it->second;
+        } else {
+            return boost::optional<std::size_t>();
+        };
+    };
+
+    //! Get the word size of a class of fixed size, see
+    //! Class::get_word_size.
+    std::size_t get_word_size(Class const & class_) const {
+        SizeMap::const_iterator it = word_sizes.find(&class_);
+        if (it != word_sizes.end()) {
+            return it->second;
+        } else {
+            // primitive types have their word size set by set_type
+            return class_.get_word_size();
+        };
+    };
+
+    //! Get the least size of a class in a file, see
+    //! Class::get_min_size.
+    std::size_t get_min_size(Class const & class_) {
+        if (class_.get_type() || class_.is_sized_string()) {
+            // set by set_type and set_sized_string
+            return class_.get_min_size();
+        };
+        SizeMap::const_iterator it = min_sizes.find(&class_);
+        if (it != min_sizes.end()) {
+            return it->second;
+        };
+        // mark class as being calculated: a class which (indirectly)
+        // contains itself counts as empty
+        min_sizes[&class_] = 0;
+        std::size_t min_size = 0;
+        boost::optional<Class const &> base_class = class_.get_base_class();
+        if (base_class) {
+            min_size += get_min_size(base_class.get());
+        };
+        if (class_.scope) {
+            BOOST_FOREACH(Declaration const & decl, class_.scope.get()) {
+                Attr const *attr = boost::get<Attr>(&decl);
+                if (attr && !attr->is_array()) {
+                    min_size += get_min_size(attr->get_class());
+                };
+            };
+        };
+        return (min_sizes[&class_] = min_size);
+    };
+
+private:
+    typedef boost::unordered_map<Class const *, boost::optional<Layout> > LayoutMap;
+    typedef boost::unordered_map<Attr const *, std::size_t> OffsetMap;
+    typedef boost::unordered_map<Class const *, std::size_t> SizeMap;
+
+    LayoutMap layouts; //!< Layouts calculated so far.
+    OffsetMap offsets; //!< Offsets calculated so far.
+    SizeMap word_sizes; //!< Word sizes of non-primitive classes.
+    SizeMap min_sizes; //!< Least sizes of non-primitive classes.
+
+    //! Account for a member (base class or attribute) in the number
+    //! of bytes and the shared word size of a class.
+    void add_member(Class const & member, Layout const & member_layout,
+                    std::size_t & data_size,
+                    boost::optional<std::size_t> & word_size) const {
+        std::size_t member_word_size = get_word_size(member);
+        data_size += member_layout.size;
+        if (!word_size) {
+            word_size = member_word_size;
+        } else if (word_size.get() != member_word_size) {
+            word_size = 0;
+        };
+    };
+
+    boost::optional<Layout> calculate(Class const & class_) {
+        if (class_.get_type()) {
+            // primitive types have their layout set by set_type
+            return class_.get_layout().get();
+        };
+        if (class_.is_sized_string()) {
+            return boost::optional<Layout>();
+        };
+        Layout layout;
+        std::size_t data_size = 0;
+        boost::optional<std::size_t> word_size;
+        boost::optional<Class const &> base_class = class_.get_base_class();
+        if (base_class) {
+            boost::optional<Layout> base_layout = (*this)(base_class.get());
+            if (!base_layout) {
+                return boost::optional<Layout>();
+            };
+            layout = base_layout.get();
+            add_member(base_class.get(), layout, data_size, word_size);
+        };
+        if (class_.scope) {
+            std::vector<std::pair<Attr const *, std::size_t> > attr_offsets;
+            BOOST_FOREACH(Declaration const & decl, class_.scope.get()) {
+                if (boost::get<IfElifsElse>(&decl)) {
+                    return boost::optional<Layout>();
+                };
+                Attr const *attr = boost::get<Attr>(&decl);
+                if (attr) {
+                    if (attr->is_array()) {
+                        return boost::optional<Layout>();
+                    };
+                    boost::optional<Layout> attr_layout = (*this)(attr->get_class());
+                    if (!attr_layout) {
+                        return boost::optional<Layout>();
+                    };
+                    attr_offsets.push_back(
+                        std::make_pair(attr, layout.append(attr_layout.get())));
+                    add_member(attr->get_class(), attr_layout.get(), data_size, word_size);
+                };
+            };
+            offsets.insert(attr_offsets.begin(), attr_offsets.end());
+        };
+        layout.pad();
+        // padding is not stored in files, so it cannot be copied as is
+        word_sizes[&class_] = (data_size == layout.size) ? word_size.get_value_or(1) : 0;
+        return layout;
+    };
+};
+
+//! A visitor for compiling the layout (l) of every class and the
+//! offset (o) of every attribute.
+class declaration_compile_l_o_visitor
+    : public boost::static_visitor<void>
+{
+public:
+    //! Constructor.
+    declaration_compile_l_o_visitor(class_layout_compiler & compiler)
+        : compiler(compiler) {};
+
+    //! A class.
+    void operator()(Class & class_) const {
+        if (!class_.type) {
+            class_.layout = compiler(class_);
+            class_.word_size = compiler.get_word_size(class_);
+            class_.min_size = compiler.get_min_size(class_);
+        };
+        // compile the nested scope
+        if (class_.scope) {
+            class_.scope.get().compile_l_o(compiler);
+        };
+    };
+
+    //! An attribute.
+    void operator()(Attr & attr) const {
+        attr.offset = compiler.get_offset(attr);
+    };
+
+    //! An if/elif/.../else structure.
+    void operator()(IfElifsElse & ifelifselse) const {
+        BOOST_FOREACH(If & if_, ifelifselse.ifs_) {
+            // compile this if's scope
+            if_.scope.compile_l_o(compiler);
+        };
+        if (ifelifselse.else_) {
+            // compile the else's scope
+            ifelifselse.else_.get().compile_l_o(compiler);
+        };
+    };
+
+    class_layout_compiler & compiler;
+};
+
+void Scope::compile_l_o(class_layout_compiler & compiler)
+{
+    BOOST_FOREACH(Declaration & decl, *this) {
+        // compile all declarations
+        boost::apply_visitor(
+            declaration_compile_l_o_visitor(compiler), decl);
+    };
+}
+
+//! Resolves the names in the conditions and array lengths of a class
+//! to its attributes. Only attributes declared before the expression
+//! have been read when it is evaluated, so any other is an error.
+class attr_resolver
+{
+public:
+    //! Constructor.
+    /*!
+      \param class_ The class.
+      \param declared The number of attributes of the class declared
+      before the expression.
+    */
+    attr_resolver(Class const & class_, std::size_t declared)
+        : class_(class_), declared(declared) {};
+
+    //! Get the index and type of an attribute, or none if the class
+    //! has no attribute of that name.
+    boost::optional<std::pair<std::size_t, ExprCode::Type> >
+    operator()(std::string const & name) const {
+        boost::optional<Attr const &> attr = class_.get_attr_map().find(name);
+        if (!attr) {
+            return boost::none;
+        };
+        if (attr.get().get_index() >= declared) {
+            throw std::runtime_error(
+                "attribute '" + name + "' of class '" + class_.name
+                + "' is used in an expression before it is declared");
+        };
+        boost::optional<std::type_info const &> type = attr.get().get_class().get_type();
+        boost::optional<ExprCode::Type> expr_type;
+        if (type && !attr.get().is_array()) {
+            expr_type = ExprCode::get_type(type.get());
+        };
+        if (!expr_type) {
+            throw std::runtime_error(
+                "attribute '" + name + "' of class '" + class_.name
+                + "' is used in an expression, but is not a number");
+        };
+        return std::make_pair(attr.get().get_index(), expr_type.get());
+    };
+
+private:
+    Class const & class_;
+    std::size_t declared;
+};
+
+//! Calculates the read plan of classes. The plan of a class starts
+//! with the plan of its base class, followed by an instruction for
+//! every attribute of its scope, with branches for if/elif/else.
+/*!
+  Global variables whose values are given as constants are folded
+  into the conditions, so a plan for a single file version has no
+  branches on the version, and the attributes around them are read
+  in longer runs.
+*/
+class class_plan_compiler
+{
+public:
+    //! Constructor.
+    class_plan_compiler(Globals const * constants = 0)
+        : constants(constants), plans(), declared(0) {};
+
+    //! Get the plan of a class.
+    Plan const & operator()(Class const & class_) {
+        PlanMap::const_iterator it = plans.find(&class_);
+        if (it != plans.end()) {
+            if (!it->second) {
+                throw std::runtime_error(
+                    "class '" + class_.name + "' derives from itself");
+            };
+            return it->second.get();
+        };
+        // mark class as being calculated
+        plans[&class_] = boost::optional<Plan>();
+        Plan plan;
+        boost::optional<Class const &> base_class = class_.get_base_class();
+        if (base_class) {
+            plan = (*this)(base_class.get());
+        };
+        if (class_.scope) {
+            // the attributes of the base class are all read first
+            declared = base_class ? base_class.get().get_attr_map().size() : 0;
+            boost::optional<std::size_t> run;
+            append(class_.scope.get(), class_, plan, run);
+            end_run(run, plan);
+        };
+        return (plans[&class_] = plan).get();
+    };
+
+    //! Global variables which are folded, if any.
+    Globals const * const constants;
+
+private:
+    typedef boost::unordered_map<Class const *, boost::optional<Plan> > PlanMap;
+
+    PlanMap plans; //!< Plans calculated so far.
+
+    //! Number of attributes declared so far, of the class whose scope
+    //! is being appended.
+    std::size_t declared;
+
+    //! Append the instructions for all declarations of a scope of a
+    //! class, continuing the given run of primitive attributes, if any.
+    void append(Scope const & scope, Class const & class_, Plan & plan,
+                boost::optional<std::size_t> & run) {
+        BOOST_FOREACH(Declaration const & decl, scope) {
+            Attr const *attr = boost::get<Attr>(&decl);
+            if (attr) {
+                Class const & attr_class = attr->get_class();
+                if (attr->is_array()) {
+                    end_run(run, plan);
+                    append_array(*attr, class_, plan);
+                    declare(*attr);
+                    continue;
+                };
+                if (attr_class.get_type()) {
+                    // primitive: read its raw representation
+                    std::size_t size = attr_class.get_layout().get().size;
+                    std::size_t word_size = attr_class.get_word_size();
+                    if (!run) {
+                        run = plan.size();
+                        plan.push_back(PlanOp(PlanOp::RUN, 0, 0, word_size));
+                    } else if (plan[run.get()].word_size != word_size) {
+                        // mixed word sizes: swap attributes one by one
+                        plan[run.get()].word_size = 0;
+                    };
+                    plan.push_back(PlanOp(PlanOp::READ, attr->get_index(), size, word_size));
+                    plan[run.get()].size += size;
+                    declare(*attr);
+                    continue;
+                };
+                end_run(run, plan);
+                plan.push_back(PlanOp(PlanOp::CLASS, attr->get_index()));
+                declare(*attr);
+            };
+            IfElifsElse const *ifelifselse = boost::get<IfElifsElse>(&decl);
+            if (ifelifselse) {
+                append(*ifelifselse, class_, plan, run);
+            };
+        };
+    };
+
+    //! Append the instruction for an array. Its length is compiled
+    //! like a condition; a two dimensional array is read as a single
+    //! array of arr1 times arr2 elements.
+    void append_array(Attr const & attr, Class const & class_, Plan & plan) {
+        Expr length = attr.arr1.get();
+        if (attr.arr2) {
+            length = Expr::binary(Expr::MUL, length, attr.arr2.get());
+        };
+        Class const & element_class = attr.get_class();
+        PlanOp op(PlanOp::ARRAY, attr.get_index());
+        if (element_class.is_packed()) {
+            // all elements are read at once
+            op.size = element_class.get_layout().get().size;
+            op.word_size = element_class.get_word_size();
+        } else {
+            // one by one, each of at least this size
+            op.size = element_class.get_min_size();
+            op.word_size = 0;
+        };
+        op.expr = ExprCode(length, attr_resolver(class_, declared), constants);
+        plan.push_back(op);
+    };
+
+    //! Mark an attribute as declared. An attribute of the same name in
+    //! another branch shares the index of the first one.
+    void declare(Attr const & attr) {
+        declared = std::max(declared, attr.get_index() + 1);
+    };
+
+    //! Mark all attributes of a scope as declared.
+    void declare(Scope const & scope) {
+        BOOST_FOREACH(Declaration const & decl, scope) {
+            Attr const *attr = boost::get<Attr>(&decl);
+            if (attr) {
+                declare(*attr);
+            };
+            IfElifsElse const *ifelifselse = boost::get<IfElifsElse>(&decl);
+            if (ifelifselse) {
+                declare(*ifelifselse);
+            };
+        };
+    };
+
+    //! Mark all attributes of all branches as declared.
+    void declare(IfElifsElse const & ifelifselse) {
+        BOOST_FOREACH(If const & if_, ifelifselse.ifs_) {
+            declare(if_.scope);
+        };
+        if (ifelifselse.else_) {
+            declare(ifelifselse.else_.get());
+        };
+    };
+
+    //! Finish the current run of primitive attributes, if any. A run
+    //! of a single attribute gains nothing, so its RUN is removed.
+    void end_run(boost::optional<std::size_t> & run, Plan & plan) {
+        if (!run) {
+            return;
+        };
+        if (plan.size() - run.get() == 2) {
+            plan.erase(plan.begin() + run.get());
+        } else {
+            plan[run.get()].target = plan.size();
+        };
+        run = boost::none;
+    };
+
+    //! Append the instructions for an if/elif/.../else structure.
+    //! Conditions which fold into constants are decided here: a false
+    //! branch is left out, and a true branch ends the structure. As
+    //! long as no branch remains, the run of primitive attributes
+    //! simply continues.
+    void append(IfElifsElse const & ifelifselse, Class const & class_, Plan & plan,
+                boost::optional<std::size_t> & run) {
+        // jumps to the end, one for every branch
+        std::vector<std::size_t> jumps;
+        boost::optional<std::size_t> branch;
+        bool taken = false;
+        BOOST_FOREACH(If const & if_, ifelifselse.ifs_) {
+            ExprCode expr(if_.expr, attr_resolver(class_, declared), constants);
+            if (expr.is_constant()) {
+                if (expr.get_instrs()[0].value) {
+                    append_branch(if_.scope, class_, plan, run, branch);
+                    taken = true;
+                    break;
+                };
+                continue;
+            };
+            end_run(run, plan);
+            branch = plan.size();
+            plan.push_back(PlanOp(PlanOp::BRANCH));
+            plan[branch.get()].expr = expr;
+            append_branch(if_.scope, class_, plan, run, branch);
+            jumps.push_back(plan.size());
+            plan.push_back(PlanOp(PlanOp::JUMP));
+            plan[branch.get()].target = plan.size();
+        };
+        if (!taken && ifelifselse.else_) {
+            append_branch(ifelifselse.else_.get(), class_, plan, run, branch);
+        };
+        if (!jumps.empty() && jumps.back() + 1 == plan.size()) {
+            // nothing follows the last branch, so it needs no jump
+            plan.pop_back();
+            jumps.pop_back();
+            plan[branch.get()].target = plan.size();
+        };
+        BOOST_FOREACH(std::size_t jump, jumps) {
+            plan[jump].target = plan.size();
+        };
+        // branches which are left out still declare their attributes
+        declare(ifelifselse);
+    };
+
+    //! Append the instructions of a branch: a run may only continue
+    //! into it if no branch precedes it, and never continues beyond
+    //! a branch that may be skipped.
+    void append_branch(Scope const & scope, Class const & class_, Plan & plan,
+                       boost::optional<std::size_t> & run,
+                       boost::optional<std::size_t> const & branch) {
+        if (!branch) {
+            append(scope, class_, plan, run);
+        } else {
+            end_run(run, plan);
+            append(scope, class_, plan, run);
+            end_run(run, plan);
+        };
+    };
+};
+
+//! A visitor for compiling the read plan (p) of every class.
+class declaration_compile_p_visitor
+    : public boost::static_visitor<void>
+{
+public:
+    //! Constructor.
+    declaration_compile_p_visitor(class_plan_compiler & compiler)
+        : compiler(compiler) {};
+
+    //! A class.
+    void operator()(Class & class_) const {
+        if (!compiler.constants) {
+            class_.plan = compiler(class_);
+            // plans specialized before are stale
+            class_.specialized_plans.clear();
+            class_.specialized_indices.clear();
+        } else {
+            // only keep specialized plans that differ
+            Plan const & plan = compiler(class_);
+            if (plan != class_.plan) {
+                std::pair<boost::unordered_map<Globals, std::size_t>::iterator, bool> const index =
+                    class_.specialized_indices.insert(
+                        std::make_pair(*compiler.constants, class_.specialized_plans.size()));
+                if (index.second) {
+                    if (class_.specialized_plans.size() + 1 >= (1u << PlanCache::index_bits)) {
+                        throw std::runtime_error("too many specialized plans for class '" + class_.name + "'");
+                    };
+                    class_.specialized_plans.push_back(plan);
+                } else {
+                    class_.specialized_plans[index.first->second] = plan;
+                };
+            };
+        };
+        class_.plan_cache.reset();
+        // compile the nested scope
+        if (class_.scope) {
+            class_.scope.get().compile_p(compiler);
+        };
+    };
+
+    //! An attribute.
+    void operator()(Attr &) const {};
+
+    //! An if/elif/.../else structure.
+    void operator()(IfElifsElse & ifelifselse) const {
+        BOOST_FOREACH(If & if_, ifelifselse.ifs_) {
+            // compile this if's scope
+            if_.scope.compile_p(compiler);
+        };
+        if (ifelifselse.else_) {
+            // compile the else's scope
+            ifelifselse.else_.get().compile_p(compiler);
+        };
+    };
+
+    class_plan_compiler & compiler;
+};
+
+void Scope::compile_p(class_plan_compiler & compiler)
+{
+    BOOST_FOREACH(Declaration & decl, *this) {
+        // compile all declarations
+        boost::apply_visitor(
+            declaration_compile_p_visitor(compiler), decl);
+    };
+}
+
 void Scope::compile()
 {
-    // compile local class maps and parent scopes
-    compile_lcm_ps();
+    // compile local class maps and parent scopes, and number classes
+    classes.clear();
+    compile_lcm_ps(classes);
     // compile class of every attribute and all base classes (note: we
     // do this in a separate pass, so we can use classes that are only
     // defined further on without requiring forward declarations)
     AttrMap attr_map;
     compile_a_bc(attr_map);
+    // freeze all attribute maps (note: the maps of derived classes
+    // keep referring to those of their base classes, and no map can
+    // grow once frozen, so this requires all maps to be complete)
+    compile_f();
+    // compile layouts of all classes of fixed size (note: this
+    // requires the classes of all attributes, so again we do this
+    // in a separate pass)
+    class_layout_compiler compiler;
+    compile_l_o(compiler);
+    // compile read plans (note: this requires the classes of all
+    // attributes and the layouts of primitive classes)
+    class_plan_compiler plan_compiler;
+    compile_p(plan_compiler);
+}
+
+void Scope::compile(Globals const & constants)
+{
+    class_plan_compiler plan_compiler(&constants);
+    compile_p(plan_compiler);
 }
 
 } // namespace object_models
@@ -36,6 +36,7 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <boost/spirit/include/karma.hpp>
+#include <boost/spirit/include/phoenix_bind.hpp>
 #include <boost/spirit/include/phoenix_core.hpp>
 #include <boost/spirit/include/phoenix_operator.hpp>
 #include <boost/spirit/include/phoenix_container.hpp>
@@ -61,6 +62,7 @@ public:
     engine::rule<Iterator, Class(int)> class_;
     engine::rule<Iterator, Attr(int)> attr;
     engine::rule<Iterator, Expr()> expr;
+    engine::rule<Iterator, Expr()> length;
     engine::rule<Iterator, If(int)> if_;
     engine::rule<Iterator, If(int)> elif_;
     engine::rule<Iterator, Scope(int)> else_;
@@ -92,9 +94,12 @@ public:
             << class_name // Attr.class_name
             << ' '
             << attr_name // Attr.name
+            << -length // Attr.arr1
+            << -length // Attr.arr2
             << -(eol << doc(engine::_r1 + 4)) // Attr.doc
             ;
-        expr = engine::bool_; // for now
+        expr = engine::string[engine::_1 = boost::phoenix::bind(&Expr::str, engine::_val)];
+        length = '[' << expr << ']';
         if_ =
             indent(engine::_r1)
             << "if "
@@ -135,6 +140,7 @@ public:
         class_.name("class");
         attr.name("attr");
         expr.name("expr");
+        length.name("length");
         if_.name("if");
         elif_.name("elif");
         else_.name("else");
@@ -153,6 +159,7 @@ public:
         engine::debug(class_);
         engine::debug(attr);
         engine::debug(expr);
+        engine::debug(length);
         engine::debug(if_);
         engine::debug(elif_);
         engine::debug(else_);
@@ -0,0 +1,548 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <algorithm> // std::max
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <cctype> // std::isalpha, std::isalnum
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/scope.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! Get a name which is usable in C++: keywords get an underscore.
+static std::string cpp_name(std::string const & name)
+{
+    static char const * const keywords[] = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand",
+        "bitor", "bool", "break", "case", "catch", "char", "char16_t",
+        "char32_t", "class", "compl", "const", "const_cast", "constexpr",
+        "continue", "decltype", "default", "delete", "do", "double",
+        "dynamic_cast", "else", "enum", "explicit", "export", "extern",
+        "false", "float", "for", "friend", "goto", "if", "inline", "int",
+        "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected",
+        "public", "register", "reinterpret_cast", "return", "short",
+        "signed", "sizeof", "static", "static_assert", "static_cast",
+        "struct", "switch", "template", "this", "thread_local", "throw",
+        "true", "try", "typedef", "typeid", "typename", "union",
+        "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+        "while", "xor", "xor_eq"
+    };
+    static std::set<std::string> const names(
+        keywords, keywords + sizeof(keywords) / sizeof(keywords[0]));
+    return names.count(name) ? name + "_" : name;
+};
+
+//! Get the C++ name of a primitive type.
+static char const * cpp_type(Class const & class_, std::type_info const & type)
+{
+    static char const * const names[] = {
+        "bool", "char", "signed char", "unsigned char", "short",
+        "unsigned short", "int", "unsigned int", "long", "unsigned long",
+        "long long", "unsigned long long", "float", "double"
+    };
+    boost::optional<ExprCode::Type> expr_type = ExprCode::get_type(type);
+    if (!expr_type) {
+        throw std::runtime_error(
+            "class '" + class_.name + "' has a type which is not a number");
+    };
+    return names[expr_type.get()];
+};
+
+//! Get the attributes of a scope, including those of if/elif/else
+//! declarations, in order of declaration.
+static void collect_attrs(Scope const & scope, std::vector<Attr const *> & attrs)
+{
+    BOOST_FOREACH(Declaration const & decl, scope) {
+        if (Attr const *attr = boost::get<Attr>(&decl)) {
+            attrs.push_back(attr);
+        } else if (IfElifsElse const *ifelifselse = boost::get<IfElifsElse>(&decl)) {
+            BOOST_FOREACH(If const & if_, ifelifselse->ifs_) {
+                collect_attrs(if_.scope, attrs);
+            };
+            if (ifelifselse->else_) {
+                collect_attrs(ifelifselse->else_.get(), attrs);
+            };
+        };
+    };
+};
+
+//! Get the names in an expression which are not attributes of a
+//! class, that is, the global variables.
+static void collect_globals(Expr const & expr, Class const & class_, std::set<std::string> & globals)
+{
+    switch (expr.get_op()) {
+    case Expr::CONST:
+        break;
+    case Expr::NAME:
+        if (!class_.get_attr_map().find(expr.get_name())) {
+            globals.insert(expr.get_name());
+        };
+        break;
+    case Expr::NOT:
+    case Expr::NEG:
+    case Expr::BIT_NOT:
+        collect_globals(expr.get_left(), class_, globals);
+        break;
+    default:
+        collect_globals(expr.get_left(), class_, globals);
+        collect_globals(expr.get_right(), class_, globals);
+    };
+};
+
+//! Get the length of an array, arr1 times arr2.
+static Expr array_length(Attr const & attr)
+{
+    Expr length = attr.arr1.get();
+    if (attr.arr2) {
+        length = Expr::binary(Expr::MUL, length, attr.arr2.get());
+    };
+    return length;
+};
+
+//! Get the global variables in the conditions and array lengths of a
+//! scope.
+static void collect_globals(Scope const & scope, Class const & class_, std::set<std::string> & globals)
+{
+    BOOST_FOREACH(Declaration const & decl, scope) {
+        if (Attr const *attr = boost::get<Attr>(&decl)) {
+            if (attr->is_array()) {
+                collect_globals(array_length(*attr), class_, globals);
+            };
+        } else if (IfElifsElse const *ifelifselse = boost::get<IfElifsElse>(&decl)) {
+            BOOST_FOREACH(If const & if_, ifelifselse->ifs_) {
+                collect_globals(if_.expr, class_, globals);
+                collect_globals(if_.scope, class_, globals);
+            };
+            if (ifelifselse->else_) {
+                collect_globals(ifelifselse->else_.get(), class_, globals);
+            };
+        };
+    };
+};
+
+//! Writes C++ structs, and functions for reading and writing them,
+//! for all classes of a compiled scope.
+class cpp_generator
+{
+public:
+    //! Constructor.
+    cpp_generator(std::ostream & os) : os(os) {};
+
+    //! Write a class name, as a C++ type.
+    std::string type_name(Class const & class_) const {
+        return cpp_name(class_.name);
+    };
+
+    //! Write documentation, one comment line per line.
+    void doc(boost::optional<Doc> const & doc, std::string const & indent) {
+        if (doc) {
+            BOOST_FOREACH(std::string const & line, doc.get()) {
+                std::istringstream lines(line);
+                std::string part;
+                while (std::getline(lines, part)) {
+                    os << indent << "//!" << (part.empty() ? "" : " ") << part << "\n";
+                };
+            };
+        };
+    };
+
+    //! Write the definition of a class: a typedef for primitive types
+    //! and strings, and a struct otherwise.
+    void definition(Class const & class_) {
+        doc(class_.doc, "");
+        if (class_.get_type()) {
+            os << "typedef " << cpp_type(class_, class_.get_type().get())
+               << " " << type_name(class_) << ";\n\n";
+            return;
+        };
+        if (class_.is_sized_string()) {
+            os << "typedef pyffi::object_models::ByteView " << type_name(class_) << ";\n\n";
+            return;
+        };
+        os << "struct " << type_name(class_);
+        if (class_.get_base_class()) {
+            os << " : " << type_name(class_.get_base_class().get());
+        };
+        os << " {\n";
+        std::vector<Attr const *> attrs;
+        if (class_.scope) {
+            collect_attrs(class_.scope.get(), attrs);
+        };
+        BOOST_FOREACH(Attr const * attr, attrs) {
+            doc(attr->doc, "    ");
+            if (attr->is_array()) {
+                os << "    std::vector<" << type_name(attr->get_class()) << "> "
+                   << cpp_name(attr->name) << ";\n";
+            } else {
+                os << "    " << type_name(attr->get_class()) << " "
+                   << cpp_name(attr->name) << "{};\n";
+            };
+        };
+        os << "};\n\n";
+        if (is_bulk(class_)) {
+            os << "static_assert(sizeof(" << type_name(class_) << ") == "
+               << class_.get_layout().get().size << ", \""
+               << type_name(class_) << " must be packed\");\n\n";
+        };
+    };
+
+    //! Write the declarations of the read and write functions of a
+    //! struct.
+    void declaration(Class const & class_) {
+        if (!is_struct(class_)) {
+            return;
+        };
+        os << "void read(" << type_name(class_) << " & value, "
+           << "pyffi::object_models::ByteReader & reader);\n";
+        os << "void write(" << type_name(class_) << " const & value, "
+           << "pyffi::object_models::ByteWriter & writer);\n";
+    };
+
+    //! Write the read and write functions of a struct.
+    void functions(Class const & class_) {
+        if (!is_struct(class_)) {
+            return;
+        };
+        function(class_, true);
+        function(class_, false);
+    };
+
+private:
+    std::ostream & os;
+
+    //! Whether a class is written as a struct.
+    static bool is_struct(Class const & class_) {
+        return !class_.get_type() && !class_.is_sized_string();
+    };
+
+    //! Whether arrays of a class are read and written at once.
+    static bool is_bulk(Class const & class_) {
+        return class_.is_packed() && class_.get_layout().get().size > 0;
+    };
+
+    //! Write the read (or write) function of a struct.
+    void function(Class const & class_, bool read) {
+        std::string const name = read ? "read" : "write";
+        std::string const stream = read ? "reader" : "writer";
+        os << "inline void " << name << "(" << type_name(class_)
+           << (read ? " & value, pyffi::object_models::ByteReader & reader)\n"
+               : " const & value, pyffi::object_models::ByteWriter & writer)\n");
+        os << "{\n";
+        if (class_.get_base_class()) {
+            os << "    " << name << "(static_cast<"
+               << type_name(class_.get_base_class().get())
+               << (read ? " &" : " const &") << ">(value), " << stream << ");\n";
+        };
+        if (class_.scope) {
+            std::set<std::string> globals;
+            collect_globals(class_.scope.get(), class_, globals);
+            if (!globals.empty()) {
+                os << "    pyffi::object_models::Globals const * const globals = "
+                   << stream << ".get_globals();\n";
+            };
+            BOOST_FOREACH(std::string const & global, globals) {
+                os << "    static pyffi::object_models::generated::GlobalSlot const global_"
+                   << global << "(\"" << global << "\");\n";
+            };
+            body(class_.scope.get(), class_, read, "    ");
+        };
+        os << "}\n\n";
+    };
+
+    //! Write the statements for all declarations of a scope.
+    void body(Scope const & scope, Class const & class_, bool read, std::string const & indent) {
+        BOOST_FOREACH(Declaration const & decl, scope) {
+            if (Attr const *attr = boost::get<Attr>(&decl)) {
+                if (attr->is_array()) {
+                    array(*attr, class_, read, indent);
+                } else {
+                    element(attr->get_class(), "value." + cpp_name(attr->name), read, indent);
+                };
+            } else if (IfElifsElse const *ifelifselse = boost::get<IfElifsElse>(&decl)) {
+                for (std::size_t i = 0; i < ifelifselse->ifs_.size(); i++) {
+                    If const & if_ = ifelifselse->ifs_[i];
+                    os << (i ? " else if (" : indent + "if (")
+                       << expr(if_.expr, class_) << ") {\n";
+                    body(if_.scope, class_, read, indent + "    ");
+                    os << indent << "}";
+                };
+                if (ifelifselse->else_) {
+                    os << " else {\n";
+                    body(ifelifselse->else_.get(), class_, read, indent + "    ");
+                    os << indent << "}";
+                };
+                os << ";\n";
+            };
+        };
+    };
+
+    //! Write the statement which reads (or writes) a single value.
+    void element(Class const & element_class, std::string const & value, bool read,
+                 std::string const & indent) {
+        if (element_class.get_type()) {
+            os << indent << "pyffi::object_models::generated::"
+               << (read ? "read_value(reader, " : "write_value(writer, ")
+               << value << ");\n";
+        } else if (element_class.is_sized_string()) {
+            os << indent << "pyffi::object_models::generated::"
+               << (read ? "read_sized_string<" : "write_sized_string<")
+               << cpp_type(element_class, element_class.get_length_type().get())
+               << (read ? ">(reader, " : ">(writer, ") << value << ");\n";
+        } else {
+            os << indent << (read ? "read(" : "write(") << value
+               << (read ? ", reader);\n" : ", writer);\n");
+        };
+    };
+
+    //! Write the statements which read (or write) an array.
+    void array(Attr const & attr, Class const & class_, bool read, std::string const & indent) {
+        Class const & element_class = attr.get_class();
+        std::string const value = "value." + cpp_name(attr.name);
+        // as PlanOp::size of an ARRAY
+        std::size_t const element_size =
+            element_class.is_packed()
+            ? element_class.get_layout().get().size : element_class.get_min_size();
+        os << indent << "{\n";
+        os << indent << "    std::size_t const length = pyffi::object_models::generated::array_length(\n"
+           << indent << "        " << expr(array_length(attr), class_) << ", "
+           << element_size << ");\n";
+        if (!read) {
+            os << indent << "    pyffi::object_models::generated::check_length("
+               << value << ".size(), length);\n";
+        };
+        if (element_class.get_type() || is_bulk(element_class)) {
+            os << indent << "    pyffi::object_models::generated::"
+               << (read ? "read_values(reader, " : "write_values(writer, ") << value
+               << (read ? ", length, " : ", ") << element_class.get_word_size() << ");\n";
+        } else {
+            if (read) {
+                // the length comes from the file: check it against the
+                // remaining bytes before allocating the elements, with
+                // at least one byte per element, as Plan::read
+                os << indent << "    reader.require(length * "
+                   << std::max<std::size_t>(element_size, 1) << ");\n";
+                os << indent << "    " << value << ".resize(length);\n";
+            };
+            os << indent << "    for (std::size_t i = 0; i < length; i++) {\n";
+            element(element_class, value + "[i]", read, indent + "        ");
+            os << indent << "    };\n";
+        };
+        os << indent << "};\n";
+    };
+
+    //! Convert an expression into C++, with the semantics of
+    //! ExprCode::apply: operations which may overflow, or divide by
+    //! zero, are done by apply itself, which the compiler inlines.
+    //! Only the top level expression goes without parentheses.
+    std::string expr(Expr const & expr, Class const & class_, bool top = true) const {
+        std::ostringstream result;
+        switch (expr.get_op()) {
+        case Expr::CONST: {
+            long long value = expr.get_value();
+            if (value == std::numeric_limits<long long>::min()) {
+                result << "(-" << std::numeric_limits<long long>::max() << "LL - 1)";
+            } else if (expr.is_hex() && value >= 0) {
+                result << "0x" << std::hex << std::uppercase << value << "LL";
+            } else {
+                result << value << "LL";
+            };
+            break;
+        }
+        case Expr::NAME:
+            if (class_.get_attr_map().find(expr.get_name())) {
+                result << "pyffi::object_models::generated::attr_value(value."
+                       << cpp_name(expr.get_name()) << ")";
+            } else {
+                result << "global_" << expr.get_name() << ".get(globals)";
+            };
+            break;
+        case Expr::NOT:
+            result << "!" << this->expr(expr.get_left(), class_, false);
+            break;
+        case Expr::BIT_NOT:
+            result << "~" << this->expr(expr.get_left(), class_, false);
+            break;
+        case Expr::NEG:
+            result << "pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::NEG, "
+                   << this->expr(expr.get_left(), class_, false) << ")";
+            break;
+        case Expr::MUL:
+        case Expr::DIV:
+        case Expr::MOD:
+        case Expr::ADD:
+        case Expr::SUB:
+        case Expr::SHL:
+        case Expr::SHR:
+            result << "pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::"
+                   << op_name(expr.get_op()) << ", "
+                   << this->expr(expr.get_left(), class_, false) << ", "
+                   << this->expr(expr.get_right(), class_, false) << ")";
+            break;
+        default:
+            // comparisons, bitwise and logical operations cannot overflow
+            result << (top ? "" : "(") << this->expr(expr.get_left(), class_, false)
+                   << " " << op_symbol(expr.get_op()) << " "
+                   << this->expr(expr.get_right(), class_, false) << (top ? "" : ")");
+        };
+        return result.str();
+    };
+
+    //! Name of an arithmetic operation.
+    static char const * op_name(Expr::Op op) {
+        static char const * const names[] = {
+            "CONST", "NAME", "NOT", "NEG", "BIT_NOT", "MUL", "DIV", "MOD",
+            "ADD", "SUB", "SHL", "SHR"
+        };
+        return names[op];
+    };
+
+    //! Symbol of a comparison, bitwise, or logical operation.
+    static char const * op_symbol(Expr::Op op) {
+        static char const * const symbols[] = {
+            "<", "<=", ">", ">=", "==", "!=", "&", "^", "|", "&&", "||"
+        };
+        return symbols[op - Expr::LT];
+    };
+};
+
+//! Append a class to the order of definition after the classes it
+//! depends on: its base class, and the classes of its attributes.
+static void order_class(Class const & class_, std::vector<Class const *> & order,
+                        boost::unordered_map<Class const *, bool> & done)
+{
+    boost::unordered_map<Class const *, bool>::const_iterator it = done.find(&class_);
+    if (it != done.end()) {
+        if (!it->second) {
+            throw std::runtime_error(
+                "class '" + class_.name + "' contains itself, and has no C++ struct");
+        };
+        return;
+    };
+    // mark class as being ordered
+    done[&class_] = false;
+    if (class_.get_base_class()) {
+        order_class(class_.get_base_class().get(), order, done);
+    };
+    if (class_.scope && !class_.get_type() && !class_.is_sized_string()) {
+        std::vector<Attr const *> attrs;
+        collect_attrs(class_.scope.get(), attrs);
+        BOOST_FOREACH(Attr const * attr, attrs) {
+            order_class(attr->get_class(), order, done);
+        };
+    };
+    done[&class_] = true;
+    order.push_back(&class_);
+};
+
+//! Check that a name is a C++ identifier.
+static bool is_identifier(std::string const & name)
+{
+    if (name.empty() || !(std::isalpha(name[0]) || name[0] == '_')) {
+        return false;
+    };
+    for (std::size_t i = 1; i < name.size(); i++) {
+        if (!(std::isalnum(name[i]) || name[i] == '_')) {
+            return false;
+        };
+    };
+    return true;
+};
+
+bool Scope::generate_cpp(std::ostream & out, std::string const & namespace_name) const
+{
+    if (!is_identifier(namespace_name)) {
+        throw std::runtime_error("invalid namespace name '" + namespace_name + "'");
+    };
+    if (!empty() && classes.empty()) {
+        throw std::runtime_error("scope must be compiled before generating C++");
+    };
+    std::vector<Class const *> order;
+    boost::unordered_map<Class const *, bool> done;
+    boost::unordered_set<std::string> names;
+    BOOST_FOREACH(Class const * class_, classes) {
+        if (!names.insert(class_->name).second) {
+            throw std::runtime_error(
+                "class name '" + class_->name + "' is not unique, and has no C++ struct");
+        };
+        order_class(*class_, order, done);
+    };
+
+    std::string const guard = "PYFFI_GENERATED_" + boost::algorithm::to_upper_copy(namespace_name) + "_HPP_INCLUDED";
+    out << "// generated by pyffi, do not edit\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n"
+        << "\n"
+        << "#include <cstddef>\n"
+        << "#include <vector>\n"
+        << "\n"
+        << "#include \"pyffi/object_models/generated.hpp\"\n"
+        << "\n"
+        << "namespace " << namespace_name << "\n"
+        << "{\n"
+        << "\n";
+    cpp_generator generator(out);
+    BOOST_FOREACH(Class const * class_, order) {
+        generator.definition(*class_);
+    };
+    BOOST_FOREACH(Class const * class_, order) {
+        generator.declaration(*class_);
+    };
+    out << "\n";
+    BOOST_FOREACH(Class const * class_, order) {
+        generator.functions(*class_);
+    };
+    out << "} // namespace " << namespace_name << "\n"
+        << "\n"
+        << "#endif\n";
+    return true;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -36,6 +36,7 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <boost/spirit/include/qi.hpp>
+#include <boost/spirit/include/phoenix_bind.hpp>
 #include <boost/spirit/include/phoenix_core.hpp>
 #include <boost/spirit/include/phoenix_operator.hpp>
 #include <stdexcept>
@@ -59,6 +60,7 @@ public:
     engine::rule<Iterator, Class(int)> class_;
     engine::rule<Iterator, Attr(int)> attr;
     engine::rule<Iterator, Expr()> expr;
+    engine::rule<Iterator, Expr()> length;
     engine::rule<Iterator, If(int)> if_;
     engine::rule<Iterator, If(int)> elif_;
     engine::rule<Iterator, Scope(int)> else_;
@@ -90,8 +92,19 @@ public:
             >> class_name // Attr.class_name
             >> ' '
             >> attr_name // Attr.name
+            >> -length // Attr.arr1
+            >> -length // Attr.arr2
             >> -(eol >> doc(engine::_r1 + 4)); // Attr.doc
-        expr = engine::bool_; // for now
+        // the rest of the line is parsed by Expr::parse
+        expr =
+            engine::as_string[+(engine::char_ - engine::eol)]
+            [engine::_val = boost::phoenix::bind(&Expr::parse, engine::_1)];
+        // the text between brackets is parsed by Expr::parse
+        length =
+            '['
+            >> engine::as_string[+(engine::char_ - ']' - engine::eol)]
+            [engine::_val = boost::phoenix::bind(&Expr::parse, engine::_1)]
+            >> ']';
         if_ %=
             indent(engine::_r1)
             >> "if "
@@ -130,6 +143,7 @@ public:
         class_.name("class");
         attr.name("attr");
         expr.name("expr");
+        length.name("length");
         if_.name("if");
         elif_.name("elif");
         else_.name("else");
@@ -148,6 +162,7 @@ public:
         engine::debug(class_);
         engine::debug(attr);
         engine::debug(expr);
+        engine::debug(length);
         engine::debug(if_);
         engine::debug(elif_);
         engine::debug(else_);
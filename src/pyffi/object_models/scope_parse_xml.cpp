@@ -35,9 +35,13 @@ POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
+#include <cctype> // std::isalpha, std::isalnum (single character)
+#include <vector>
 
 #include "pyffi/object_models/scope.hpp"
 
@@ -51,6 +55,139 @@ namespace object_models
 {
 
 using namespace boost::property_tree;
+namespace algorithm = boost::algorithm;
+
+//! Convert a version string, such as 20.0.0.5, into a number, such as
+//! 0x14000005: one byte per part, most significant first.
+static long long parse_xml_version(std::string const & text)
+{
+    if (text == "3.03") {
+        // special case: this is how such files store their version
+        return 0x03000300;
+    };
+    std::vector<std::string> parts;
+    algorithm::split(parts, text, algorithm::is_any_of("."));
+    if (parts.size() > 4) {
+        throw std::runtime_error("invalid version '" + text + "'");
+    };
+    long long result = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+        long long part = 0;
+        if (i < parts.size()) {
+            try {
+                part = boost::lexical_cast<unsigned int>(parts[i]);
+            } catch (boost::bad_lexical_cast const &) {
+                throw std::runtime_error("invalid version '" + text + "'");
+            };
+            if (part > 0xFF) {
+                throw std::runtime_error("invalid version '" + text + "'");
+            };
+        };
+        result = (result << 8) | part;
+    };
+    return result;
+};
+
+//! The global variable which version ranges (ver1 and ver2) and
+//! version conditions compare against. Attribute names are lower case
+//! (see Scope::fix), so it can never resolve to an attribute, such as
+//! the version in a header.
+static char const * const xml_version_name = "Version";
+
+//! Parse a condition or array length of the xml format, whose names
+//! contain spaces and capitals: every name is converted like an
+//! attribute name (see Scope::fix), so "User Version 2 > 26" becomes
+//! "user_version_2 > 26". Dotted versions, such as 20.2.0.7, become
+//! numbers (see parse_xml_version).
+/*!
+  \param text The expression.
+  \param version_cond Whether the expression is a version condition
+                      (vercond), whose version is the global version
+                      (see xml_version_name) rather than an attribute.
+*/
+static Expr parse_xml_expr(std::string const & text, bool version_cond = false)
+{
+    std::string result;
+    std::string::const_iterator it = text.begin();
+    while (it != text.end()) {
+        if (std::isalpha(*it) || *it == '_') {
+            // names run until the next operator or parenthesis
+            std::string name;
+            while (it != text.end() && (std::isalnum(*it) || *it == '_' || *it == ' ')) {
+                name += *it++;
+            };
+            algorithm::trim(name);
+            algorithm::find_format_all(
+                name,
+                algorithm::token_finder(
+                    !algorithm::is_alnum(),
+                    algorithm::token_compress_on),
+                algorithm::const_formatter("_"));
+            algorithm::to_lower(name);
+            if (version_cond && name == "version") {
+                name = xml_version_name;
+            };
+            result += name + " ";
+        } else if (std::isdigit(*it)) {
+            // numbers, including hexadecimal ones and dotted versions
+            std::string number;
+            while (it != text.end() && (std::isalnum(*it) || *it == '.')) {
+                number += *it++;
+            };
+            if (number.find('.') != std::string::npos) {
+                result += boost::lexical_cast<std::string>(parse_xml_version(number));
+            } else {
+                result += number;
+            };
+        } else {
+            result += *it++;
+        };
+    };
+    return Expr::parse(result);
+};
+
+//! Get the condition of an xml element from its version range (ver1
+//! and ver2), user versions (userver and userver2), and conditions
+//! (vercond and cond), or none if it has no condition.
+static boost::optional<Expr> parse_xml_condition(ptree const & add)
+{
+    std::vector<Expr> conditions;
+    boost::optional<std::string> value;
+    if ((value = add.get_optional<std::string>("<xmlattr>.ver1"))) {
+        conditions.push_back(Expr::binary(
+                                 Expr::GE, Expr::name(xml_version_name),
+                                 Expr::constant(parse_xml_version(value.get()), true)));
+    };
+    if ((value = add.get_optional<std::string>("<xmlattr>.ver2"))) {
+        conditions.push_back(Expr::binary(
+                                 Expr::LE, Expr::name(xml_version_name),
+                                 Expr::constant(parse_xml_version(value.get()), true)));
+    };
+    if ((value = add.get_optional<std::string>("<xmlattr>.userver"))) {
+        conditions.push_back(Expr::binary(
+                                 Expr::EQ, Expr::name("user_version"),
+                                 Expr::constant(boost::lexical_cast<long long>(value.get()))));
+    };
+    if ((value = add.get_optional<std::string>("<xmlattr>.userver2"))) {
+        conditions.push_back(Expr::binary(
+                                 Expr::EQ, Expr::name("user_version_2"),
+                                 Expr::constant(boost::lexical_cast<long long>(value.get()))));
+    };
+    if ((value = add.get_optional<std::string>("<xmlattr>.vercond"))) {
+        conditions.push_back(parse_xml_expr(value.get(), true));
+    };
+    if ((value = add.get_optional<std::string>("<xmlattr>.cond"))) {
+        conditions.push_back(parse_xml_expr(value.get()));
+    };
+    if (conditions.empty()) {
+        return boost::none;
+    };
+    Expr result = conditions[0];
+    for (std::size_t i = 1; i < conditions.size(); i++) {
+        result = Expr::binary(Expr::AND, result, conditions[i]);
+    };
+    return result;
+};
 
 bool Scope::parse_xml(std::istream & in)
 {
@@ -63,7 +200,10 @@ bool Scope::parse_xml(std::istream & in)
     //info_parser::write_info(std::cout, pt); // DEBUG
 
     BOOST_FOREACH(ptree::value_type & decl, pt.get_child("niftoolsxml")) {
-        if (decl.first == "basic") {
+        if (decl.first == "version") {
+            versions.push_back(
+                parse_xml_version(decl.second.get<std::string>("<xmlattr>.num")));
+        } else if (decl.first == "basic") {
             // set class name
             Class class_(decl.second.get<std::string>("<xmlattr>.name"));
             // set class docs (the fixer will split the lines and
@@ -78,15 +218,37 @@ bool Scope::parse_xml(std::istream & in)
             // set base class name
             class_.base_name = decl.second.get_optional<std::string>("<xmlattr>.inherit");
             Scope scope;
+            // condition of the last declaration, if it is an if
+            boost::optional<Expr> last_condition;
             BOOST_FOREACH(ptree::value_type & add, decl.second) {
                 if (add.first == "add") {
                     Attr attr(
                         add.second.get<std::string>("<xmlattr>.type"),
                         add.second.get<std::string>("<xmlattr>.name"));
+                    boost::optional<std::string> length;
+                    if ((length = add.second.get_optional<std::string>("<xmlattr>.arr1"))) {
+                        attr.arr1 = parse_xml_expr(length.get());
+                    };
+                    if ((length = add.second.get_optional<std::string>("<xmlattr>.arr2"))) {
+                        attr.arr2 = parse_xml_expr(length.get());
+                    };
                     Doc doc;
                     doc.push_back(add.second.data());
                     attr.doc = doc;
-                    scope.push_back(attr);
+                    boost::optional<Expr> condition = parse_xml_condition(add.second);
+                    if (!condition) {
+                        scope.push_back(attr);
+                    } else if (condition == last_condition) {
+                        // same condition: extend the last if
+                        boost::get<IfElifsElse>(scope.back()).ifs_[0].scope.push_back(attr);
+                    } else {
+                        IfElifsElse ifelifselse;
+                        ifelifselse.ifs_.resize(1);
+                        ifelifselse.ifs_[0].expr = condition.get();
+                        ifelifselse.ifs_[0].scope.push_back(attr);
+                        scope.push_back(ifelifselse);
+                    };
+                    last_condition = condition;
                 };
             };
             if (!scope.empty()) {
@@ -0,0 +1,172 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <atomic>
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "pyffi/object_models/symbol.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+//! The table of all interned names. Names are only ever added, so
+//! lookups need no lock: they probe an open addressing hash table of
+//! pointers to the names, whose slots are atomic. Interning takes a
+//! lock, and publishes a larger copy of the slots when they fill up;
+//! old slots are kept, since lookups may still be probing them.
+class SymbolTable
+{
+public:
+    //! An interned name, along with its id.
+    struct Entry {
+        Entry(std::string const & name, std::size_t id) : name(name), id(id) {};
+        std::string const name; //!< The name.
+        std::size_t const id;   //!< The id.
+    };
+
+    //! Constructor; the empty name comes first.
+    SymbolTable() : mutex(), entries(), all_slots(), slots() {
+        grow(64);
+        intern(std::string());
+    };
+
+    //! Find a name, without locking.
+    Entry const * find(std::string const & name) const {
+        Slots const *current = slots.load(std::memory_order_acquire);
+        std::size_t i = boost::hash<std::string>()(name) & current->mask;
+        while (true) {
+            Entry const *entry = current->slots[i].load(std::memory_order_acquire);
+            if (!entry || entry->name == name) {
+                return entry;
+            };
+            i = (i + 1) & current->mask;
+        };
+    };
+
+    //! Find a name, adding it if it is not in the table yet.
+    Entry const & intern(std::string const & name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry const *entry = find(name);
+        if (entry) {
+            return *entry;
+        };
+        Slots const *current = slots.load(std::memory_order_relaxed);
+        if (2 * (entries.size() + 1) > current->mask + 1) {
+            // keep the table at most half full
+            grow(2 * (current->mask + 1));
+        };
+        entries.push_back(Entry(name, entries.size()));
+        insert(*all_slots.back(), entries.back());
+        return entries.back();
+    };
+
+private:
+    //! Slots of the hash table, a power of two of them.
+    struct Slots {
+        explicit Slots(std::size_t size)
+            : mask(size - 1), slots(new std::atomic<Entry const *>[size]()) {};
+        std::size_t const mask; //!< Number of slots, minus one.
+        std::unique_ptr<std::atomic<Entry const *>[]> slots; //!< The slots.
+    };
+
+    //! Store an entry in its slot; only called with the lock held.
+    static void insert(Slots & slots, Entry const & entry) {
+        std::size_t i = boost::hash<std::string>()(entry.name) & slots.mask;
+        while (slots.slots[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & slots.mask;
+        };
+        slots.slots[i].store(&entry, std::memory_order_release);
+    };
+
+    //! Publish slots of the given size, holding all entries.
+    void grow(std::size_t size) {
+        all_slots.emplace_back(new Slots(size));
+        BOOST_FOREACH(Entry const & entry, entries) {
+            insert(*all_slots.back(), entry);
+        };
+        slots.store(all_slots.back().get(), std::memory_order_release);
+    };
+
+    std::mutex mutex;           //!< Serializes interning.
+    std::deque<Entry> entries;  //!< All names, by id; they never move.
+    std::vector<std::unique_ptr<Slots> > all_slots; //!< All slots ever published.
+    std::atomic<Slots const *> slots; //!< The current slots.
+};
+
+//! Get the table, created on first use.
+static SymbolTable & symbol_table()
+{
+    static SymbolTable table;
+    return table;
+};
+
+//! The empty name, without locking the table.
+static std::string const & empty_name()
+{
+    static std::string const name;
+    return name;
+};
+
+Symbol::Symbol() : id(0), name(&empty_name()) {};
+
+Symbol::Symbol(std::string const & name)
+{
+    SymbolTable::Entry const & entry = symbol_table().intern(name);
+    this->id = entry.id;
+    this->name = &entry.name;
+};
+
+boost::optional<Symbol> Symbol::find(std::string const & name)
+{
+    SymbolTable::Entry const *entry = symbol_table().find(name);
+    if (!entry) {
+        return boost::none;
+    };
+    return Symbol(entry->id, &entry->name);
+};
+
+} // namespace object_models
+
+} // namespace pyffi
@@ -0,0 +1,102 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "pyffi/object_models/value.hpp"
+
+namespace pyffi
+{
+
+namespace object_models
+{
+
+Value::Value(Value const & other)
+    : tag(0), arena(0)
+{
+    if (other.tag) {
+        other.tag->copy(*this, other);
+    };
+};
+
+Value::Value(Value const & other, Arena * arena)
+    : tag(0), arena(arena)
+{
+    if (other.tag) {
+        other.tag->copy(*this, other);
+    };
+};
+
+Value::Value(Value && other, Arena * arena)
+    : tag(0), arena(arena)
+{
+    *this = std::move(other);
+};
+
+Value & Value::operator=(Value const & other)
+{
+    if (this == &other) {
+        return *this;
+    };
+    if (!other.tag) {
+        clear();
+    } else if (tag == other.tag) {
+        tag->assign(*this, other);
+    } else {
+        Value copy(arena);
+        other.tag->copy(copy, other);
+        *this = std::move(copy);
+    };
+    return *this;
+};
+
+Value & Value::operator=(Value && other)
+{
+    if (arena != other.arena && !other.is_inline()) {
+        // cannot steal the content if it resides elsewhere
+        return *this = static_cast<Value const &>(other);
+    };
+    if (this != &other) {
+        clear();
+        tag = other.tag;
+        storage = other.storage;
+        other.tag = 0;
+    };
+    return *this;
+};
+
+} // namespace object_models
+
+} // namespace pyffi
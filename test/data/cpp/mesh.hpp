@@ -0,0 +1,177 @@
+// generated by pyffi, do not edit
+#ifndef PYFFI_GENERATED_MESH_HPP_INCLUDED
+#define PYFFI_GENERATED_MESH_HPP_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include "pyffi/object_models/generated.hpp"
+
+namespace mesh
+{
+
+typedef unsigned short UShort;
+
+typedef unsigned int UInt;
+
+typedef float Float;
+
+typedef pyffi::object_models::ByteView SizedString;
+
+//! A vector.
+struct Vector3 {
+    Float x{};
+    Float y{};
+    Float z{};
+};
+
+static_assert(sizeof(Vector3) == 12, "Vector3 must be packed");
+
+//! Base of all objects.
+struct Object {
+    //! The name.
+    SizedString name{};
+};
+
+struct Mesh : Object {
+    UShort num_vertices{};
+    std::vector<Vector3> vertices;
+    UShort flags{};
+    UInt old_flags{};
+    UShort num_uv_sets{};
+    std::vector<Float> uvs;
+    UShort num_names{};
+    std::vector<SizedString> names;
+    UShort num_children{};
+    std::vector<Object> children;
+    UInt default_{};
+};
+
+void read(Vector3 & value, pyffi::object_models::ByteReader & reader);
+void write(Vector3 const & value, pyffi::object_models::ByteWriter & writer);
+void read(Object & value, pyffi::object_models::ByteReader & reader);
+void write(Object const & value, pyffi::object_models::ByteWriter & writer);
+void read(Mesh & value, pyffi::object_models::ByteReader & reader);
+void write(Mesh const & value, pyffi::object_models::ByteWriter & writer);
+
+inline void read(Vector3 & value, pyffi::object_models::ByteReader & reader)
+{
+    pyffi::object_models::generated::read_value(reader, value.x);
+    pyffi::object_models::generated::read_value(reader, value.y);
+    pyffi::object_models::generated::read_value(reader, value.z);
+}
+
+inline void write(Vector3 const & value, pyffi::object_models::ByteWriter & writer)
+{
+    pyffi::object_models::generated::write_value(writer, value.x);
+    pyffi::object_models::generated::write_value(writer, value.y);
+    pyffi::object_models::generated::write_value(writer, value.z);
+}
+
+inline void read(Object & value, pyffi::object_models::ByteReader & reader)
+{
+    pyffi::object_models::generated::read_sized_string<unsigned int>(reader, value.name);
+}
+
+inline void write(Object const & value, pyffi::object_models::ByteWriter & writer)
+{
+    pyffi::object_models::generated::write_sized_string<unsigned int>(writer, value.name);
+}
+
+inline void read(Mesh & value, pyffi::object_models::ByteReader & reader)
+{
+    read(static_cast<Object &>(value), reader);
+    pyffi::object_models::Globals const * const globals = reader.get_globals();
+    static pyffi::object_models::generated::GlobalSlot const global_version("version");
+    pyffi::object_models::generated::read_value(reader, value.num_vertices);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_vertices), 12);
+        pyffi::object_models::generated::read_values(reader, value.vertices, length, 4);
+    };
+    if (global_version.get(globals) >= 0x14000005LL) {
+        pyffi::object_models::generated::read_value(reader, value.flags);
+    } else {
+        pyffi::object_models::generated::read_value(reader, value.old_flags);
+    };
+    pyffi::object_models::generated::read_value(reader, value.num_uv_sets);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::MUL, pyffi::object_models::generated::attr_value(value.num_uv_sets), pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::MUL, 2LL, pyffi::object_models::generated::attr_value(value.num_vertices))), 4);
+        pyffi::object_models::generated::read_values(reader, value.uvs, length, 4);
+    };
+    pyffi::object_models::generated::read_value(reader, value.num_names);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_names), 4);
+        reader.require(length * 4);
+        value.names.resize(length);
+        for (std::size_t i = 0; i < length; i++) {
+            pyffi::object_models::generated::read_sized_string<unsigned int>(reader, value.names[i]);
+        };
+    };
+    pyffi::object_models::generated::read_value(reader, value.num_children);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_children), 4);
+        reader.require(length * 4);
+        value.children.resize(length);
+        for (std::size_t i = 0; i < length; i++) {
+            read(value.children[i], reader);
+        };
+    };
+    if (((pyffi::object_models::generated::attr_value(value.flags) & 0x1LL) != 0LL) && (pyffi::object_models::generated::attr_value(value.num_vertices) > 1LL)) {
+        pyffi::object_models::generated::read_value(reader, value.default_);
+    };
+}
+
+inline void write(Mesh const & value, pyffi::object_models::ByteWriter & writer)
+{
+    write(static_cast<Object const &>(value), writer);
+    pyffi::object_models::Globals const * const globals = writer.get_globals();
+    static pyffi::object_models::generated::GlobalSlot const global_version("version");
+    pyffi::object_models::generated::write_value(writer, value.num_vertices);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_vertices), 12);
+        pyffi::object_models::generated::check_length(value.vertices.size(), length);
+        pyffi::object_models::generated::write_values(writer, value.vertices, 4);
+    };
+    if (global_version.get(globals) >= 0x14000005LL) {
+        pyffi::object_models::generated::write_value(writer, value.flags);
+    } else {
+        pyffi::object_models::generated::write_value(writer, value.old_flags);
+    };
+    pyffi::object_models::generated::write_value(writer, value.num_uv_sets);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::MUL, pyffi::object_models::generated::attr_value(value.num_uv_sets), pyffi::object_models::ExprCode::apply(pyffi::object_models::Expr::MUL, 2LL, pyffi::object_models::generated::attr_value(value.num_vertices))), 4);
+        pyffi::object_models::generated::check_length(value.uvs.size(), length);
+        pyffi::object_models::generated::write_values(writer, value.uvs, 4);
+    };
+    pyffi::object_models::generated::write_value(writer, value.num_names);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_names), 4);
+        pyffi::object_models::generated::check_length(value.names.size(), length);
+        for (std::size_t i = 0; i < length; i++) {
+            pyffi::object_models::generated::write_sized_string<unsigned int>(writer, value.names[i]);
+        };
+    };
+    pyffi::object_models::generated::write_value(writer, value.num_children);
+    {
+        std::size_t const length = pyffi::object_models::generated::array_length(
+            pyffi::object_models::generated::attr_value(value.num_children), 4);
+        pyffi::object_models::generated::check_length(value.children.size(), length);
+        for (std::size_t i = 0; i < length; i++) {
+            write(value.children[i], writer);
+        };
+    };
+    if (((pyffi::object_models::generated::attr_value(value.flags) & 0x1LL) != 0LL) && (pyffi::object_models::generated::attr_value(value.num_vertices) > 1LL)) {
+        pyffi::object_models::generated::write_value(writer, value.default_);
+    };
+}
+
+} // namespace mesh
+
+#endif
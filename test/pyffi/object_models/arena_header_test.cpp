@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/arena.hpp"
+int main()
+{
+    pyffi::object_models::Arena arena;
+    return 0;
+};
@@ -0,0 +1,221 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include "pyffi/object_models/scope.hpp"
+#include "pyffi/object_models/instance.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(arena_test_suite)
+
+BOOST_AUTO_TEST_CASE(arena_allocate_test)
+{
+    Arena arena(64);
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 0);
+
+    // allocations are aligned and do not overlap
+    char *a = static_cast<char *>(arena.allocate(1, 1));
+    char *b = static_cast<char *>(arena.allocate(8, 8));
+    char *c = static_cast<char *>(arena.allocate(2, 2));
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(b) % 8, 0);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(c) % 2, 0);
+    BOOST_CHECK(a < b);
+    BOOST_CHECK(b + 8 <= c);
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+
+    // large allocations get a block of their own
+    BOOST_CHECK(arena.allocate(1000, 4));
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 2);
+
+    // the first block is kept on release, and reused
+    arena.release();
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+    BOOST_CHECK_EQUAL(arena.allocate(1, 1), a);
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocate_align_past_end_test)
+{
+    // a block which is full up to a few bytes short of an aligned
+    // position: aligning passes its end, so a new block is needed
+    Arena arena(64);
+    char *a = static_cast<char *>(arena.allocate(100, 4));
+    char *b = static_cast<char *>(arena.allocate(8, 8));
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 2);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(b) % 8, 0);
+    BOOST_CHECK(b + 8 <= a || a + 100 <= b);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_test)
+{
+    Arena arena;
+    std::vector<int, ArenaAllocator<int> > v((ArenaAllocator<int>(&arena)));
+    v.push_back(1);
+    v.push_back(2);
+    BOOST_CHECK_EQUAL(v.get_allocator().get_arena(), &arena);
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+
+    // copies reside on the heap
+    std::vector<int, ArenaAllocator<int> > w(v);
+    BOOST_CHECK(!w.get_allocator().get_arena());
+    BOOST_CHECK_EQUAL(w[1], 2);
+}
+
+BOOST_AUTO_TEST_CASE(arena_instance_test)
+{
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    // class Line:
+    //     Vec start
+    //     Vec end
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        Class Line("Line");
+        Line.scope = Scope();
+        Line.scope.get().push_back(Attr("Vec", "start"));
+        Line.scope.get().push_back(Attr("Vec", "end"));
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        scope.push_back(Line);
+    }
+    get<Class>(scope[0]).set_type<int>();
+    scope.compile();
+    Class & Line = get<Class>(scope[2]);
+
+    Arena arena;
+    {
+        Instance line(Line, arena);
+        BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+        BOOST_CHECK_EQUAL(line.get_arena(), &arena);
+        BOOST_CHECK_EQUAL(line.attr("start").get_arena(), &arena);
+        BOOST_CHECK_EQUAL(line.attr("start").attr("x").get_arena(), &arena);
+        line.attr("start").get<int>("x") = 1;
+        line.attr("end").get<int>("y") = 2;
+
+        // assignment keeps the data in the arena
+        Instance other(Line);
+        line = other;
+        BOOST_CHECK_EQUAL(line.attr("start").get<int>("x"), 0);
+        other.attr("end").get<int>("y") = 3;
+        line = other;
+        BOOST_CHECK_EQUAL(line.attr("end").get<int>("y"), 3);
+
+        // copies reside on the heap, and survive the arena
+        Instance copy(line);
+        BOOST_CHECK(!copy.get_arena());
+        BOOST_CHECK(!copy.attr("start").get_arena());
+        arena.release();
+        BOOST_CHECK_EQUAL(copy.attr("end").get<int>("y"), 3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arena_flat_alignment_test)
+{
+    // class Double
+    // class Vec:
+    //     Double x
+    //     Double y
+    Scope scope;
+    {
+        Class Double("Double");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Double", "x"));
+        Vec.scope.get().push_back(Attr("Double", "y"));
+        scope.push_back(Double);
+        scope.push_back(Vec);
+    }
+    get<Class>(scope[0]).set_type<double>();
+    scope.compile();
+    Class & Vec = get<Class>(scope[1]);
+    Vec.set_flat();
+
+    // the flat buffer is aligned, even after an odd sized allocation
+    Arena arena;
+    arena.allocate(1, 1);
+    Instance vec(Vec, arena);
+    BOOST_CHECK(vec.is_flat());
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(&vec.get<double>("x")) % boost::alignment_of<double>::value, 0);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(&vec.get<double>("y")) % boost::alignment_of<double>::value, 0);
+    vec.get<double>("y") = 2.5;
+
+    // and so are copies into the arena
+    arena.allocate(3, 1);
+    Instance copy(vec, &arena);
+    BOOST_CHECK_EQUAL(copy.get_arena(), &arena);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(&copy.get<double>("x")) % boost::alignment_of<double>::value, 0);
+    BOOST_CHECK_EQUAL(copy.get<double>("y"), 2.5);
+}
+
+BOOST_AUTO_TEST_CASE(arena_instance_copy_test)
+{
+    Class Int("Int");
+    Int.set_type<int>();
+    Instance x(Int);
+    x = 5;
+
+    // elements of arena vectors are copied into the arena
+    Arena arena;
+    std::vector<Instance, ArenaAllocator<Instance> > v((ArenaAllocator<Instance>(&arena)));
+    v.push_back(x);
+    v.push_back(Instance(Int));
+    v.reserve(10);
+    BOOST_CHECK_EQUAL(v[0].get_arena(), &arena);
+    BOOST_CHECK_EQUAL(v[1].get_arena(), &arena);
+    BOOST_CHECK_EQUAL(v[0].get<int>(), 5);
+
+    // moving to another arena copies
+    Arena other;
+    Instance y(std::move(v[0]), &other);
+    BOOST_CHECK_EQUAL(y.get_arena(), &other);
+    BOOST_CHECK_EQUAL(y.get<int>(), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/array.hpp"
+int main()
+{
+    // no default constructor
+    //pyffi::object_models::Array array;
+    return 0;
+};
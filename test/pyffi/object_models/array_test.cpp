@@ -0,0 +1,325 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <cstring> // std::memcpy
+#include <sstream>
+#include <vector>
+
+#include "pyffi/object_models/array.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! A vertex, as stored in a packed array.
+struct Vector3 {
+    float x, y, z;
+};
+
+//! A triangle, as stored in a packed array.
+struct Triangle {
+    unsigned short v1, v2, v3;
+};
+
+//! Build a scope from its ffi description, set its primitive types,
+//! and compile it.
+class MeshFixture
+{
+public:
+    MeshFixture() : scope() {
+        std::istringstream is(
+            "class UShort\n"
+            "class UInt\n"
+            "class Float\n"
+            "class Vector3\n"
+            "    Float x\n"
+            "    Float y\n"
+            "    Float z\n"
+            "class Triangle\n"
+            "    UShort v1\n"
+            "    UShort v2\n"
+            "    UShort v3\n"
+            "class Match\n"
+            "    UShort index\n"
+            "    UInt weight\n"
+            "class Mesh\n"
+            "    UShort num_vertices\n"
+            "    Vector3 vertices[num_vertices]\n"
+            "    UShort num_triangles\n"
+            "    Triangle triangles[num_triangles]\n"
+            "    UShort num_uv_sets\n"
+            "    Float uvs[num_uv_sets][2 * num_vertices]\n"
+            "    UShort num_matches\n"
+            "    Match matches[num_matches]\n");
+        BOOST_REQUIRE(scope.parse(is));
+        get<Class>(scope[0]).set_type<unsigned short>();
+        get<Class>(scope[1]).set_type<unsigned int>();
+        get<Class>(scope[2]).set_type<float>();
+        scope.compile();
+    };
+
+    //! Append a value to the data of a mesh.
+    template <typename T>
+    void append(T const & value) {
+        char const *bytes = reinterpret_cast<char const *>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    };
+
+    //! The data of a mesh with two vertices, one triangle, one uv set
+    //! and two matches.
+    void append_mesh() {
+        append<unsigned short>(2);
+        append(1.0f);
+        append(2.0f);
+        append(3.0f);
+        append(4.0f);
+        append(5.0f);
+        append(6.0f);
+        append<unsigned short>(1);
+        append<unsigned short>(0);
+        append<unsigned short>(1);
+        append<unsigned short>(0);
+        append<unsigned short>(1);
+        append(0.0f);
+        append(0.25f);
+        append(0.5f);
+        append(0.75f);
+        append<unsigned short>(2);
+        append<unsigned short>(7);
+        append<unsigned int>(70);
+        append<unsigned short>(8);
+        append<unsigned int>(80);
+    };
+
+    Scope scope;
+    std::vector<char> data;
+};
+
+BOOST_FIXTURE_TEST_SUITE(array_test_suite, MeshFixture)
+
+BOOST_AUTO_TEST_CASE(array_packed_test)
+{
+    // classes without padding and with a single word size are packed
+    BOOST_CHECK(get<Class>(scope[2]).is_packed());
+    BOOST_CHECK(get<Class>(scope[3]).is_packed());
+    BOOST_CHECK_EQUAL(get<Class>(scope[3]).get_word_size(), 4);
+    BOOST_CHECK(get<Class>(scope[4]).is_packed());
+    BOOST_CHECK_EQUAL(get<Class>(scope[4]).get_word_size(), 2);
+    BOOST_CHECK(!get<Class>(scope[5]).is_packed());
+    BOOST_CHECK(!get<Class>(scope[6]).is_packed());
+
+    // arrays are read by a single instruction each
+    Plan const & plan = get<Class>(scope[6]).get_plan();
+    BOOST_CHECK_EQUAL(plan.size(), 8);
+    BOOST_CHECK_EQUAL(plan[1].code, PlanOp::ARRAY);
+    BOOST_CHECK_EQUAL(plan[1].index, 1);
+    BOOST_CHECK_EQUAL(plan[1].size, 12);
+    BOOST_CHECK_EQUAL(plan[1].word_size, 4);
+    BOOST_CHECK_EQUAL(plan[3].size, 6);
+    BOOST_CHECK_EQUAL(plan[3].word_size, 2);
+    BOOST_CHECK_EQUAL(plan[5].size, 4);
+    BOOST_CHECK_EQUAL(plan[5].word_size, 4);
+    BOOST_CHECK_EQUAL(plan[7].code, PlanOp::ARRAY);
+    BOOST_CHECK_EQUAL(plan[7].word_size, 0);
+}
+
+BOOST_AUTO_TEST_CASE(array_read_write_test)
+{
+    append_mesh();
+    Instance mesh(get<Class>(scope[6]));
+    ByteReader reader(data.data(), data.size());
+    mesh.read(reader);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+
+    Array const & vertices = mesh.get<Array>("vertices");
+    BOOST_CHECK_EQUAL(vertices.size(), 2);
+    BOOST_CHECK(vertices.is_packed());
+    BOOST_CHECK_EQUAL(vertices.get<Vector3>()[1].y, 5.0f);
+    Array const & triangles = mesh.get<Array>("triangles");
+    BOOST_CHECK_EQUAL(triangles.size(), 1);
+    BOOST_CHECK_EQUAL(triangles.get<Triangle>()[0].v2, 1);
+    // both lengths of a two dimensional array multiply
+    Array const & uvs = mesh.get<Array>("uvs");
+    BOOST_CHECK_EQUAL(uvs.size(), 4);
+    BOOST_CHECK_EQUAL(uvs.get<float>()[3], 0.75f);
+    BOOST_CHECK_THROW(uvs.get<unsigned int>(), std::runtime_error);
+    // elements which are not packed are instances
+    Array const & matches = mesh.get<Array>("matches");
+    BOOST_CHECK(!matches.is_packed());
+    BOOST_CHECK_EQUAL(matches.size(), 2);
+    BOOST_CHECK_EQUAL(matches.at(1).get<unsigned int>("weight"), 80);
+    BOOST_CHECK_THROW(matches.data(), std::runtime_error);
+    BOOST_CHECK_THROW(matches.at(2), std::out_of_range);
+
+    // writing gives the original data
+    BOOST_CHECK_EQUAL(mesh.size(), data.size());
+    std::vector<char> buffer(data.size());
+    ByteWriter writer(buffer.data(), buffer.size());
+    mesh.write(writer);
+    BOOST_CHECK(buffer == data);
+
+    // and so does a copy, also in a foreign byte order
+    Instance copy(mesh);
+    std::ostringstream os;
+    set_endian(os, Endian::BIG);
+    copy.write(os);
+    std::istringstream is(os.str());
+    set_endian(is, Endian::BIG);
+    Instance mesh2(get<Class>(scope[6]));
+    mesh2.read(is);
+    BOOST_CHECK_EQUAL(mesh2.get<Array>("vertices").get<Vector3>()[1].z, 6.0f);
+    BOOST_CHECK_EQUAL(mesh2.get<Array>("matches").at(0).get<unsigned short>("index"), 7);
+    os.str("");
+    set_endian(os, Endian::NATIVE);
+    mesh2.write(os);
+    BOOST_CHECK(os.str() == std::string(data.begin(), data.end()));
+}
+
+BOOST_AUTO_TEST_CASE(array_arena_test)
+{
+    append_mesh();
+    Arena arena;
+    Instance mesh(get<Class>(scope[6]), arena);
+    ByteReader reader(data.data(), data.size());
+    mesh.read(reader);
+    BOOST_CHECK_EQUAL(mesh.get<Array>("matches").at(1).get_arena(), &arena);
+    // copies reside on the heap
+    Instance copy(mesh);
+    BOOST_CHECK_EQUAL(copy.get<Array>("matches").at(1).get_arena(), (Arena *)0);
+    BOOST_CHECK_EQUAL(copy.get<Array>("vertices").get<Vector3>()[0].x, 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(array_resize_test)
+{
+    Instance mesh(get<Class>(scope[6]));
+    Array & vertices = mesh.get<Array>("vertices");
+    vertices.resize(3);
+    vertices.get<Vector3>()[2].x = 9.0f;
+    vertices.resize(1);
+    vertices.resize(3);
+    // new elements are zero
+    BOOST_CHECK_EQUAL(vertices.get<Vector3>()[2].x, 0.0f);
+    // the length attribute must match when writing
+    std::ostringstream os;
+    BOOST_CHECK_THROW(mesh.write(os), std::runtime_error);
+    mesh.get<unsigned short>("num_vertices") = 3;
+    os.str("");
+    mesh.write(os);
+    BOOST_CHECK_EQUAL(os.str().size(), mesh.size());
+    BOOST_CHECK_EQUAL(mesh.size(), 2 + 36 + 2 + 2 + 2);
+}
+
+BOOST_AUTO_TEST_CASE(array_truncated_test)
+{
+    // the length is checked before anything is allocated
+    append<unsigned short>(60000);
+    append(1.0f);
+    Instance mesh(get<Class>(scope[6]));
+    ByteReader reader(data.data(), data.size());
+    BOOST_CHECK_THROW(mesh.read(reader), std::runtime_error);
+    BOOST_CHECK_EQUAL(mesh.get<Array>("vertices").size(), 0);
+    // from a stream, the array grows in chunks, until the stream ends
+    std::istringstream is(std::string(data.begin(), data.end()));
+    mesh.read(is);
+    BOOST_CHECK(is.fail());
+    BOOST_CHECK_LT(mesh.get<Array>("vertices").size(), 60000);
+    BOOST_CHECK_EQUAL(mesh.get<Array>("vertices").get<Vector3>()[0].x, 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(array_truncated_instances_test)
+{
+    // elements which are not packed take at least their least size
+    BOOST_CHECK_EQUAL(get<Class>(scope[5]).get_min_size(), 6);
+    BOOST_CHECK_EQUAL(get<Class>(scope[6]).get_min_size(), 8);
+    BOOST_CHECK_EQUAL(get<Class>(scope[6]).get_plan()[7].size, 6);
+    append<unsigned short>(0);
+    append<unsigned short>(0);
+    append<unsigned short>(0);
+    append<unsigned short>(60000);
+    append<unsigned short>(7);
+    append<unsigned int>(70);
+    Instance mesh(get<Class>(scope[6]));
+    ByteReader reader(data.data(), data.size());
+    BOOST_CHECK_THROW(mesh.read(reader), std::runtime_error);
+    BOOST_CHECK_EQUAL(mesh.get<Array>("matches").size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE(array_length_error_test)
+{
+    // lengths must not refer to arrays
+    std::istringstream is(
+        "class UShort\n"
+        "class Jagged\n"
+        "    UShort num_rows\n"
+        "    UShort row_sizes[num_rows]\n"
+        "    UShort rows[num_rows][row_sizes]\n");
+    Scope scope;
+    BOOST_REQUIRE(scope.parse(is));
+    get<Class>(scope[0]).set_type<unsigned short>();
+    BOOST_CHECK_THROW(scope.compile(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(array_truncated_empty_instances_test)
+{
+    // elements which may take no bytes still count as one byte each
+    std::istringstream is(
+        "class UInt\n"
+        "class Maybe\n"
+        "    if Version >= 1\n"
+        "        UInt value\n"
+        "class List\n"
+        "    UInt num_items\n"
+        "    Maybe items[num_items]\n");
+    Scope scope;
+    BOOST_REQUIRE(scope.parse(is));
+    get<Class>(scope[0]).set_type<unsigned int>();
+    scope.compile();
+    BOOST_CHECK_EQUAL(get<Class>(scope[1]).get_min_size(), 0);
+    unsigned int const num_items = 1000000;
+    std::string data(reinterpret_cast<char const *>(&num_items), 4);
+    data += "ABC";
+    Instance list(get<Class>(scope[2]));
+    ByteReader reader(data.data(), data.size());
+    BOOST_CHECK_THROW(list.read(reader), std::runtime_error);
+    BOOST_CHECK_EQUAL(list.get<Array>("items").size(), 0);
+}
@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/attr_handle.hpp"
+int main()
+{
+    // no default constructor
+    //pyffi::object_models::AttrHandle<int> handle;
+    return 0;
+};
@@ -37,7 +37,9 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MAIN
+#include <boost/lexical_cast.hpp>
 #include <boost/test/unit_test.hpp>
+#include <vector>
 
 #include "pyffi/object_models/attr_map.hpp"
 
@@ -74,4 +76,125 @@ BOOST_AUTO_TEST_CASE(attr_map_simple_test)
     BOOST_CHECK_EQUAL(&map["x"], &x);
 }
 
+BOOST_AUTO_TEST_CASE(attr_map_base_test)
+{
+    Attr x("Int", "x");
+    Attr y("Int", "y");
+    Attr z("Int", "z");
+    Attr x2("Int", "x");
+    Attr w("Int", "w");
+
+    AttrMap base;
+    base.push_back(x);
+    base.push_back(y);
+    AttrMap derived;
+    derived.set_base(base);
+    derived.push_back(z);
+    derived.push_back(x2); // same as "x" of base, does nothing
+    BOOST_CHECK_EQUAL(derived.size(), 3);
+    BOOST_CHECK_EQUAL(x2.get_index(), 0);
+    BOOST_CHECK_EQUAL(z.get_index(), 2);
+    // base attributes are shared, not copied
+    BOOST_CHECK_EQUAL(&derived["x"], &x);
+    BOOST_CHECK_EQUAL(&derived["y"], &y);
+    BOOST_CHECK_EQUAL(&derived["z"], &z);
+    BOOST_CHECK_THROW(base["z"].get_index(), std::runtime_error);
+    BOOST_CHECK_THROW(derived.set_base(base), std::runtime_error);
+
+    AttrMap::const_iterator iter = derived.begin();
+    BOOST_CHECK_EQUAL(&(*iter), &x);
+    BOOST_CHECK_EQUAL(&(*++iter), &y);
+    BOOST_CHECK_EQUAL(&(*++iter), &z);
+    BOOST_CHECK(++iter == derived.end());
+
+    // attributes added to the base later on are not shared
+    base.push_back(w);
+    BOOST_CHECK_EQUAL(derived.size(), 3);
+    BOOST_CHECK(!derived.find("w"));
+}
+
+BOOST_AUTO_TEST_CASE(attr_map_freeze_test)
+{
+    std::vector<Attr> attrs;
+    for (int i = 0; i < 100; i++) {
+        attrs.push_back(Attr("Int", "attr_map_freeze_" + boost::lexical_cast<std::string>(i)));
+    };
+    Attr again("Int", "attr_map_freeze_3");
+    AttrMap base;
+    for (int i = 0; i < 40; i++) {
+        base.push_back(attrs[i]);
+    };
+    AttrMap derived;
+    derived.set_base(base);
+    for (int i = 40; i < 100; i++) {
+        derived.push_back(attrs[i]);
+    };
+    derived.push_back(again);
+
+    // base maps can be frozen before or after derived ones
+    base.freeze();
+    BOOST_CHECK(base.is_frozen());
+    BOOST_CHECK_EQUAL(base.size(), 40);
+    derived.freeze();
+    derived.freeze(); // does nothing
+    BOOST_CHECK_EQUAL(derived.size(), 100);
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK_EQUAL(&derived[attrs[i].name], &attrs[i]);
+        BOOST_CHECK_EQUAL(&derived[attrs[i].get_symbol()], &attrs[i]);
+    };
+    BOOST_CHECK_EQUAL(&base["attr_map_freeze_39"], &attrs[39]);
+    BOOST_CHECK(!base.find("attr_map_freeze_40"));
+    BOOST_CHECK(!derived.find(Symbol("attr_map_freeze_100")));
+    BOOST_CHECK_THROW(derived["attr_map_freeze_never_interned"], std::runtime_error);
+
+    // iteration is in insertion order
+    int i = 0;
+    for (AttrMap::const_iterator iter = derived.begin(); iter != derived.end(); ++iter) {
+        BOOST_CHECK_EQUAL(&(*iter), &attrs[i++]);
+    };
+    BOOST_CHECK_EQUAL(i, 100);
+
+    // frozen maps are read only
+    Attr late("Int", "attr_map_freeze_late");
+    BOOST_CHECK_THROW(derived.push_back(late), std::runtime_error);
+    AttrMap empty;
+    empty.freeze();
+    BOOST_CHECK(!empty.find("attr_map_freeze_0"));
+}
+
+BOOST_AUTO_TEST_CASE(attr_map_freeze_chain_test)
+{
+    // a chain of maps, frozen from the most derived one up
+    std::vector<Attr> attrs;
+    for (int i = 0; i < 30; i++) {
+        attrs.push_back(Attr("Int", "attr_map_chain_" + boost::lexical_cast<std::string>(i)));
+    };
+    std::vector<AttrMap> maps(3);
+    for (int level = 0; level < 3; level++) {
+        if (level > 0) {
+            maps[level].set_base(maps[level - 1]);
+        };
+        for (int i = 10 * level; i < 10 * level + 10; i++) {
+            maps[level].push_back(attrs[i]);
+        };
+    };
+    for (int level = 2; level >= 0; level--) {
+        maps[level].freeze();
+        BOOST_CHECK_EQUAL(maps[level].size(), 10 * level + 10);
+        int i = 0;
+        for (AttrMap::const_iterator iter = maps[level].begin(); iter != maps[level].end(); ++iter) {
+            BOOST_CHECK_EQUAL(&(*iter), &attrs[i]);
+            BOOST_CHECK_EQUAL(&maps[level][attrs[i].name], &attrs[i]);
+            i++;
+        };
+    };
+    // once all are frozen, each level still finds those of its bases,
+    // and none of those of its derived maps
+    for (int level = 0; level < 3; level++) {
+        for (int i = 0; i < 30; i++) {
+            BOOST_CHECK_EQUAL(bool(maps[level].find(attrs[i].get_symbol())), i < 10 * level + 10);
+        };
+    };
+}
+
 BOOST_AUTO_TEST_SUITE_END()
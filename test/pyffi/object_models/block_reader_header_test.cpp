@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/block_reader.hpp"
+int main()
+{
+    std::vector<pyffi::object_models::BlockSpan> blocks;
+    return 0;
+};
@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <utility>
+
+#include "pyffi/object_models/block_reader.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Test fixture, with classes Int and Vec (two Ints).
+class Fixture
+{
+public:
+    Fixture() : scope() {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        get<Class>(scope[0]).set_type<int>();
+        scope.compile();
+    };
+
+    //! Append a size prefixed block, with a type tag.
+    void append(std::string & data, char tag, std::string const & block) {
+        int size = static_cast<int>(block.size());
+        data += tag;
+        data += std::string(reinterpret_cast<char const *>(&size), 4);
+        data += block;
+    };
+
+    //! Append an int.
+    static std::string int_data(int value) {
+        return std::string(reinterpret_cast<char const *>(&value), 4);
+    };
+
+    Scope scope;
+};
+
+//! Reads a type tag ('i' for Int, 'v' for Vec) and a size.
+class scan_header
+{
+public:
+    scan_header(Scope const & scope) : scope(scope) {};
+
+    boost::optional<std::pair<Class const *, std::size_t> > operator()(ByteReader & reader) const {
+        if (reader.remaining() == 0) {
+            return boost::none;
+        };
+        char tag;
+        int size;
+        reader.read(&tag, 1);
+        reader.read(&size, 4);
+        return std::make_pair(
+                   &scope.get_class((tag == 'i') ? "Int" : "Vec"),
+                   static_cast<std::size_t>(size));
+    };
+
+    Scope const & scope;
+};
+
+BOOST_FIXTURE_TEST_SUITE(block_reader_test_suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(block_reader_test)
+{
+    std::string data;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 3) {
+            append(data, 'v', int_data(i) + int_data(-i));
+        } else {
+            append(data, 'i', int_data(i));
+        };
+    };
+    ByteReader reader(data.data(), data.size());
+    std::vector<BlockSpan> blocks = scan_blocks(reader, scan_header(scope));
+    BOOST_CHECK_EQUAL(blocks.size(), 1000);
+    BOOST_CHECK_EQUAL(blocks[1].offset, 5 + 4 + 5);
+    BOOST_CHECK_EQUAL(blocks[1].size, 8);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+
+    std::size_t thread_counts[] = {0, 1, 4};
+    BOOST_FOREACH(std::size_t num_threads, thread_counts) {
+        std::vector<Instance> instances =
+            read_blocks(data.data(), blocks, Endian::NATIVE, num_threads);
+        BOOST_CHECK_EQUAL(instances.size(), 1000);
+        for (int i = 0; i < 1000; i++) {
+            if (i % 3) {
+                BOOST_CHECK_EQUAL(instances[i].get<int>("x"), i);
+                BOOST_CHECK_EQUAL(instances[i].get<int>("y"), -i);
+            } else {
+                BOOST_CHECK_EQUAL(instances[i].get<int>(), i);
+            };
+        };
+    };
+}
+
+BOOST_AUTO_TEST_CASE(block_reader_error_test)
+{
+    std::string data;
+    append(data, 'i', int_data(1));
+    append(data, 'v', int_data(2)); // too short for a Vec
+    append(data, 'i', int_data(3));
+    ByteReader reader(data.data(), data.size());
+    std::vector<BlockSpan> blocks = scan_blocks(reader, scan_header(scope));
+    BOOST_CHECK_EQUAL(blocks.size(), 3);
+    BOOST_CHECK_THROW(read_blocks(data.data(), blocks, Endian::NATIVE, 2), std::runtime_error);
+    // too long for an Int: the span does not match the block
+    std::string long_data;
+    append(long_data, 'i', int_data(1) + int_data(2));
+    ByteReader long_reader(long_data.data(), long_data.size());
+    std::vector<BlockSpan> long_blocks = scan_blocks(long_reader, scan_header(scope));
+    BOOST_CHECK_EQUAL(long_blocks.size(), 1);
+    BOOST_CHECK_THROW(read_blocks(long_data.data(), long_blocks, Endian::NATIVE, 1), std::runtime_error);
+    // no blocks
+    BOOST_CHECK(read_blocks(data.data(), std::vector<BlockSpan>()).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,9 @@
+// check that header compiles
+#include "pyffi/object_models/byte_stream.hpp"
+int main()
+{
+    char data[4] = {};
+    pyffi::object_models::ByteReader reader(data, 4);
+    pyffi::object_models::ByteWriter writer(data, 4);
+    return 0;
+};
@@ -0,0 +1,85 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include "pyffi/object_models/byte_stream.hpp"
+
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(byte_stream_test_suite)
+
+BOOST_AUTO_TEST_CASE(byte_reader_test)
+{
+    char const data[] = "ABCDEF";
+    ByteReader reader(data, 6);
+    BOOST_CHECK_EQUAL(reader.remaining(), 6);
+
+    int x;
+    reader.read(&x, 4);
+    BOOST_CHECK_EQUAL(x, 0x44434241);
+    BOOST_CHECK_EQUAL(reader.tell(), 4);
+    BOOST_CHECK_EQUAL(reader.remaining(), 2);
+
+    // reading past the end fails, and does not move the cursor
+    BOOST_CHECK_THROW(reader.read(&x, 4), std::runtime_error);
+    BOOST_CHECK_EQUAL(reader.tell(), 4);
+    BOOST_CHECK_NO_THROW(reader.require(2));
+    BOOST_CHECK_EQUAL(reader.take(2), data + 4);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(byte_writer_test)
+{
+    char data[6] = {0};
+    ByteWriter writer(data, 6);
+    int x = 0x44434241;
+    writer.write(&x, 4);
+    BOOST_CHECK_EQUAL(std::string(data, 4), "ABCD");
+    BOOST_CHECK_EQUAL(writer.tell(), 4);
+
+    // writing past the end fails, and does not move the cursor
+    BOOST_CHECK_THROW(writer.write(&x, 4), std::runtime_error);
+    BOOST_CHECK_EQUAL(writer.remaining(), 2);
+    writer.write("EF", 2);
+    BOOST_CHECK_EQUAL(std::string(data, 6), "ABCDEF");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
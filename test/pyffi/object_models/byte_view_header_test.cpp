@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/byte_view.hpp"
+int main()
+{
+    pyffi::object_models::ByteView view;
+    return 0;
+};
@@ -0,0 +1,183 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <boost/unordered_set.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(byte_view_test_suite)
+
+BOOST_AUTO_TEST_CASE(byte_view_test)
+{
+    std::string data("hello world");
+    ByteView view(data.data(), 5);
+    BOOST_CHECK(!view.is_owner());
+    BOOST_CHECK_EQUAL(view.data(), data.data());
+    BOOST_CHECK(view == std::string("hello"));
+    BOOST_CHECK(std::string("hello") == view);
+    BOOST_CHECK(view != std::string("hell"));
+    BOOST_CHECK(!(ByteView(data.data() + 6, 5) < view));
+    BOOST_CHECK(view < ByteView(data.data() + 6, 5));
+
+    // copies of a view refer to the same memory
+    ByteView copy(view);
+    BOOST_CHECK_EQUAL(copy.data(), data.data());
+    BOOST_CHECK_EQUAL(hash_value(copy), hash_value(ByteView(std::string("hello"))));
+
+    // modification copies first
+    copy.mutable_data()[0] = 'j';
+    BOOST_CHECK(copy.is_owner());
+    BOOST_CHECK(copy == std::string("jello"));
+    BOOST_CHECK_EQUAL(data, "hello world");
+
+    // copies and moves of an owner own their own copy
+    ByteView owner_copy(copy);
+    BOOST_CHECK(owner_copy.is_owner());
+    BOOST_CHECK(owner_copy.data() != copy.data());
+    ByteView moved(std::move(owner_copy));
+    BOOST_CHECK(moved.is_owner());
+    BOOST_CHECK(moved == std::string("jello"));
+    view = moved;
+    BOOST_CHECK(view.is_owner());
+    BOOST_CHECK(view.data() != moved.data());
+    view = ByteView(data.data(), 5);
+    BOOST_CHECK(!view.is_owner());
+    BOOST_CHECK_EQUAL(view.str(), "hello");
+
+    boost::unordered_set<ByteView> names;
+    names.insert(ByteView(data.data(), 5));
+    BOOST_CHECK(names.count(ByteView(std::string("hello"))));
+}
+
+BOOST_AUTO_TEST_CASE(sized_string_test)
+{
+    Scope scope;
+    std::ifstream in((std::string(TEST_PATH) + "/data/ffi/test_full.ffi").c_str());
+    BOOST_CHECK_EQUAL(scope.parse(in), true);
+    get<Class>(scope[3]).set_type<unsigned int>(); // UInt
+    get<Class>(scope[8]).set_type<unsigned int>(); // StringIndex
+    Class & SizedString = get<Class>(scope[12]);
+    BOOST_CHECK_EQUAL(SizedString.name, "SizedString");
+    SizedString.set_sized_string<unsigned int>();
+    scope.compile();
+    BOOST_CHECK(SizedString.is_sized_string());
+    BOOST_CHECK(!SizedString.get_layout());
+    Class const & String = scope.get_class("String");
+
+    // without a version, the string has no index (see String)
+    unsigned int length = 5;
+    std::string data =
+        std::string(reinterpret_cast<char const *>(&length), 4) + "Scene";
+
+    // from memory: refers to the buffer
+    Instance str(String);
+    ByteReader reader(data.data(), data.size());
+    str.read(reader);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+    ByteView const & name = str.attr("string").get<ByteView>();
+    BOOST_CHECK(name == std::string("Scene"));
+    BOOST_CHECK_EQUAL(name.data(), data.data() + 4);
+    BOOST_CHECK_EQUAL(str.get<unsigned int>("index"), 0);
+    BOOST_CHECK_EQUAL(str.size(), data.size());
+    BOOST_CHECK_THROW(str.attr("string").attr("length"), std::runtime_error);
+
+    // from a stream: owns a copy
+    Instance str2(String);
+    std::istringstream is(data);
+    str2.read(is);
+    BOOST_CHECK(str2.attr("string").get<ByteView>().is_owner());
+    BOOST_CHECK(str2.attr("string").get<ByteView>() == name);
+
+    // write back, after modification
+    str.attr("string").get<ByteView>().assign("Root");
+    std::ostringstream os;
+    str.write(os);
+    length = 4;
+    BOOST_CHECK_EQUAL(
+        os.str(),
+        std::string(reinterpret_cast<char const *>(&length), 4) + "Root");
+    BOOST_CHECK_EQUAL(data.substr(4, 5), "Scene");
+
+    // too short
+    Instance str3(String);
+    ByteReader short_reader(data.data(), 8);
+    BOOST_CHECK_THROW(str3.read(short_reader), std::runtime_error);
+
+    // corrupt length on a stream: stops at the end of the stream
+    length = 0xffffffff;
+    Instance str4(String);
+    std::istringstream corrupt(
+        std::string(reinterpret_cast<char const *>(&length), 4) + "Scene");
+    str4.read(corrupt);
+    BOOST_CHECK(corrupt.fail());
+    BOOST_CHECK(str4.attr("string").get<ByteView>() == std::string("Scene"));
+}
+
+BOOST_AUTO_TEST_CASE(sized_string_too_long_test)
+{
+    Class ShortString("ShortString");
+    ShortString.set_sized_string<unsigned char>();
+    Instance str(ShortString);
+    std::vector<char> buffer(300);
+    ByteWriter writer(&buffer[0], buffer.size());
+    std::ostringstream os;
+
+    // the longest string which fits the length
+    str.get<ByteView>().assign(std::string(255, 'x'));
+    str.write(writer);
+    str.write(os);
+    BOOST_CHECK_EQUAL(writer.tell(), 256);
+    BOOST_CHECK_EQUAL(os.str().size(), 256);
+
+    // the length would be truncated
+    str.get<ByteView>().assign(std::string(256, 'x'));
+    ByteWriter long_writer(&buffer[0], buffer.size());
+    BOOST_CHECK_THROW(str.write(long_writer), std::runtime_error);
+    BOOST_CHECK_THROW(str.write(os), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/embedded_schema.hpp"
+int main()
+{
+    pyffi::object_models::EmbeddedSchema schema = {0, 0, 0};
+    return static_cast<int>(schema.size);
+};
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include "pyffi/object_models/embedded_schema.hpp"
+#include "pyffi/object_models/scope.hpp"
+#include "pyffi_schema_test_full.hpp" // generated by pyffi_embed_schema
+
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Read a whole file.
+static std::string read_file(std::string const & filename)
+{
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+};
+
+BOOST_AUTO_TEST_SUITE(embedded_schema_test_suite)
+
+BOOST_AUTO_TEST_CASE(embedded_schema_read_test)
+{
+    std::string xml = read_file(std::string(TEST_PATH) + "/data/xml/test_full.xml");
+    BOOST_CHECK_EQUAL(schemas::test_full.source_hash, Scope::hash_source(xml));
+    Scope expected;
+    std::istringstream is(xml);
+    BOOST_CHECK_EQUAL(expected.parse_xml(is), true);
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.read_cache(schemas::test_full), true);
+    BOOST_CHECK(scope == expected);
+    BOOST_CHECK(scope.versions == expected.versions);
+}
+
+BOOST_AUTO_TEST_CASE(embedded_schema_write_test)
+{
+    Scope scope;
+    std::istringstream is("class Int\n");
+    BOOST_CHECK_EQUAL(scope.parse(is), true);
+    std::ostringstream header;
+    std::ostringstream source;
+    write_embedded_schema(scope, 42, "ints", "ints.hpp", header, source);
+    BOOST_CHECK(header.str().find("EmbeddedSchema const ints;") != std::string::npos);
+    BOOST_CHECK(source.str().find("#include \"ints.hpp\"") != std::string::npos);
+    BOOST_CHECK(source.str().find("sizeof(ints_data), 42ULL") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(embedded_schema_invalid_name_test)
+{
+    Scope scope;
+    std::ostringstream header;
+    std::ostringstream source;
+    BOOST_CHECK_THROW(write_embedded_schema(scope, 0, "", "x.hpp", header, source), std::runtime_error);
+    BOOST_CHECK_THROW(write_embedded_schema(scope, 0, "1st", "x.hpp", header, source), std::runtime_error);
+    BOOST_CHECK_THROW(write_embedded_schema(scope, 0, "a-b", "x.hpp", header, source), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
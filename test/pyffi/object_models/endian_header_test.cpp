@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/endian.hpp"
+int main()
+{
+    pyffi::object_models::Endian endian = pyffi::object_models::Endian::NATIVE;
+    return (endian == pyffi::object_models::Endian::NATIVE) ? 0 : 1;
+};
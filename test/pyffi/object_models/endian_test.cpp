@@ -0,0 +1,196 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <algorithm>
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <vector>
+
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(endian_test_suite)
+
+BOOST_AUTO_TEST_CASE(swap_bytes_test)
+{
+    BOOST_TEST_MESSAGE("swap kernel: " << swap_kernel(4));
+    std::size_t word_sizes[] = {1, 2, 3, 4, 8};
+    BOOST_FOREACH(std::size_t word_size, word_sizes) {
+        // all counts around the block sizes of the kernels
+        for (std::size_t count = 0; count < 40; count++) {
+            std::vector<char> data(word_size * count + 1);
+            for (std::size_t i = 0; i < data.size(); i++) {
+                data[i] = static_cast<char>(i);
+            };
+            std::vector<char> expected(data);
+            for (std::size_t i = 0; i < count; i++) {
+                std::reverse(
+                    expected.begin() + i * word_size,
+                    expected.begin() + (i + 1) * word_size);
+            };
+            // unaligned start, to check that kernels handle it
+            swap_bytes(&data[1] - 1, word_size, count);
+            BOOST_CHECK(data == expected);
+        };
+    };
+}
+
+BOOST_AUTO_TEST_CASE(stream_endian_test)
+{
+    std::istringstream is;
+    BOOST_CHECK(get_endian(is) == Endian::NATIVE);
+    set_endian(is, Endian::BIG);
+    BOOST_CHECK(get_endian(is) == Endian::BIG);
+    BOOST_CHECK(is_swapped(Endian::BIG) != is_swapped(Endian::LITTLE));
+    BOOST_CHECK(!is_swapped(Endian::NATIVE));
+    BOOST_CHECK(!is_swapped(native_endian()));
+    ByteReader reader(0, 0);
+    BOOST_CHECK(reader.get_endian() == Endian::NATIVE);
+    reader.set_endian(Endian::LITTLE);
+    BOOST_CHECK(get_endian(reader) == Endian::LITTLE);
+}
+
+BOOST_AUTO_TEST_CASE(read_write_endian_test)
+{
+    // class Byte
+    // class Short
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    // class Mixed:
+    //     Byte a
+    //     Short b
+    //     Int c
+    Scope scope;
+    {
+        Class Byte("Byte");
+        Class Short("Short");
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        Class Mixed("Mixed");
+        Mixed.scope = Scope();
+        Mixed.scope.get().push_back(Attr("Byte", "a"));
+        Mixed.scope.get().push_back(Attr("Short", "b"));
+        Mixed.scope.get().push_back(Attr("Int", "c"));
+        scope.push_back(Byte);
+        scope.push_back(Short);
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        scope.push_back(Mixed);
+    }
+    get<Class>(scope[0]).set_type<unsigned char>();
+    get<Class>(scope[1]).set_type<short>();
+    get<Class>(scope[2]).set_type<int>();
+    scope.compile();
+    Class const & Int = scope.get_class("Int");
+    Class const & Vec = scope.get_class("Vec");
+    Class const & Mixed = scope.get_class("Mixed");
+    BOOST_CHECK_EQUAL(Int.get_word_size(), 4);
+    BOOST_CHECK_EQUAL(Vec.get_plan()[0].word_size, 4);
+    BOOST_CHECK_EQUAL(Mixed.get_plan()[0].word_size, 0);
+
+    std::string big("\x01\x02\x03\x04\x05\x06\x07\x08", 8);
+    std::string little("\x04\x03\x02\x01\x08\x07\x06\x05", 8);
+    Endian const modes[] = {Endian::BIG, Endian::LITTLE};
+    std::string const * datas[] = {&big, &little};
+    for (int m = 0; m < 2; m++) {
+        std::string const & data = *datas[m];
+        // primitive, from a stream
+        Instance x(Int);
+        std::istringstream is(data);
+        set_endian(is, modes[m]);
+        x.read(is);
+        BOOST_CHECK_EQUAL(x.get<int>(), 0x01020304);
+        std::ostringstream os;
+        set_endian(os, modes[m]);
+        x.write(os);
+        BOOST_CHECK_EQUAL(os.str(), data.substr(0, 4));
+
+        // run of primitives, from memory
+        Instance v(Vec);
+        ByteReader reader(data.data(), data.size());
+        reader.set_endian(modes[m]);
+        v.read(reader);
+        BOOST_CHECK_EQUAL(v.get<int>("x"), 0x01020304);
+        BOOST_CHECK_EQUAL(v.get<int>("y"), 0x05060708);
+        std::string buffer(8, ' ');
+        ByteWriter writer(&buffer[0], buffer.size());
+        writer.set_endian(modes[m]);
+        v.write(writer);
+        BOOST_CHECK_EQUAL(buffer, data);
+
+        // same, as a flat class, from a stream
+        Class flat_vec(Vec);
+        flat_vec.set_flat();
+        Instance f(flat_vec);
+        std::istringstream fis(data);
+        set_endian(fis, modes[m]);
+        f.read(fis);
+        BOOST_CHECK_EQUAL(f.get<int>("y"), 0x05060708);
+        std::ostringstream fos;
+        set_endian(fos, modes[m]);
+        f.write(fos);
+        BOOST_CHECK_EQUAL(fos.str(), data);
+    };
+
+    // mixed word sizes
+    Instance mixed(Mixed);
+    std::string data("\x01\x02\x03\x04\x05\x06\x07", 7);
+    std::istringstream is(data);
+    set_endian(is, Endian::BIG);
+    mixed.read(is);
+    BOOST_CHECK_EQUAL(mixed.get<unsigned char>("a"), 0x01);
+    BOOST_CHECK_EQUAL(mixed.get<short>("b"), 0x0203);
+    BOOST_CHECK_EQUAL(mixed.get<int>("c"), 0x04050607);
+    std::string buffer(7, ' ');
+    ByteWriter writer(&buffer[0], buffer.size());
+    writer.set_endian(Endian::BIG);
+    mixed.write(writer);
+    BOOST_CHECK_EQUAL(buffer, data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
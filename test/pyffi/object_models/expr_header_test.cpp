@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/expr.hpp"
+int main()
+{
+    pyffi::object_models::Expr expr;
+    return 0;
+};
@@ -0,0 +1,316 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Resolves no names, so all names are globals.
+static boost::optional<std::pair<std::size_t, ExprCode::Type> >
+resolve_none(std::string const & name)
+{
+    return boost::none;
+};
+
+//! Resolves x to attribute 0 and y to attribute 1, both int.
+static boost::optional<std::pair<std::size_t, ExprCode::Type> >
+resolve_xy(std::string const & name)
+{
+    if (name == "x") {
+        return std::make_pair(std::size_t(0), ExprCode::INT);
+    } else if (name == "y") {
+        return std::make_pair(std::size_t(1), ExprCode::INT);
+    };
+    return boost::none;
+};
+
+//! Loads attributes from an array of ints.
+class load_ints
+{
+public:
+    load_ints(int const * values) : values(values) {};
+    void const * operator()(std::size_t index) const {
+        return values + index;
+    };
+    int const * values;
+};
+
+//! Evaluate an expression without attributes.
+static long long evaluate(std::string const & text, Globals const * globals = 0)
+{
+    return ExprCode(Expr::parse(text), &resolve_none).evaluate(load_ints(0), globals);
+};
+
+BOOST_AUTO_TEST_SUITE(expr_test_suite)
+
+BOOST_AUTO_TEST_CASE(expr_parse_test)
+{
+    BOOST_CHECK(Expr::parse("true") == Expr(true));
+    BOOST_CHECK(Expr::parse(" false ") == Expr(false));
+    BOOST_CHECK(Expr::parse("0x1F") == Expr::constant(31));
+    BOOST_CHECK(Expr::parse("truely") == Expr::name("truely"));
+    BOOST_CHECK(
+        Expr::parse("a + b * c")
+        == Expr::binary(
+            Expr::ADD, Expr::name("a"),
+            Expr::binary(Expr::MUL, Expr::name("b"), Expr::name("c"))));
+    BOOST_CHECK(
+        Expr::parse("(a + b) * c")
+        == Expr::binary(
+            Expr::MUL,
+            Expr::binary(Expr::ADD, Expr::name("a"), Expr::name("b")),
+            Expr::name("c")));
+    BOOST_CHECK(
+        Expr::parse("a & b && c")
+        == Expr::binary(
+            Expr::AND,
+            Expr::binary(Expr::BIT_AND, Expr::name("a"), Expr::name("b")),
+            Expr::name("c")));
+    BOOST_CHECK(
+        Expr::parse("a < b << 2")
+        == Expr::binary(
+            Expr::LT, Expr::name("a"),
+            Expr::binary(Expr::SHL, Expr::name("b"), Expr::constant(2))));
+    BOOST_CHECK(
+        Expr::parse("!~-a")
+        == Expr::unary(
+            Expr::NOT, Expr::unary(
+                Expr::BIT_NOT, Expr::unary(Expr::NEG, Expr::name("a")))));
+    BOOST_CHECK_THROW(Expr::parse(""), std::runtime_error);
+    BOOST_CHECK_THROW(Expr::parse("a +"), std::runtime_error);
+    BOOST_CHECK_THROW(Expr::parse("(a"), std::runtime_error);
+    BOOST_CHECK_THROW(Expr::parse("a b"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(expr_str_test)
+{
+    char const * texts[] = {
+        "true",
+        "0x14000005",
+        "version >= 0x0A000100 && (flags & 1) != 0",
+        "a - (b - c)",
+        "a - b - c",
+        "(a || b) && !(c < d)",
+        "-(a + 1) * ~b",
+        "user_version == 11 && user_version_2 > 26"
+    };
+    BOOST_FOREACH(char const * text, texts) {
+        BOOST_CHECK_EQUAL(Expr::parse(text).str(), text);
+    };
+    BOOST_CHECK_EQUAL(Expr::parse("((a))+(b*c)").str(), "a + b * c");
+}
+
+BOOST_AUTO_TEST_CASE(expr_evaluate_test)
+{
+    BOOST_CHECK_EQUAL(evaluate("1 + 2 * 3"), 7);
+    BOOST_CHECK_EQUAL(evaluate("(1 + 2) * 3"), 9);
+    BOOST_CHECK_EQUAL(evaluate("7 / 2 + 7 % 2"), 4);
+    BOOST_CHECK_EQUAL(evaluate("7 / 0"), 0);
+    BOOST_CHECK_EQUAL(evaluate("1 << 4 | 3 ^ 1"), 18);
+    BOOST_CHECK_EQUAL(evaluate("0xFF & ~0x0F"), 0xF0);
+    BOOST_CHECK_EQUAL(evaluate("-3 < 2 && 2 <= 2 && 3 > 2 && 2 >= 3"), 0);
+    BOOST_CHECK_EQUAL(evaluate("1 == 1 || 1 != 1"), 1);
+    BOOST_CHECK_EQUAL(evaluate("!5"), 0);
+    // unset globals are zero
+    BOOST_CHECK_EQUAL(evaluate("version"), 0);
+    Globals globals;
+    globals.set("version", 0x14000005);
+    BOOST_CHECK_EQUAL(evaluate("version >= 0x14000004", &globals), 1);
+    BOOST_CHECK_EQUAL(evaluate("version & 0xFF", &globals), 5);
+}
+
+BOOST_AUTO_TEST_CASE(expr_code_test)
+{
+    // constants fold into a single instruction
+    BOOST_CHECK(ExprCode(Expr::parse("1 + 2 == 3"), &resolve_none).is_constant());
+    BOOST_CHECK(ExprCode(Expr::parse("x && false"), &resolve_xy).is_constant());
+    BOOST_CHECK(ExprCode(Expr::parse("true || y"), &resolve_xy).is_constant());
+    BOOST_CHECK(!ExprCode(Expr::parse("x + 0"), &resolve_xy).is_constant());
+    // known globals fold too
+    Globals constants;
+    constants.set("version", 3);
+    ExprCode code(Expr::parse("version > 2 && x != 0"), &resolve_xy, &constants);
+    BOOST_CHECK_EQUAL(code.get_instrs().size(), 5);
+    BOOST_CHECK(code.get_instrs()[0] == ExprCode::Instr(ExprCode::PUSH, 1));
+    BOOST_CHECK(
+        code.get_instrs()[1]
+        == ExprCode::Instr(ExprCode::ATTR, 0, Expr::CONST, ExprCode::INT));
+    BOOST_CHECK(
+        ExprCode(Expr::parse("version > 2"), &resolve_xy, &constants)
+        == ExprCode(Expr(true), &resolve_xy));
+    // attributes are loaded
+    int values[] = {5, -7};
+    ExprCode diff(Expr::parse("x - y"), &resolve_xy);
+    BOOST_CHECK_EQUAL(diff.evaluate(load_ints(values), 0), 12);
+    // the stack is limited
+    std::string deep("x");
+    for (int i = 0; i < 40; i++) {
+        deep = "y + (" + deep + ")";
+    };
+    BOOST_CHECK_THROW(ExprCode(Expr::parse(deep), &resolve_xy), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(expr_code_load_float_test)
+{
+    // floating point attributes are truncated
+    float f = -2.5f;
+    double d = 1e18;
+    BOOST_CHECK_EQUAL(ExprCode::load(&f, ExprCode::FLOAT), -2);
+    BOOST_CHECK_EQUAL(ExprCode::load(&d, ExprCode::DOUBLE), 1000000000000000000LL);
+    // unless they do not fit
+    f = std::numeric_limits<float>::quiet_NaN();
+    BOOST_CHECK_THROW(ExprCode::load(&f, ExprCode::FLOAT), std::runtime_error);
+    f = 1e30f;
+    BOOST_CHECK_THROW(ExprCode::load(&f, ExprCode::FLOAT), std::runtime_error);
+    d = -1e19;
+    BOOST_CHECK_THROW(ExprCode::load(&d, ExprCode::DOUBLE), std::runtime_error);
+    d = std::numeric_limits<double>::infinity();
+    BOOST_CHECK_THROW(ExprCode::load(&d, ExprCode::DOUBLE), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(globals_test)
+{
+    BOOST_CHECK_EQUAL(Globals::get_slot("version"), Globals::get_slot("version"));
+    BOOST_CHECK(Globals::get_slot("version") != Globals::get_slot("user_version"));
+    Globals globals;
+    BOOST_CHECK(!globals.has(Globals::get_slot("version")));
+    globals.set("version", 10);
+    BOOST_CHECK(globals.has(Globals::get_slot("version")));
+    BOOST_CHECK_EQUAL(globals.get("version"), 10);
+    std::istringstream is;
+    BOOST_CHECK(!get_globals(is));
+    set_globals(is, &globals);
+    BOOST_CHECK_EQUAL(get_globals(is), &globals);
+}
+
+BOOST_AUTO_TEST_CASE(scope_condition_test)
+{
+    // conditions on attributes and globals decide what is read
+    std::istringstream is(
+        "class Int\n"
+        "class Block\n"
+        "    Int flags\n"
+        "    if flags & 1\n"
+        "        Int extra\n"
+        "    if version >= 0x0A000000 && flags & 2\n"
+        "        Int new_extra\n"
+        "    elif flags & 2\n"
+        "        Int old_extra\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse(is), true);
+    Class & Int = get<Class>(scope[0]);
+    Class & Block = get<Class>(scope[1]);
+    Int.set_type<int>();
+    scope.compile();
+    Globals globals;
+    globals.set("version", 0x0A000000);
+    {
+        Instance block(Block);
+        std::istringstream data(std::string("\x03\0\0\0EEEENNNNrest", 16));
+        set_globals(data, &globals);
+        block.read(data);
+        BOOST_CHECK_EQUAL(data.tellg(), 12);
+        BOOST_CHECK_EQUAL(block.get<int>("extra"), 0x45454545);
+        BOOST_CHECK_EQUAL(block.get<int>("new_extra"), 0x4E4E4E4E);
+        BOOST_CHECK_EQUAL(block.get<int>("old_extra"), 0);
+        BOOST_CHECK_EQUAL(block.size(&globals), 12);
+    }
+    {
+        Instance block(Block);
+        std::istringstream data(std::string("\x02\0\0\0OOOOrest", 12));
+        block.read(data);
+        BOOST_CHECK_EQUAL(data.tellg(), 8);
+        BOOST_CHECK_EQUAL(block.get<int>("extra"), 0);
+        BOOST_CHECK_EQUAL(block.get<int>("old_extra"), 0x4F4F4F4F);
+        BOOST_CHECK_EQUAL(block.size(), 8);
+        std::ostringstream os;
+        block.write(os);
+        BOOST_CHECK_EQUAL(os.str(), std::string("\x02\0\0\0OOOO", 8));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(scope_condition_error_test)
+{
+    // conditions need numbers
+    std::istringstream is(
+        "class Int\n"
+        "class Vec\n"
+        "    Int x\n"
+        "class Block\n"
+        "    Vec v\n"
+        "    if v\n"
+        "        Int x\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse(is), true);
+    get<Class>(scope[0]).set_type<int>();
+    BOOST_CHECK_THROW(scope.compile(), std::runtime_error);
+    // conditions and lengths can only use attributes read before them
+    std::istringstream later(
+        "class Int\n"
+        "class Block\n"
+        "    if flags & 1\n"
+        "        Int extra\n"
+        "    Int flags\n");
+    Scope later_scope;
+    BOOST_CHECK_EQUAL(later_scope.parse(later), true);
+    get<Class>(later_scope[0]).set_type<int>();
+    BOOST_CHECK_THROW(later_scope.compile(), std::runtime_error);
+    std::istringstream self(
+        "class Int\n"
+        "class Block\n"
+        "    Int num[num]\n");
+    Scope self_scope;
+    BOOST_CHECK_EQUAL(self_scope.parse(self), true);
+    get<Class>(self_scope[0]).set_type<int>();
+    BOOST_CHECK_THROW(self_scope.compile(), std::runtime_error);
+    // syntax errors in conditions
+    std::istringstream bad("class Block\n    if (x\n        Int x\n");
+    Scope bad_scope;
+    BOOST_CHECK_THROW(bad_scope.parse(bad), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/generated.hpp"
+int main()
+{
+    pyffi::object_models::generated::GlobalSlot slot("version");
+    return static_cast<int>(slot.get(0));
+};
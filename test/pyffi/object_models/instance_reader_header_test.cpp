@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/instance_reader.hpp"
+int main()
+{
+    // no default constructor
+    //pyffi::object_models::InstanceReader reader;
+    return 0;
+};
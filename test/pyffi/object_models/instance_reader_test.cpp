@@ -0,0 +1,145 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+
+#include "pyffi/object_models/instance_reader.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Test fixture, with classes Byte, Int, and Vec (two Ints).
+class Fixture
+{
+public:
+    Fixture() : scope() {
+        Class Byte("Byte");
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        scope.push_back(Byte);
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        get<Class>(scope[0]).set_type<unsigned char>();
+        get<Class>(scope[1]).set_type<int>();
+        scope.compile();
+    };
+
+    Scope scope;
+};
+
+//! Selects Int for tag 'i', Vec for tag 'v', and stops at any other tag.
+class select_by_tag
+{
+public:
+    select_by_tag(Scope const & scope) : scope(scope) {};
+
+    boost::optional<Class const &> operator()(std::istream & is) const {
+        char tag = 0;
+        is.read(&tag, 1);
+        switch (tag) {
+        case 'i':
+            return scope.get_class("Int");
+        case 'v':
+            return scope.get_class("Vec");
+        default:
+            return boost::optional<Class const &>();
+        };
+    };
+
+    Scope const & scope;
+};
+
+BOOST_FIXTURE_TEST_SUITE(instance_reader_test_suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(instance_reader_single_class_test)
+{
+    // many instances, far more than fit in a single block
+    std::string data;
+    for (int i = 0; i < 1000; i++) {
+        data += std::string(reinterpret_cast<char const *>(&i), 4);
+        data += std::string(reinterpret_cast<char const *>(&i), 4);
+    };
+    std::istringstream is(data);
+    InstanceReader reader(is, scope.get_class("Vec"), 256);
+    BOOST_CHECK_THROW(reader.get(), std::runtime_error);
+    int i = 0;
+    while (reader.next()) {
+        BOOST_CHECK_EQUAL(reader.get().get<int>("x"), i);
+        BOOST_CHECK_EQUAL(reader.get().get<int>("y"), i);
+        BOOST_CHECK_EQUAL(reader.get().get_arena(), &reader.get_arena());
+        // earlier instances were released
+        BOOST_CHECK_EQUAL(reader.get_arena().get_num_blocks(), 1);
+        i++;
+    };
+    BOOST_CHECK_EQUAL(i, 1000);
+    BOOST_CHECK_EQUAL(reader.get_count(), 1000);
+    BOOST_CHECK_THROW(reader.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(instance_reader_selector_test)
+{
+    std::istringstream is(std::string("iAAAAvXXXXYYYYeZZZZ"));
+    InstanceReader reader(is, select_by_tag(scope));
+    BOOST_CHECK(reader.next());
+    BOOST_CHECK_EQUAL(reader.get().get<int>(), 0x41414141);
+    // keep a copy beyond the next instance
+    Instance first(reader.get());
+    BOOST_CHECK(reader.next());
+    BOOST_CHECK_EQUAL(reader.get().get<int>("y"), 0x59595959);
+    BOOST_CHECK(!reader.next());
+    BOOST_CHECK_EQUAL(reader.get_count(), 2);
+    BOOST_CHECK_EQUAL(first.get<int>(), 0x41414141);
+}
+
+BOOST_AUTO_TEST_CASE(instance_reader_truncated_test)
+{
+    std::istringstream is(std::string("XXXXYYYYXXXX"));
+    InstanceReader reader(is, scope.get_class("Vec"));
+    BOOST_CHECK(reader.next());
+    BOOST_CHECK_THROW(reader.next(), std::runtime_error);
+    BOOST_CHECK_THROW(reader.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -38,7 +38,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
+#include <type_traits>
 
+#include "pyffi/object_models/attr_handle.hpp"
 #include "pyffi/object_models/scope.hpp"
 #include "pyffi/object_models/instance.hpp"
 
@@ -58,7 +60,7 @@ BOOST_AUTO_TEST_CASE(constructor_test)
 
     // check the data
     Instance y(Int);
-    BOOST_CHECK_EQUAL(&y.class_, &Int);
+    BOOST_CHECK_EQUAL(&y.get_class(), &Int);
     BOOST_CHECK_EQUAL(y.get<int>(), 0);
 }
 
@@ -118,7 +120,7 @@ BOOST_AUTO_TEST_CASE(get_test)
 
     // check that get returns assigned value
     Instance obj_short(Short);
-    BOOST_CHECK_EQUAL(&obj_short.class_, &Short);
+    BOOST_CHECK_EQUAL(&obj_short.get_class(), &Short);
     BOOST_CHECK_EQUAL(obj_short.get<short>(), 0);
 
     // check bad type casts
@@ -133,7 +135,7 @@ BOOST_AUTO_TEST_CASE(get_test)
 
     // check copy constructor
     Instance obj_short2(obj_short);
-    BOOST_CHECK_EQUAL(&obj_short2.class_, &Short);
+    BOOST_CHECK_EQUAL(&obj_short2.get_class(), &Short);
     BOOST_CHECK_EQUAL(obj_short2.get<short>(), 10);
 }
 
@@ -205,4 +207,264 @@ BOOST_AUTO_TEST_CASE(assign_by_instance_test)
     BOOST_CHECK_THROW(x = c, std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(move_test)
+{
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        scope.push_back(Int);
+        scope.push_back(Vec);
+    }
+    Class & Int = get<Class>(scope[0]);
+    Class & Vec = get<Class>(scope[1]);
+    Int.set_type<int>();
+    scope.compile();
+
+    // containers can relocate instances without copying them
+    BOOST_CHECK(std::is_nothrow_move_constructible<Instance>::value);
+
+    // move construction takes over the attributes
+    Instance u(Vec);
+    u.get<int>("x") = 1;
+    Instance const *x = &u.attr("x");
+    Instance v(std::move(u));
+    BOOST_CHECK_EQUAL(&v.get_class(), &Vec);
+    BOOST_CHECK_EQUAL(&v.attr("x"), x);
+    BOOST_CHECK_EQUAL(v.get<int>("x"), 1);
+
+    // move assignment, but type cannot be changed
+    Instance w(Vec);
+    w = std::move(v);
+    BOOST_CHECK_EQUAL(&w.attr("x"), x);
+    Instance i(Int);
+    BOOST_CHECK_THROW(i = std::move(w), std::runtime_error);
+
+    // instances in a container
+    std::vector<Instance> instances;
+    for (int j = 0; j < 10; j++) {
+        instances.push_back(Instance(Vec));
+        instances.back().get<int>("y") = j;
+    };
+    instances.erase(instances.begin());
+    BOOST_CHECK_EQUAL(instances.front().get<int>("y"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(prototype_test)
+{
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        scope.push_back(Int);
+        scope.push_back(Vec);
+    }
+    Class & Int = get<Class>(scope[0]);
+    Class & Vec = get<Class>(scope[1]);
+    Int.set_type<int>();
+    scope.compile();
+
+    // instances are copies of the prototype, and do not share data
+    Instance u(Vec);
+    u.get<int>("x") = 1;
+    Instance v(Vec);
+    BOOST_CHECK_EQUAL(v.get<int>("x"), 0);
+    BOOST_CHECK(&u.attr("x") != &v.attr("x"));
+
+    // changing the implementation discards the prototype
+    Vec.set_flat();
+    // a packed class is a single run
+    BOOST_CHECK_EQUAL(Vec.get_flat_runs().size(), 1);
+    BOOST_CHECK_EQUAL(Vec.get_flat_runs()[0].size, 8);
+    Instance w(Vec);
+    BOOST_CHECK(w.is_flat());
+    BOOST_CHECK_EQUAL(w.get<int>("x"), 0);
+    Arena arena;
+    Instance a(Vec, arena);
+    BOOST_CHECK(a.is_flat());
+    BOOST_CHECK_EQUAL(a.get_arena(), &arena);
+}
+
+BOOST_AUTO_TEST_CASE(flat_test)
+{
+    // class Byte
+    // class Float
+    // class Vec:
+    //     Float x
+    //     Byte y
+    //     Float z
+    Scope scope;
+    {
+        Class Byte("Byte");
+        Class Float("Float");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Float", "x"));
+        Vec.scope.get().push_back(Attr("Byte", "y"));
+        Vec.scope.get().push_back(Attr("Float", "z"));
+        scope.push_back(Byte);
+        scope.push_back(Float);
+        scope.push_back(Vec);
+    }
+    Class & Byte = get<Class>(scope[0]);
+    Class & Float = get<Class>(scope[1]);
+    Class & Vec = get<Class>(scope[2]);
+    Byte.set_type<char>();
+    Float.set_type<float>();
+
+    // flat representation requires a layout
+    BOOST_CHECK_THROW(Vec.set_flat(), std::runtime_error);
+    scope.compile();
+    BOOST_CHECK_THROW(Float.set_flat(), std::runtime_error);
+
+    // attributes can be accessed by name in either representation
+    Instance u(Vec);
+    BOOST_CHECK(!u.is_flat());
+    u.get<float>("x") = 1.5f;
+    BOOST_CHECK_EQUAL(u.attr("x").get<float>(), 1.5f);
+
+    BOOST_CHECK_NO_THROW(Vec.set_flat());
+    // padding and mixed word sizes split the buffer into runs
+    BOOST_CHECK_EQUAL(Vec.get_flat_runs().size(), 3);
+    BOOST_CHECK_EQUAL(Vec.get_flat_runs()[2].offset, 8);
+    BOOST_CHECK_EQUAL(Vec.get_flat_runs()[2].word_size, 4);
+    Instance v(Vec);
+    BOOST_CHECK(v.is_flat());
+    BOOST_CHECK_EQUAL(v.get<float>("x"), 0.0f);
+    BOOST_CHECK_EQUAL(v.get<char>("y"), 0);
+    BOOST_CHECK_EQUAL(v.get<float>("z"), 0.0f);
+    BOOST_CHECK_THROW(v.get<int>("x"), std::runtime_error);
+    BOOST_CHECK_THROW(v.get<float>("oops"), std::runtime_error);
+    BOOST_CHECK_THROW(v.attr("x"), std::runtime_error);
+
+    // write and read back, without padding
+    v.get<float>("x") = 1.0f;
+    v.get<char>("y") = 'y';
+    v.get<float>("z") = 2.0f;
+    std::ostringstream os;
+    v.write(os);
+    BOOST_CHECK_EQUAL(os.str().size(), 9);
+    Instance w(Vec);
+    std::istringstream is(os.str());
+    w.read(is);
+    BOOST_CHECK_EQUAL(w.get<float>("x"), 1.0f);
+    BOOST_CHECK_EQUAL(w.get<char>("y"), 'y');
+    BOOST_CHECK_EQUAL(w.get<float>("z"), 2.0f);
+
+    // same from and to memory
+    std::string data(os.str());
+    ByteReader reader(data.data(), data.size());
+    Instance r(Vec);
+    r.read(reader);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+    BOOST_CHECK_EQUAL(r.get<char>("y"), 'y');
+    std::string buffer(9, ' ');
+    ByteWriter writer(&buffer[0], buffer.size());
+    r.write(writer);
+    BOOST_CHECK_EQUAL(buffer, data);
+
+    // copies do not share data
+    Instance const c(w);
+    w.get<float>("x") = 3.0f;
+    BOOST_CHECK_EQUAL(c.get<float>("x"), 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(attr_handle_test)
+{
+    // class Int
+    // class Float
+    // class Vec:
+    //     Float x
+    //     Float y
+    // class Vec3(Vec):
+    //     Float z
+    // class Name:
+    //     Vec v
+    //     Int n
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Float("Float");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Float", "x"));
+        Vec.scope.get().push_back(Attr("Float", "y"));
+        Class Vec3("Vec3");
+        Vec3.base_name = "Vec";
+        Vec3.scope = Scope();
+        Vec3.scope.get().push_back(Attr("Float", "z"));
+        Class Name("Name");
+        Name.scope = Scope();
+        Name.scope.get().push_back(Attr("Vec", "v"));
+        Name.scope.get().push_back(Attr("Int", "n"));
+        scope.push_back(Int);
+        scope.push_back(Float);
+        scope.push_back(Vec);
+        scope.push_back(Vec3);
+        scope.push_back(Name);
+    }
+    Class & Int = get<Class>(scope[0]);
+    Class & Float = get<Class>(scope[1]);
+    Class & Vec = get<Class>(scope[2]);
+    Class & Vec3 = get<Class>(scope[3]);
+    Class & Name = get<Class>(scope[4]);
+    Int.set_type<int>();
+    Float.set_type<float>();
+    scope.compile();
+
+    // resolution checks name and type
+    BOOST_CHECK_THROW(AttrHandle<float>(Vec, "oops"), std::runtime_error);
+    BOOST_CHECK_THROW(AttrHandle<int>(Vec, "x"), std::runtime_error);
+    BOOST_CHECK_THROW(AttrHandle<float>(Name, "v"), std::runtime_error);
+    AttrHandle<float> x(Vec, "x");
+    AttrHandle<float> z(Vec3, "z");
+    AttrHandle<int> n(Name, "n");
+
+    // access, also on derived classes
+    Instance u(Vec3);
+    x(u) = 1.0f;
+    z(u) = 3.0f;
+    BOOST_CHECK_EQUAL(u.get<float>("x"), 1.0f);
+    BOOST_CHECK_EQUAL(u.get<float>("z"), 3.0f);
+    Instance const & cu = u;
+    BOOST_CHECK_EQUAL(x(cu), 1.0f);
+
+    // classes without fixed size layout
+    Instance m(Name);
+    n(m) = 5;
+    BOOST_CHECK_EQUAL(m.get<int>("n"), 5);
+
+    // flat representation
+    Vec.set_flat();
+    Vec3.set_flat();
+    Instance v(Vec3);
+    x(v) = 2.0f;
+    z(v) = 4.0f;
+    BOOST_CHECK_EQUAL(v.get<float>("x"), 2.0f);
+    BOOST_CHECK_EQUAL(v.get<float>("z"), 4.0f);
+
+    // mismatching instances
+    Instance i(Int);
+    BOOST_CHECK_THROW(x(i), std::runtime_error);
+    BOOST_CHECK_THROW(n(u), std::runtime_error);
+    // a flat instance of a smaller class
+    Instance w(Vec);
+    BOOST_CHECK(w.is_flat());
+    BOOST_CHECK_THROW(z(w), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/instance_writer.hpp"
+int main()
+{
+    std::vector<char> buffer =
+        pyffi::object_models::write_buffer(std::vector<pyffi::object_models::Instance>());
+    return 0;
+};
@@ -0,0 +1,197 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <cstdio> // std::remove
+#include <cstring> // std::memcpy
+#include <fstream>
+#include <sstream>
+
+#include "pyffi/object_models/instance_writer.hpp"
+#include "pyffi/object_models/mapped_file.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(instance_writer_test_suite)
+
+BOOST_AUTO_TEST_CASE(instance_size_test)
+{
+    // class Byte
+    // class Int
+    // class Vec:
+    //     Byte x
+    //     Int y
+    // class Thing:
+    //     Vec v
+    //     if false
+    //         Int a
+    //     else
+    //         Byte b
+    Scope scope;
+    {
+        Class Byte("Byte");
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Byte", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        Class Thing("Thing");
+        Thing.scope = Scope();
+        Thing.scope.get().push_back(Attr("Vec", "v"));
+        IfElifsElse ifelifselse;
+        ifelifselse.ifs_.resize(1);
+        ifelifselse.ifs_[0].expr = false;
+        ifelifselse.ifs_[0].scope.push_back(Attr("Int", "a"));
+        ifelifselse.else_ = Scope();
+        ifelifselse.else_.get().push_back(Attr("Byte", "b"));
+        Thing.scope.get().push_back(ifelifselse);
+        scope.push_back(Byte);
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        scope.push_back(Thing);
+    }
+    get<Class>(scope[0]).set_type<unsigned char>();
+    get<Class>(scope[1]).set_type<int>();
+    scope.compile();
+    Class & Vec = get<Class>(scope[2]);
+    Class const & Thing = scope.get_class("Thing");
+    BOOST_CHECK_EQUAL(Instance(scope.get_class("Int")).size(), 4);
+    BOOST_CHECK_EQUAL(Instance(Vec).size(), 5);
+    BOOST_CHECK_EQUAL(Instance(Thing).size(), 6);
+    std::ostringstream os;
+    Instance(Thing).write(os);
+    BOOST_CHECK_EQUAL(os.str().size(), 6);
+    // flat: the padding of the buffer is not written
+    Vec.set_flat();
+    BOOST_CHECK_EQUAL(Vec.get_layout().get().size, 8);
+    BOOST_CHECK_EQUAL(Instance(Vec).size(), 5);
+}
+
+//! Data of a NiAVObject of version 20.0.0.5, with a name of three
+//! characters, two extra data, and one property; all other bytes
+//! count up.
+static std::string ni_av_object_data()
+{
+    std::string data;
+    for (int i = 0; i < 89; i++) {
+        data += static_cast<char>(i);
+    };
+    unsigned int length = 3, num_extra_data_list = 2, num_properties = 1;
+    std::memcpy(&data[0], &length, 4);
+    std::memcpy(&data[7], &num_extra_data_list, 4);
+    std::memcpy(&data[77], &num_properties, 4);
+    return data;
+};
+
+BOOST_AUTO_TEST_CASE(write_buffer_file_test)
+{
+    Scope scope;
+    std::ifstream in((std::string(TEST_PATH) + "/data/ffi/test_full.ffi").c_str());
+    BOOST_CHECK_EQUAL(scope.parse(in), true);
+    get<Class>(scope[0]).set_type<unsigned char>(); // Bool
+    get<Class>(scope[1]).set_type<unsigned char>(); // Byte
+    get<Class>(scope[2]).set_type<char>(); // Char
+    get<Class>(scope[3]).set_type<unsigned int>(); // UInt
+    get<Class>(scope[4]).set_type<unsigned short>(); // UShort
+    get<Class>(scope[5]).set_type<int>(); // Int
+    get<Class>(scope[6]).set_type<short>(); // Short
+    get<Class>(scope[7]).set_type<float>(); // Float
+    get<Class>(scope[8]).set_type<unsigned int>(); // StringIndex
+    get<Class>(scope[9]).set_type<int>(); // Ref
+    get<Class>(scope[10]).set_type<int>(); // Ptr
+    get<Class>(scope[11]).set_type<unsigned short>(); // Flags
+    scope.compile();
+    Class const & NiAVObject = scope.get_class("NiAVObject");
+
+    Globals globals;
+    globals.set("Version", 0x14000005);
+    std::string data = ni_av_object_data();
+    std::vector<Instance> instances;
+    for (int i = 0; i < 3; i++) {
+        instances.push_back(Instance(NiAVObject));
+        ByteReader reader(data.data(), data.size());
+        reader.set_globals(&globals);
+        instances.back().read(reader);
+    };
+    BOOST_CHECK_EQUAL(instances[0].size(&globals), 89);
+    // the version decides which attributes are written
+    BOOST_CHECK_EQUAL(instances[0].size(), 85);
+
+    std::vector<char> buffer = write_buffer(instances, Endian::NATIVE, &globals);
+    BOOST_CHECK(std::string(buffer.begin(), buffer.end()) == data + data + data);
+
+    // swapped twice gives back the original
+    std::vector<char> big = write_buffer(instances, Endian::BIG, &globals);
+    std::vector<char> little = write_buffer(instances, Endian::LITTLE, &globals);
+    BOOST_CHECK(big != little);
+    Instance obj(NiAVObject);
+    ByteReader reader(&big[0], big.size());
+    reader.set_endian(Endian::BIG);
+    reader.set_globals(&globals);
+    obj.read(reader);
+    std::vector<char> native = write_buffer(std::vector<Instance>(1, obj), Endian::NATIVE, &globals);
+    BOOST_CHECK(std::string(native.begin(), native.end()) == data);
+
+    write_file("instance_writer_test.bin", instances, Endian::NATIVE, &globals);
+    {
+        MappedFile file("instance_writer_test.bin");
+        BOOST_CHECK_EQUAL(file.size(), 3 * 89);
+        BOOST_CHECK(std::string(file.data(), file.size()) == data + data + data);
+    }
+    // a failed write keeps the existing file
+    instances[1].get<unsigned int>("num_properties") = 2;
+    BOOST_CHECK_THROW(
+        write_file("instance_writer_test.bin", instances, Endian::NATIVE, &globals),
+        std::runtime_error);
+    {
+        MappedFile file("instance_writer_test.bin");
+        BOOST_CHECK(std::string(file.data(), file.size()) == data + data + data);
+    }
+    write_file("instance_writer_test.bin", std::vector<Instance>());
+    {
+        MappedFile file("instance_writer_test.bin");
+        BOOST_CHECK_EQUAL(file.size(), 0);
+    }
+    std::remove("instance_writer_test.bin");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
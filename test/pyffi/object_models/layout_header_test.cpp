@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/layout.hpp"
+int main()
+{
+    pyffi::object_models::Layout layout;
+    return 0;
+};
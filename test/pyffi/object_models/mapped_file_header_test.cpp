@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/mapped_file.hpp"
+int main()
+{
+    // no default constructor
+    //pyffi::object_models::MappedFile file;
+    return 0;
+};
@@ -0,0 +1,99 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <cstdio> // std::remove
+#include <fstream>
+#include <sstream>
+
+#include "pyffi/object_models/mapped_file.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(mapped_file_test_suite)
+
+BOOST_AUTO_TEST_CASE(mapped_file_data_test)
+{
+    std::string filename = std::string(TEST_PATH) + "/data/ffi/test_basic.ffi";
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    std::ostringstream expected;
+    expected << is.rdbuf();
+
+    MappedFile file(filename);
+    BOOST_CHECK_EQUAL(file.size(), expected.str().size());
+    BOOST_CHECK_EQUAL(std::string(file.data(), file.size()), expected.str());
+
+    // read instances directly from the mapping
+    Class Int("Int");
+    Int.set_type<int>();
+    Instance x(Int);
+    ByteReader reader = file.reader();
+    x.read(reader);
+    BOOST_CHECK_EQUAL(reader.tell(), 4);
+    BOOST_CHECK_EQUAL(x.get<int>(), 0x73616c63); // "clas"
+}
+
+BOOST_AUTO_TEST_CASE(mapped_output_file_test)
+{
+    {
+        MappedOutputFile file("mapped_file_test.bin", 8);
+        BOOST_CHECK_EQUAL(file.size(), 8);
+        ByteWriter writer = file.writer();
+        writer.write("abcdefgh", 8);
+        BOOST_CHECK_THROW(writer.write("i", 1), std::runtime_error);
+        file.close();
+        BOOST_CHECK_NO_THROW(file.close());
+    }
+    {
+        MappedFile file("mapped_file_test.bin");
+        BOOST_CHECK_EQUAL(std::string(file.data(), file.size()), "abcdefgh");
+    }
+    std::remove("mapped_file_test.bin");
+}
+
+BOOST_AUTO_TEST_CASE(mapped_file_error_test)
+{
+    BOOST_CHECK_THROW(MappedFile("does/not/exist"), std::runtime_error);
+    BOOST_CHECK_THROW(MappedOutputFile("does/not/exist", 1), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
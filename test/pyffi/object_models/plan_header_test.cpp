@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/plan.hpp"
+int main()
+{
+    pyffi::object_models::Plan plan;
+    return 0;
+};
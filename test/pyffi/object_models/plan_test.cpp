@@ -0,0 +1,360 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstring> // std::memcpy
+#include <fstream>
+#include <sstream>
+
+#include "pyffi/object_models/array.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(plan_test_suite)
+
+BOOST_AUTO_TEST_CASE(plan_compile_test)
+{
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    // class Base:
+    //     Int a
+    // class Derived(Base):
+    //     Vec v
+    //     if a == 0
+    //         Int b
+    //     elif a != 1
+    //         Int c
+    //     else
+    //         Int b
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        Class Base("Base");
+        Base.scope = Scope();
+        Base.scope.get().push_back(Attr("Int", "a"));
+        Class Derived("Derived");
+        Derived.base_name = "Base";
+        Derived.scope = Scope();
+        Derived.scope.get().push_back(Attr("Vec", "v"));
+        IfElifsElse ifelifselse;
+        ifelifselse.ifs_.resize(2);
+        ifelifselse.ifs_[0].expr = Expr::parse("a == 0");
+        ifelifselse.ifs_[0].scope.push_back(Attr("Int", "b"));
+        ifelifselse.ifs_[1].expr = Expr::parse("a != 1");
+        ifelifselse.ifs_[1].scope.push_back(Attr("Int", "c"));
+        ifelifselse.else_ = Scope();
+        ifelifselse.else_.get().push_back(Attr("Int", "b"));
+        Derived.scope.get().push_back(ifelifselse);
+        scope.push_back(Int);
+        scope.push_back(Vec);
+        scope.push_back(Base);
+        scope.push_back(Derived);
+    }
+    Class & Int = get<Class>(scope[0]);
+    Class & Vec = get<Class>(scope[1]);
+    Class & Derived = get<Class>(scope[3]);
+    Int.set_type<int>();
+    scope.compile();
+
+    // consecutive primitive attributes are read as a single run
+    Plan const & vec_plan = Vec.get_plan();
+    BOOST_CHECK_EQUAL(vec_plan.size(), 3);
+    BOOST_CHECK_EQUAL(vec_plan[0].code, PlanOp::RUN);
+    BOOST_CHECK_EQUAL(vec_plan[0].size, 8);
+    BOOST_CHECK_EQUAL(vec_plan[0].word_size, 4);
+    BOOST_CHECK_EQUAL(vec_plan[0].target, 3);
+    BOOST_CHECK(vec_plan[1] == PlanOp(PlanOp::READ, 0, 4, 4));
+    BOOST_CHECK(vec_plan[2] == PlanOp(PlanOp::READ, 1, 4, 4));
+
+    // base class attributes come first, and branches jump
+    Plan const & plan = Derived.get_plan();
+    BOOST_CHECK_EQUAL(plan.size(), 9);
+    BOOST_CHECK(plan[0] == PlanOp(PlanOp::READ, 0, 4, 4)); // a
+    BOOST_CHECK(plan[1] == PlanOp(PlanOp::CLASS, 1));   // v
+    BOOST_CHECK_EQUAL(plan[2].code, PlanOp::BRANCH);    // if a == 0
+    BOOST_CHECK_EQUAL(plan[2].target, 5);
+    BOOST_CHECK(plan[3] == PlanOp(PlanOp::READ, 2, 4, 4)); // b
+    BOOST_CHECK_EQUAL(plan[4].code, PlanOp::JUMP);
+    BOOST_CHECK_EQUAL(plan[4].target, 9);
+    BOOST_CHECK_EQUAL(plan[5].code, PlanOp::BRANCH);    // elif a != 1
+    BOOST_CHECK_EQUAL(plan[5].target, 8);
+    BOOST_CHECK(plan[6] == PlanOp(PlanOp::READ, 3, 4, 4)); // c
+    BOOST_CHECK_EQUAL(plan[7].code, PlanOp::JUMP);
+    BOOST_CHECK_EQUAL(plan[7].target, 9);
+    BOOST_CHECK(plan[8] == PlanOp(PlanOp::READ, 2, 4, 4)); // b
+
+    // read takes the elif branch
+    Instance d(Derived);
+    std::istringstream is(std::string("AAAAXXXXYYYYCCCCrest"));
+    d.read(is);
+    BOOST_CHECK_EQUAL(is.tellg(), 16);
+    BOOST_CHECK_EQUAL(d.get<int>("a"), 0x41414141);
+    BOOST_CHECK_EQUAL(d.attr("v").get<int>("y"), 0x59595959);
+    BOOST_CHECK_EQUAL(d.get<int>("b"), 0);
+    BOOST_CHECK_EQUAL(d.get<int>("c"), 0x43434343);
+    std::ostringstream os;
+    d.write(os);
+    BOOST_CHECK_EQUAL(os.str(), "AAAAXXXXYYYYCCCC");
+}
+
+BOOST_AUTO_TEST_CASE(plan_fold_test)
+{
+    // constant conditions are decided when compiling, and runs
+    // continue through them
+    std::istringstream is(
+        "class Int\n"
+        "class Block\n"
+        "    Int a\n"
+        "    if 1 > 2\n"
+        "        Int b\n"
+        "    elif 1 + 1 == 2\n"
+        "        Int c\n"
+        "    else\n"
+        "        Int d\n"
+        "    if a\n"
+        "        Int e\n"
+        "    elif false\n"
+        "        Int f\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse(is), true);
+    get<Class>(scope[0]).set_type<int>();
+    scope.compile();
+    Plan const & plan = get<Class>(scope[1]).get_plan();
+    BOOST_CHECK_EQUAL(plan.size(), 5);
+    BOOST_CHECK_EQUAL(plan[0].code, PlanOp::RUN);
+    BOOST_CHECK_EQUAL(plan[0].size, 8);
+    BOOST_CHECK_EQUAL(plan[0].target, 3);
+    BOOST_CHECK(plan[1] == PlanOp(PlanOp::READ, 0, 4, 4)); // a
+    BOOST_CHECK(plan[2] == PlanOp(PlanOp::READ, 2, 4, 4)); // c
+    BOOST_CHECK_EQUAL(plan[3].code, PlanOp::BRANCH);       // if a
+    BOOST_CHECK_EQUAL(plan[3].target, 5);
+    BOOST_CHECK(plan[4] == PlanOp(PlanOp::READ, 4, 4, 4)); // e
+}
+
+BOOST_AUTO_TEST_CASE(plan_specialize_test)
+{
+    std::istringstream is(
+        "class Int\n"
+        "class Vec\n"
+        "    Int x\n"
+        "    Int y\n"
+        "class Block\n"
+        "    Int a\n"
+        "    if version >= 0x0A000000\n"
+        "        Int b\n"
+        "    else\n"
+        "        Vec v\n"
+        "    if a\n"
+        "        Int c\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse(is), true);
+    get<Class>(scope[0]).set_type<int>();
+    scope.compile();
+    Globals old_version;
+    old_version.set("version", 0x04000002);
+    Globals new_version;
+    new_version.set("version", 0x14000005);
+    scope.compile(old_version);
+    scope.compile(new_version);
+
+    // classes without conditions keep their plan
+    Class const & Vec = scope.get_class("Vec");
+    BOOST_CHECK_EQUAL(&Vec.get_plan(&new_version), &Vec.get_plan());
+
+    // the version branch is gone, and the run continues through it
+    Class const & Block = scope.get_class("Block");
+    BOOST_CHECK_EQUAL(Block.get_plan().size(), 7);
+    Plan const & new_plan = Block.get_plan(&new_version);
+    BOOST_CHECK_EQUAL(new_plan.size(), 5);
+    BOOST_CHECK_EQUAL(new_plan[0].code, PlanOp::RUN);
+    BOOST_CHECK_EQUAL(new_plan[0].target, 3);
+    BOOST_CHECK(new_plan[2] == PlanOp(PlanOp::READ, 1, 4, 4)); // b
+    BOOST_CHECK_EQUAL(new_plan[3].code, PlanOp::BRANCH);       // if a
+    Plan const & old_plan = Block.get_plan(&old_version);
+    BOOST_CHECK_EQUAL(old_plan.size(), 4);
+    BOOST_CHECK(old_plan[1] == PlanOp(PlanOp::CLASS, 2));      // v
+
+    // other variables get the generic plan
+    Globals other;
+    other.set("version", 0x14000005);
+    other.set("user_version", 11);
+    BOOST_CHECK_EQUAL(&Block.get_plan(&other), &Block.get_plan());
+
+    // all plans read the same
+    std::string data("\x01\0\0\0BBBBCCCC", 12);
+    Globals const * all_globals[] = {&new_version, &other};
+    BOOST_FOREACH(Globals const * globals, all_globals) {
+        Instance block(Block);
+        ByteReader reader(data.data(), data.size());
+        reader.set_globals(globals);
+        block.read(reader);
+        BOOST_CHECK_EQUAL(reader.remaining(), 0);
+        BOOST_CHECK_EQUAL(block.get<int>("b"), 0x42424242);
+        BOOST_CHECK_EQUAL(block.get<int>("c"), 0x43434343);
+        BOOST_CHECK_EQUAL(block.size(globals), 12);
+    };
+    Instance block(Block);
+    std::istringstream old_data(std::string("\0\0\0\0XXXXYYYY", 12));
+    set_globals(old_data, &old_version);
+    block.read(old_data);
+    BOOST_CHECK_EQUAL(old_data.tellg(), 12);
+    BOOST_CHECK_EQUAL(block.attr("v").get<int>("y"), 0x59595959);
+}
+
+//! Data of a NiAVObject of version 20.0.0.5, with a name of three
+//! characters, two extra data, and one property; all other bytes
+//! count up.
+static std::string ni_av_object_data()
+{
+    std::string data;
+    for (int i = 0; i < 89; i++) {
+        data += static_cast<char>(i);
+    };
+    unsigned int length = 3, num_extra_data_list = 2, num_properties = 1;
+    std::memcpy(&data[0], &length, 4);
+    std::memcpy(&data[7], &num_extra_data_list, 4);
+    std::memcpy(&data[77], &num_properties, 4);
+    return data;
+};
+
+BOOST_AUTO_TEST_CASE(plan_full_test)
+{
+    Scope scope;
+    std::ifstream in((std::string(TEST_PATH) + "/data/ffi/test_full.ffi").c_str());
+    BOOST_CHECK_EQUAL(scope.parse(in), true);
+    get<Class>(scope[0]).set_type<unsigned char>(); // Bool
+    get<Class>(scope[1]).set_type<unsigned char>(); // Byte
+    get<Class>(scope[2]).set_type<char>(); // Char
+    get<Class>(scope[3]).set_type<unsigned int>(); // UInt
+    get<Class>(scope[4]).set_type<unsigned short>(); // UShort
+    get<Class>(scope[5]).set_type<int>(); // Int
+    get<Class>(scope[6]).set_type<short>(); // Short
+    get<Class>(scope[7]).set_type<float>(); // Float
+    get<Class>(scope[8]).set_type<unsigned int>(); // StringIndex
+    get<Class>(scope[9]).set_type<int>(); // Ref
+    get<Class>(scope[10]).set_type<int>(); // Ptr
+    get<Class>(scope[11]).set_type<unsigned short>(); // Flags
+    scope.compile();
+
+    Class const & NiAVObject = scope.get_class("NiAVObject");
+    BOOST_CHECK_EQUAL(NiAVObject.get_plan().size(), 32);
+
+    // all nine floats of a matrix are read in a single run
+    Plan const & matrix_plan = scope.get_class("Matrix33").get_plan();
+    BOOST_CHECK_EQUAL(matrix_plan.size(), 10);
+    BOOST_CHECK_EQUAL(matrix_plan[0].code, PlanOp::RUN);
+    BOOST_CHECK_EQUAL(matrix_plan[0].size, 36);
+    BOOST_CHECK_EQUAL(matrix_plan[0].target, 10);
+
+    // reading and writing gives back the same data
+    Globals globals;
+    globals.set("Version", 0x14000005);
+    std::string data = ni_av_object_data();
+    Instance obj(NiAVObject);
+    std::istringstream is(data + "more");
+    set_globals(is, &globals);
+    obj.read(is);
+    BOOST_CHECK_EQUAL(is.tellg(), 89);
+    Instance const & name = obj.attr("name").attr("string");
+    BOOST_CHECK_EQUAL(name.get<unsigned int>("length"), 3);
+    BOOST_CHECK_EQUAL(std::string(name.get<Array>("value").get<char>(), 3), "\x04\x05\x06");
+    BOOST_CHECK_EQUAL(obj.get<Array>("extra_data_list").size(), 2);
+    BOOST_CHECK_EQUAL(obj.get<Array>("properties").get<int>()[0], 0x54535251);
+    std::ostringstream os;
+    set_globals(os, &globals);
+    obj.write(os);
+    BOOST_CHECK_EQUAL(os.str(), data);
+    BOOST_CHECK_EQUAL(obj.size(&globals), 89);
+
+    // same from and to memory
+    Instance obj2(NiAVObject);
+    ByteReader reader(data.data(), data.size());
+    reader.set_globals(&globals);
+    obj2.read(reader);
+    BOOST_CHECK_EQUAL(reader.remaining(), 0);
+    std::string buffer(89, ' ');
+    ByteWriter writer(&buffer[0], buffer.size());
+    writer.set_globals(&globals);
+    obj2.write(writer);
+    BOOST_CHECK_EQUAL(writer.remaining(), 0);
+    BOOST_CHECK_EQUAL(buffer, data);
+
+    // too short
+    Instance obj3(NiAVObject);
+    ByteReader short_reader(data.data(), 60);
+    short_reader.set_globals(&globals);
+    BOOST_CHECK_THROW(obj3.read(short_reader), std::runtime_error);
+
+    // specialized for the version, no branches are left
+    scope.compile(globals);
+    Plan const & specialized = NiAVObject.get_plan(&globals);
+    BOOST_CHECK_EQUAL(specialized.size(), 12);
+    BOOST_FOREACH(PlanOp const & op, specialized) {
+        BOOST_CHECK(op.code != PlanOp::BRANCH);
+    };
+    Instance obj4(NiAVObject);
+    ByteReader reader4(data.data(), data.size());
+    reader4.set_globals(&globals);
+    obj4.read(reader4);
+    BOOST_CHECK_EQUAL(reader4.remaining(), 0);
+    std::ostringstream os4;
+    set_globals(os4, &globals);
+    obj4.write(os4);
+    BOOST_CHECK_EQUAL(os4.str(), data);
+
+    // found again after the variables change, and for equal variables
+    Globals other(globals);
+    BOOST_CHECK_EQUAL(&NiAVObject.get_plan(&other), &specialized);
+    other.set("Version", 0x14000004);
+    BOOST_CHECK_EQUAL(&NiAVObject.get_plan(&other), &NiAVObject.get_plan());
+    other.set("Version", 0x14000005);
+    BOOST_CHECK_EQUAL(&NiAVObject.get_plan(&other), &specialized);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
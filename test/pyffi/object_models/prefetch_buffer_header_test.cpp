@@ -0,0 +1,8 @@
+// check that header compiles
+#include "pyffi/object_models/prefetch_buffer.hpp"
+int main()
+{
+    // no default constructor
+    //pyffi::object_models::PrefetchBuffer buffer;
+    return 0;
+};
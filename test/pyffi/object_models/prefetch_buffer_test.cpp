@@ -0,0 +1,167 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <stdexcept>
+
+#include "pyffi/object_models/instance_reader.hpp"
+#include "pyffi/object_models/prefetch_buffer.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! A stream buffer which fails after some bytes.
+class failing_buffer : public std::streambuf
+{
+public:
+    failing_buffer(std::size_t size) : size(size) {};
+
+protected:
+    int_type underflow() {
+        if (size == 0) {
+            throw std::runtime_error("device error");
+        };
+        size--;
+        buffer = 'x';
+        setg(&buffer, &buffer, &buffer + 1);
+        return traits_type::to_int_type(buffer);
+    };
+
+private:
+    std::size_t size;
+    char buffer;
+};
+
+BOOST_AUTO_TEST_SUITE(prefetch_buffer_test_suite)
+
+BOOST_AUTO_TEST_CASE(prefetch_buffer_data_test)
+{
+    std::string data;
+    for (int i = 0; i < 10000; i++) {
+        data += static_cast<char>(i * 7);
+    };
+    std::size_t chunk_sizes[] = {1, 7, 4096, 100000};
+    std::size_t depths[] = {1, 3};
+    BOOST_FOREACH(std::size_t chunk_size, chunk_sizes) {
+        BOOST_FOREACH(std::size_t depth, depths) {
+            std::stringbuf source(data);
+            PrefetchBuffer buffer(source, chunk_size, depth);
+            std::istream is(&buffer);
+            std::string result(100, ' ');
+            is.read(&result[0], 100);
+            BOOST_CHECK_EQUAL(is.tellg(), 100);
+            result.resize(data.size());
+            is.read(&result[100], data.size() - 100);
+            BOOST_CHECK_EQUAL(is.gcount(), data.size() - 100);
+            BOOST_CHECK(result == data);
+            BOOST_CHECK_EQUAL(is.peek(), std::istream::traits_type::eof());
+        };
+    };
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_buffer_instance_test)
+{
+    // class Int
+    // class Vec:
+    //     Int x
+    //     Int y
+    Scope scope;
+    {
+        Class Int("Int");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Int", "x"));
+        Vec.scope.get().push_back(Attr("Int", "y"));
+        scope.push_back(Int);
+        scope.push_back(Vec);
+    }
+    get<Class>(scope[0]).set_type<int>();
+    scope.compile();
+    std::string data;
+    for (int i = 0; i < 1000; i++) {
+        data += std::string(reinterpret_cast<char const *>(&i), 4);
+        data += std::string(reinterpret_cast<char const *>(&i), 4);
+    };
+    // chunks do not align with instances
+    std::stringbuf source(data);
+    PrefetchBuffer buffer(source, 13, 2);
+    std::istream is(&buffer);
+    InstanceReader reader(is, scope.get_class("Vec"));
+    int i = 0;
+    while (reader.next()) {
+        BOOST_CHECK_EQUAL(reader.get().get<int>("y"), i);
+        i++;
+    };
+    BOOST_CHECK_EQUAL(i, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_buffer_error_test)
+{
+    BOOST_CHECK_THROW(
+        PrefetchBuffer(*std::cin.rdbuf(), 0, 1), std::runtime_error);
+    failing_buffer source(10);
+    PrefetchBuffer buffer(source, 4, 1);
+    std::istream is(&buffer);
+    // all complete chunks arrive, then the error
+    std::size_t count = 0;
+    while (is.get() == 'x') {
+        count++;
+    };
+    BOOST_CHECK_EQUAL(count, 8);
+    BOOST_CHECK(is.bad());
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_buffer_stop_test)
+{
+    // destroying the buffer early stops the thread
+    std::string data(100000, 'x');
+    std::stringbuf source(data);
+    {
+        PrefetchBuffer buffer(source, 16, 4);
+        std::istream is(&buffer);
+        is.get();
+    }
+    BOOST_CHECK(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
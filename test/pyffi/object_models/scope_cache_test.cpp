@@ -0,0 +1,223 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio> // std::remove
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "pyffi/object_models/scope.hpp"
+
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Read a whole file.
+static std::string read_file(std::string const & filename)
+{
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+};
+
+//! Generate the format description of a scope.
+static std::string generate(Scope const & scope)
+{
+    std::ostringstream os;
+    BOOST_CHECK_EQUAL(scope.generate(os), true);
+    return os.str();
+};
+
+struct CacheFixture {
+    CacheFixture()
+        : xml(read_file(std::string(TEST_PATH) + "/data/xml/test_full.xml")),
+          source_hash(Scope::hash_source(xml)) {
+        std::istringstream is(xml);
+        BOOST_CHECK_EQUAL(scope.parse_xml(is), true);
+        std::ostringstream os;
+        scope.write_cache(os, source_hash);
+        cache = os.str();
+    };
+
+    std::string xml;
+    std::uint64_t source_hash;
+    Scope scope;
+    std::string cache;
+};
+
+BOOST_FIXTURE_TEST_SUITE(scope_cache_test_suite, CacheFixture)
+
+BOOST_AUTO_TEST_CASE(scope_cache_round_trip_test)
+{
+    Scope result;
+    BOOST_CHECK_EQUAL(result.read_cache(cache.data(), cache.size(), source_hash), true);
+    BOOST_CHECK(result == scope);
+    BOOST_CHECK(result.versions == scope.versions);
+    BOOST_CHECK_EQUAL(generate(result), generate(scope));
+}
+
+BOOST_AUTO_TEST_CASE(scope_cache_round_trip_ffi_test)
+{
+    // the ffi format has hexadecimal and boolean literals, and else parts
+    Scope ffi;
+    std::ifstream is((std::string(TEST_PATH) + "/data/ffi/test_full.ffi").c_str());
+    BOOST_CHECK_EQUAL(ffi.parse(is), true);
+    std::ostringstream os;
+    ffi.write_cache(os, 0);
+    std::string data = os.str();
+    Scope result;
+    BOOST_CHECK_EQUAL(result.read_cache(data.data(), data.size(), 0), true);
+    BOOST_CHECK(result == ffi);
+    BOOST_CHECK_EQUAL(generate(result), generate(ffi));
+}
+
+BOOST_AUTO_TEST_CASE(scope_cache_expr_test)
+{
+    Scope ffi;
+    std::istringstream is(
+        "class Int\n"
+        "class Test\n"
+        "    Int x\n"
+        "    if (x & 0x1F) != -3 && !false\n"
+        "        Int y[~x >> 2]\n"
+        "    else\n"
+        "        Int z\n");
+    BOOST_CHECK_EQUAL(ffi.parse(is), true);
+    std::ostringstream os;
+    ffi.write_cache(os, 0);
+    std::string data = os.str();
+    Scope result;
+    BOOST_CHECK_EQUAL(result.read_cache(data.data(), data.size(), 0), true);
+    BOOST_CHECK(result == ffi);
+    BOOST_CHECK_EQUAL(generate(result), generate(ffi));
+}
+
+BOOST_AUTO_TEST_CASE(scope_cache_invalid_test)
+{
+    Scope result;
+    // another source
+    BOOST_CHECK_EQUAL(result.read_cache(cache.data(), cache.size(), source_hash + 1), false);
+    BOOST_CHECK(result.empty());
+    // another format version
+    std::string data = cache;
+    data[8]++;
+    BOOST_CHECK_EQUAL(result.read_cache(data.data(), data.size(), source_hash), false);
+    // not a cache at all
+    BOOST_CHECK_EQUAL(result.read_cache(xml.data(), xml.size(), source_hash), false);
+    BOOST_CHECK_EQUAL(result.read_cache(cache.data(), 10, source_hash), false);
+    // truncated or extended cache
+    BOOST_CHECK_THROW(result.read_cache(cache.data(), cache.size() - 1, source_hash), std::runtime_error);
+    data = cache + '\0';
+    BOOST_CHECK_THROW(result.read_cache(data.data(), data.size(), source_hash), std::runtime_error);
+    BOOST_CHECK(result.empty());
+}
+
+BOOST_AUTO_TEST_CASE(scope_cache_hash_test)
+{
+    BOOST_CHECK_EQUAL(Scope::hash_source(""), 14695981039346656037ULL);
+    BOOST_CHECK(Scope::hash_source(xml) != Scope::hash_source(xml + " "));
+}
+
+BOOST_AUTO_TEST_CASE(scope_parse_xml_cached_test)
+{
+    std::string filename = "scope_cache_test.bin";
+    std::remove(filename.c_str());
+    {
+        // no cache yet: parse, and write the cache
+        Scope result;
+        std::istringstream is(xml);
+        BOOST_CHECK_EQUAL(result.parse_xml_cached(is, filename), true);
+        BOOST_CHECK(result == scope);
+        BOOST_CHECK(read_file(filename) == cache);
+    }
+    {
+        // up to date cache: it is used instead of the xml, as shown by
+        // caching another scope for the same source
+        Scope other;
+        std::istringstream is("class Int\nclass Other\n    Int x\n");
+        BOOST_CHECK_EQUAL(other.parse(is), true);
+        {
+            std::ofstream os(filename.c_str(), std::ios::binary);
+            other.write_cache(os, source_hash);
+        }
+        Scope result;
+        std::istringstream xml_is(xml);
+        BOOST_CHECK_EQUAL(result.parse_xml_cached(xml_is, filename), true);
+        BOOST_CHECK(result == other);
+    }
+    {
+        // changed source: the cache is replaced
+        Scope result;
+        std::istringstream is(xml);
+        std::ofstream os(filename.c_str(), std::ios::binary);
+        os << "corrupt";
+        os.close();
+        BOOST_CHECK_EQUAL(result.parse_xml_cached(is, filename), true);
+        BOOST_CHECK(result == scope);
+        BOOST_CHECK(read_file(filename) == cache);
+    }
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(scope_parse_xml_cached_concurrent_test)
+{
+    // writers of the same cache use their own temporary files
+    std::string filename = "scope_cache_concurrent_test.bin";
+    std::remove(filename.c_str());
+    std::vector<int> results(4, 0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < results.size(); t++) {
+        threads.push_back(std::thread([this, t, &filename, &results]() {
+            Scope result;
+            std::istringstream is(xml);
+            results[t] = result.parse_xml_cached(is, filename) && result == scope;
+        }));
+    };
+    for (std::size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+        BOOST_CHECK_EQUAL(results[t], 1);
+    };
+    BOOST_CHECK(read_file(filename) == cache);
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
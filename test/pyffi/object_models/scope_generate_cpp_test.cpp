@@ -0,0 +1,280 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <cstring> // std::memcpy
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "pyffi/object_models/array.hpp"
+#include "pyffi/object_models/scope.hpp"
+
+// generated from the scope of the fixture, by Scope::generate_cpp
+#include "../../data/cpp/mesh.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+//! Build a scope from its ffi description, set its primitive types,
+//! and compile it.
+class MeshFixture
+{
+public:
+    MeshFixture() : scope(), data() {
+        std::istringstream is(
+            "class UShort\n"
+            "class UInt\n"
+            "class Float\n"
+            "class SizedString\n"
+            "class Vector3\n"
+            "    \"\"\"A vector.\"\"\"\n"
+            "    Float x\n"
+            "    Float y\n"
+            "    Float z\n"
+            "class Object\n"
+            "    \"\"\"Base of all objects.\"\"\"\n"
+            "    SizedString name\n"
+            "        \"\"\"The name.\"\"\"\n"
+            "class Mesh(Object)\n"
+            "    UShort num_vertices\n"
+            "    Vector3 vertices[num_vertices]\n"
+            "    if version >= 0x14000005\n"
+            "        UShort flags\n"
+            "    else\n"
+            "        UInt old_flags\n"
+            "    UShort num_uv_sets\n"
+            "    Float uvs[num_uv_sets][2 * num_vertices]\n"
+            "    UShort num_names\n"
+            "    SizedString names[num_names]\n"
+            "    UShort num_children\n"
+            "    Object children[num_children]\n"
+            "    if (flags & 0x1) != 0 && num_vertices > 1\n"
+            "        UInt default\n");
+        BOOST_REQUIRE(scope.parse(is));
+        get<Class>(scope[0]).set_type<unsigned short>();
+        get<Class>(scope[1]).set_type<unsigned int>();
+        get<Class>(scope[2]).set_type<float>();
+        get<Class>(scope[3]).set_sized_string<unsigned int>();
+        scope.compile();
+    };
+
+    //! Append a value to the data of a mesh.
+    template <typename T>
+    void append(T const & value) {
+        char const *bytes = reinterpret_cast<char const *>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    };
+
+    //! Append a length prefixed string to the data of a mesh.
+    void append(std::string const & str) {
+        append<unsigned int>(str.size());
+        data.insert(data.end(), str.begin(), str.end());
+    };
+
+    //! The data of a mesh with two vertices, of the given version.
+    void append_mesh(bool new_version) {
+        append(std::string("mesh"));
+        append<unsigned short>(2);
+        for (int i = 1; i <= 6; i++) {
+            append(float(i));
+        };
+        if (new_version) {
+            append<unsigned short>(1);
+        } else {
+            append<unsigned int>(5);
+        };
+        append<unsigned short>(1);
+        append(0.0f);
+        append(0.25f);
+        append(0.5f);
+        append(0.75f);
+        append<unsigned short>(2);
+        append(std::string("first"));
+        append(std::string("second"));
+        append<unsigned short>(1);
+        append(std::string("child"));
+        if (new_version) {
+            append<unsigned int>(99);
+        };
+    };
+
+    Scope scope;
+    std::vector<char> data;
+};
+
+BOOST_FIXTURE_TEST_SUITE(scope_generate_cpp_test_suite, MeshFixture)
+
+BOOST_AUTO_TEST_CASE(scope_generate_cpp_test)
+{
+    std::ostringstream os;
+    BOOST_CHECK_EQUAL(scope.generate_cpp(os, "mesh"), true);
+    std::ifstream is((std::string(TEST_PATH) + "/data/cpp/mesh.hpp").c_str(), std::ios::binary);
+    std::ostringstream expected;
+    expected << is.rdbuf();
+    BOOST_CHECK_EQUAL(os.str(), expected.str());
+}
+
+BOOST_AUTO_TEST_CASE(scope_generate_cpp_read_write_test)
+{
+    for (int new_version = 0; new_version <= 1; new_version++) {
+        data.clear();
+        append_mesh(new_version);
+        Globals globals;
+        globals.set("version", new_version ? 0x14000005 : 0x04000002);
+
+        // the dynamic object model
+        Instance instance(get<Class>(scope[6]));
+        ByteReader instance_reader(data.data(), data.size());
+        instance_reader.set_globals(&globals);
+        instance.read(instance_reader);
+        BOOST_CHECK_EQUAL(instance_reader.remaining(), 0);
+
+        // the generated code reads the same
+        mesh::Mesh mesh;
+        ByteReader reader(data.data(), data.size());
+        reader.set_globals(&globals);
+        read(mesh, reader);
+        BOOST_CHECK_EQUAL(reader.remaining(), 0);
+        BOOST_CHECK(mesh.name == instance.get<ByteView>("name"));
+        BOOST_CHECK_EQUAL(mesh.vertices.size(), 2);
+        BOOST_CHECK_EQUAL(mesh.vertices[1].y, 5.0f);
+        BOOST_CHECK_EQUAL(mesh.flags, instance.get<unsigned short>("flags"));
+        BOOST_CHECK_EQUAL(mesh.old_flags, instance.get<unsigned int>("old_flags"));
+        BOOST_CHECK_EQUAL(mesh.uvs.size(), 4);
+        BOOST_CHECK_EQUAL(mesh.uvs[3], instance.get<Array>("uvs").get<float>()[3]);
+        BOOST_CHECK_EQUAL(mesh.names.size(), 2);
+        BOOST_CHECK(mesh.names[1] == std::string("second"));
+        BOOST_CHECK_EQUAL(mesh.children.size(), 1);
+        BOOST_CHECK(mesh.children[0].name == std::string("child"));
+        BOOST_CHECK_EQUAL(mesh.default_, instance.get<unsigned int>("default"));
+        BOOST_CHECK_EQUAL(mesh.default_, new_version ? 99 : 0);
+
+        // and writes the original data
+        std::vector<char> buffer(data.size());
+        ByteWriter writer(buffer.data(), buffer.size());
+        writer.set_globals(&globals);
+        write(mesh, writer);
+        BOOST_CHECK(buffer == data);
+
+        // arrays must match their length
+        mesh.uvs.pop_back();
+        ByteWriter short_writer(buffer.data(), buffer.size());
+        short_writer.set_globals(&globals);
+        BOOST_CHECK_THROW(write(mesh, short_writer), std::runtime_error);
+    };
+}
+
+BOOST_AUTO_TEST_CASE(scope_generate_cpp_foreign_endian_test)
+{
+    append_mesh(true);
+    Globals globals;
+    globals.set("version", 0x14000005);
+    mesh::Mesh mesh;
+    ByteReader reader(data.data(), data.size());
+    reader.set_globals(&globals);
+    read(mesh, reader);
+    // written in a foreign byte order, and read back
+    std::vector<char> buffer(data.size());
+    ByteWriter writer(buffer.data(), buffer.size());
+    writer.set_globals(&globals);
+    writer.set_endian(native_endian() == Endian::LITTLE ? Endian::BIG : Endian::LITTLE);
+    write(mesh, writer);
+    BOOST_CHECK(buffer != data);
+    mesh::Mesh copy;
+    ByteReader copy_reader(buffer.data(), buffer.size());
+    copy_reader.set_globals(&globals);
+    copy_reader.set_endian(writer.get_endian());
+    read(copy, copy_reader);
+    BOOST_CHECK_EQUAL(copy.vertices[1].y, 5.0f);
+    BOOST_CHECK_EQUAL(copy.uvs[3], 0.75f);
+    BOOST_CHECK(copy.names[0] == std::string("first"));
+    BOOST_CHECK_EQUAL(copy.default_, 99);
+}
+
+BOOST_AUTO_TEST_CASE(scope_generate_cpp_corrupt_length_test)
+{
+    append_mesh(true);
+    Globals globals;
+    globals.set("version", 0x14000005);
+    mesh::Mesh mesh;
+    ByteReader reader(data.data(), data.size());
+    reader.set_globals(&globals);
+    read(mesh, reader);
+    // without names and children, num_names is followed by
+    // num_children and default
+    mesh.names.clear();
+    mesh.num_names = 0;
+    mesh.children.clear();
+    mesh.num_children = 0;
+    std::vector<char> buffer(data.size());
+    ByteWriter writer(buffer.data(), buffer.size());
+    writer.set_globals(&globals);
+    write(mesh, writer);
+    buffer.resize(buffer.size() - writer.remaining());
+    unsigned short const num_names = 60000;
+    std::memcpy(&buffer[buffer.size() - 8], &num_names, 2);
+    // the length is checked before the names are allocated
+    mesh::Mesh corrupt;
+    ByteReader corrupt_reader(buffer.data(), buffer.size());
+    corrupt_reader.set_globals(&globals);
+    BOOST_CHECK_THROW(read(corrupt, corrupt_reader), std::runtime_error);
+    BOOST_CHECK_EQUAL(corrupt.num_names, 60000);
+    BOOST_CHECK(corrupt.names.empty());
+}
+
+BOOST_AUTO_TEST_CASE(scope_generate_cpp_invalid_test)
+{
+    std::ostringstream os;
+    BOOST_CHECK_THROW(scope.generate_cpp(os, "not a namespace"), std::runtime_error);
+    // classes must be compiled
+    Scope uncompiled;
+    std::istringstream is("class Int\n");
+    BOOST_REQUIRE(uncompiled.parse(is));
+    BOOST_CHECK_THROW(uncompiled.generate_cpp(os, "test"), std::runtime_error);
+    // and their types must be numbers
+    get<Class>(uncompiled[0]).set_type<std::string>();
+    uncompiled.compile();
+    BOOST_CHECK_THROW(uncompiled.generate_cpp(os, "test"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
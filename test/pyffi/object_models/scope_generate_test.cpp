@@ -89,6 +89,19 @@ BOOST_AUTO_TEST_CASE(ast_generate_attr_test)
     GenerateParseFixture(scope, "Int x\n");
 }
 
+BOOST_AUTO_TEST_CASE(ast_generate_attr_array_test)
+{
+    Scope scope;
+    Attr x("Int", "x");
+    x.arr1 = Expr::name("num_x");
+    Attr uv("Float", "uv");
+    uv.arr1 = Expr::binary(Expr::SUB, Expr::name("num_uvs"), Expr::constant(1));
+    uv.arr2 = Expr::constant(2);
+    scope.push_back(x);
+    scope.push_back(uv);
+    GenerateParseFixture(scope, "Int x[num_x]\nFloat uv[num_uvs - 1][2]\n");
+}
+
 BOOST_AUTO_TEST_CASE(ast_parse_attr_doc_test)
 {
     Scope scope;
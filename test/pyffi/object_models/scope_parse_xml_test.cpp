@@ -42,6 +42,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 #include <fstream>
 
+#include "pyffi/object_models/instance.hpp"
 #include "pyffi/object_models/scope.hpp"
 
 using boost::get;
@@ -103,6 +104,76 @@ BOOST_AUTO_TEST_CASE(scope_parse_xml_invalid_test)
 BOOST_AUTO_TEST_CASE(scope_parse_xml_version_test)
 {
     XmlParser xml("/data/xml/test_version.xml");
+    BOOST_CHECK(xml.scope.empty());
+    BOOST_CHECK_EQUAL(xml.scope.versions.size(), 18);
+    BOOST_CHECK_EQUAL(xml.scope.versions[0], 0x02030000);
+    BOOST_CHECK_EQUAL(xml.scope.versions[2], 0x03000300);
+    BOOST_CHECK_EQUAL(xml.scope.versions[4], 0x0303000D);
+    BOOST_CHECK_EQUAL(xml.scope.versions[16], 0x0A01006A);
+}
+
+BOOST_AUTO_TEST_CASE(scope_parse_xml_version_global_test)
+{
+    // version ranges refer to the file version, not to an attribute
+    // of the same name
+    std::istringstream is(
+        "<niftoolsxml>\n"
+        "<basic name=\"uint\" />\n"
+        "<compound name=\"Header\">\n"
+        "  <add name=\"Version\" type=\"uint\" />\n"
+        "  <add name=\"Extra\" type=\"uint\" ver1=\"10.0.1.0\" />\n"
+        "</compound>\n"
+        "</niftoolsxml>\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse_xml(is), true);
+    get<Class>(scope[0]).set_type<unsigned int>();
+    scope.compile();
+    Class const & Header = scope.get_class("Header");
+    Globals globals;
+    globals.set("Version", 0x0A000100);
+    Instance header(Header);
+    std::istringstream data(std::string("\0\0\0\0EEEE", 8));
+    set_globals(data, &globals);
+    header.read(data);
+    BOOST_CHECK_EQUAL(header.get<unsigned int>("version"), 0);
+    BOOST_CHECK_EQUAL(header.get<unsigned int>("extra"), 0x45454545);
+}
+
+BOOST_AUTO_TEST_CASE(scope_parse_xml_vercond_test)
+{
+    // version conditions refer to the file version as well, and
+    // compare against dotted versions
+    std::istringstream is(
+        "<niftoolsxml>\n"
+        "<basic name=\"uint\" />\n"
+        "<compound name=\"Header\">\n"
+        "  <add name=\"Version\" type=\"uint\" />\n"
+        "  <add name=\"Extra\" type=\"uint\"\n"
+        "       vercond=\"(Version &gt;= 20.2.0.7) &amp;&amp; (User Version == 11)\" />\n"
+        "</compound>\n"
+        "</niftoolsxml>\n");
+    Scope scope;
+    BOOST_CHECK_EQUAL(scope.parse_xml(is), true);
+    get<Class>(scope[0]).set_type<unsigned int>();
+    scope.compile();
+    Class const & Header = scope.get_class("Header");
+    Globals globals;
+    globals.set("Version", 0x14020007);
+    globals.set("user_version", 11);
+    Instance header(Header);
+    std::istringstream data(std::string("\0\0\0\0EEEE", 8));
+    set_globals(data, &globals);
+    header.read(data);
+    BOOST_CHECK_EQUAL(header.get<unsigned int>("version"), 0);
+    BOOST_CHECK_EQUAL(header.get<unsigned int>("extra"), 0x45454545);
+
+    globals.set("Version", 0x14020006);
+    Instance old_header(Header);
+    std::istringstream old_data(std::string("\0\0\0\0EEEE", 8));
+    set_globals(old_data, &globals);
+    old_header.read(old_data);
+    BOOST_CHECK_EQUAL(old_header.get<unsigned int>("extra"), 0);
+    BOOST_CHECK_EQUAL(old_data.tellg(), 4);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
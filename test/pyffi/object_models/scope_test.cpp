@@ -236,4 +236,99 @@ BOOST_AUTO_TEST_CASE(ast_compile_complex_test)
     BOOST_CHECK_EQUAL(&Color.get_base_class().get(), &Vec);
 }
 
+BOOST_AUTO_TEST_CASE(ast_compile_layout_test)
+{
+    Scope scope;
+    // keep scope construction local; test should use scope only
+    {
+        // class Byte
+        // class Float
+        // class Vec:
+        //     Float x
+        //     Float y
+        //     Float z
+        // class Mixed:
+        //     Byte a
+        //     Float b
+        //     Byte c
+        // class Color(Vec):
+        //     Byte alpha
+        // class Cond:
+        //     if true:
+        //         Float x
+        // class Box:
+        //     Cond cond
+        Class Byte("Byte");
+        Class Float("Float");
+        Class Vec("Vec");
+        Vec.scope = Scope();
+        Vec.scope.get().push_back(Attr("Float", "x"));
+        Vec.scope.get().push_back(Attr("Float", "y"));
+        Vec.scope.get().push_back(Attr("Float", "z"));
+        Class Mixed("Mixed");
+        Mixed.scope = Scope();
+        Mixed.scope.get().push_back(Attr("Byte", "a"));
+        Mixed.scope.get().push_back(Attr("Float", "b"));
+        Mixed.scope.get().push_back(Attr("Byte", "c"));
+        Class Color("Color");
+        Color.base_name = "Vec";
+        Color.scope = Scope();
+        Color.scope.get().push_back(Attr("Byte", "alpha"));
+        Class Cond("Cond");
+        IfElifsElse ifelifselse;
+        ifelifselse.ifs_.resize(1);
+        ifelifselse.ifs_[0].expr = true;
+        ifelifselse.ifs_[0].scope.push_back(Attr("Float", "x"));
+        Cond.scope = Scope();
+        Cond.scope.get().push_back(ifelifselse);
+        Class Box("Box");
+        Box.scope = Scope();
+        Box.scope.get().push_back(Attr("Cond", "cond"));
+        scope.push_back(Byte);
+        scope.push_back(Float);
+        scope.push_back(Vec);
+        scope.push_back(Mixed);
+        scope.push_back(Color);
+        scope.push_back(Cond);
+        scope.push_back(Box);
+    }
+
+    Class & Byte = get<Class>(scope[0]);
+    Class & Float = get<Class>(scope[1]);
+    Class & Vec = get<Class>(scope[2]);
+    Class & Mixed = get<Class>(scope[3]);
+    Class & Color = get<Class>(scope[4]);
+    Class & Cond = get<Class>(scope[5]);
+    Class & Box = get<Class>(scope[6]);
+
+    // primitive types have a layout as soon as their type is set
+    BOOST_CHECK(!Byte.get_layout());
+    Byte.set_type<unsigned char>();
+    Float.set_type<float>();
+    BOOST_CHECK(Byte.get_layout().get() == Layout(1, 1));
+    BOOST_CHECK(Float.get_layout().get() == Layout(4, 4));
+    BOOST_CHECK(!Vec.get_layout());
+
+    scope.compile();
+
+    // check layouts
+    BOOST_CHECK(Vec.get_layout().get() == Layout(12, 4));
+    BOOST_CHECK(Mixed.get_layout().get() == Layout(12, 4));
+    BOOST_CHECK(Color.get_layout().get() == Layout(16, 4));
+    BOOST_CHECK(!Cond.get_layout());
+    BOOST_CHECK(!Box.get_layout());
+
+    // check offsets
+    BOOST_CHECK_EQUAL(Vec.get_attr("x").get_offset(), 0);
+    BOOST_CHECK_EQUAL(Vec.get_attr("y").get_offset(), 4);
+    BOOST_CHECK_EQUAL(Vec.get_attr("z").get_offset(), 8);
+    BOOST_CHECK_EQUAL(Mixed.get_attr("a").get_offset(), 0);
+    BOOST_CHECK_EQUAL(Mixed.get_attr("b").get_offset(), 4);
+    BOOST_CHECK_EQUAL(Mixed.get_attr("c").get_offset(), 8);
+    BOOST_CHECK_EQUAL(Color.get_attr("z").get_offset(), 8);
+    BOOST_CHECK_EQUAL(Color.get_attr("alpha").get_offset(), 12);
+    BOOST_CHECK_THROW(Cond.get_attr("x").get_offset(), std::runtime_error);
+    BOOST_CHECK_THROW(Box.get_attr("cond").get_offset(), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/symbol.hpp"
+int main()
+{
+    pyffi::object_models::Symbol symbol;
+    return 0;
+};
@@ -0,0 +1,162 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <boost/unordered_set.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "pyffi/object_models/scope.hpp"
+#include "pyffi/object_models/symbol.hpp"
+
+using boost::get;
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(symbol_test_suite)
+
+BOOST_AUTO_TEST_CASE(symbol_intern_test)
+{
+    Symbol empty;
+    BOOST_CHECK_EQUAL(empty.get_id(), 0);
+    BOOST_CHECK_EQUAL(empty.str(), "");
+    BOOST_CHECK(Symbol("") == empty);
+
+    Symbol a("symbol_test_a");
+    Symbol b("symbol_test_b");
+    BOOST_CHECK(a != b);
+    BOOST_CHECK(a == Symbol("symbol_test_a"));
+    BOOST_CHECK_EQUAL(a.get_id(), Symbol("symbol_test_a").get_id());
+    BOOST_CHECK(a < b);
+    BOOST_CHECK_EQUAL(a.str(), "symbol_test_a");
+
+    // find does not intern
+    BOOST_CHECK(Symbol::find("symbol_test_a") == a);
+    BOOST_CHECK(!Symbol::find("symbol_test_never_interned"));
+    BOOST_CHECK(!Symbol::find("symbol_test_never_interned"));
+
+    boost::unordered_set<Symbol> symbols;
+    symbols.insert(a);
+    symbols.insert(b);
+    symbols.insert(Symbol("symbol_test_a"));
+    BOOST_CHECK_EQUAL(symbols.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_thread_test)
+{
+    // names are interned and found from several threads at once,
+    // while the table grows
+    std::size_t const num_threads = 4;
+    std::size_t const num_names = 2000;
+    std::vector<std::vector<Symbol> > symbols(num_threads);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread([t, &symbols]() {
+            for (std::size_t i = 0; i < num_names; i++) {
+                std::ostringstream name;
+                name << "symbol_test_thread_" << (i % 2 ? t : 0) << "_" << i;
+                symbols[t].push_back(Symbol(name.str()));
+                Symbol::find(name.str());
+            };
+        }));
+    };
+    for (std::size_t t = 0; t < num_threads; t++) {
+        threads[t].join();
+    };
+    boost::unordered_set<std::size_t> ids;
+    for (std::size_t t = 0; t < num_threads; t++) {
+        for (std::size_t i = 0; i < num_names; i++) {
+            Symbol const & symbol = symbols[t][i];
+            BOOST_REQUIRE(Symbol::find(symbol.str()) == symbol);
+            if (i % 2 == 0) {
+                // shared by all threads
+                BOOST_REQUIRE(symbol == symbols[0][i]);
+            };
+            ids.insert(symbol.get_id());
+        };
+    };
+    BOOST_CHECK_EQUAL(ids.size(), num_names / 2 + num_threads * num_names / 2);
+}
+
+BOOST_AUTO_TEST_CASE(symbol_scope_test)
+{
+    std::istringstream is(
+        "class Int\n"
+        "class Outer\n"
+        "    class Inner\n"
+        "        Int x\n"
+        "    Inner inner\n"
+        "    Int y\n"
+        "class Derived(Outer)\n"
+        "    Int z\n");
+    Scope scope;
+    BOOST_REQUIRE(scope.parse(is));
+    get<Class>(scope[0]).set_type<int>();
+    scope.compile();
+
+    // classes are numbered in order of declaration, nested ones too
+    BOOST_CHECK_EQUAL(scope.get_num_classes(), 4);
+    BOOST_CHECK_EQUAL(scope.get_class(std::size_t(0)).name, "Int");
+    BOOST_CHECK_EQUAL(scope.get_class(std::size_t(1)).name, "Outer");
+    BOOST_CHECK_EQUAL(scope.get_class(std::size_t(2)).name, "Inner");
+    BOOST_CHECK_EQUAL(scope.get_class(std::size_t(3)).name, "Derived");
+    BOOST_CHECK_THROW(scope.get_class(std::size_t(4)), std::runtime_error);
+    Class const & Derived = scope.get_class("Derived");
+    BOOST_CHECK_EQUAL(Derived.get_id(), 3);
+    BOOST_CHECK(Derived.get_symbol() == Symbol("Derived"));
+    BOOST_CHECK_EQUAL(&scope.get_class(Derived.get_symbol()), &Derived);
+
+    // nested scopes resolve the classes of parent scopes
+    Class const & Inner = scope.get_class("Outer").scope.get().get_class("Inner");
+    BOOST_CHECK_EQUAL(Inner.get_id(), 2);
+    BOOST_CHECK_EQUAL(&Inner.scope.get().get_class("Int"), &scope.get_class("Int"));
+    BOOST_CHECK_THROW(scope.get_class("Inner"), std::runtime_error);
+    BOOST_CHECK_THROW(scope.get_class("SymbolTestNeverDeclared"), std::runtime_error);
+
+    // attributes are found by interned name, including inherited ones
+    Attr const & y = Derived.get_attr(Symbol("y"));
+    BOOST_CHECK_EQUAL(y.name, "y");
+    BOOST_CHECK(y.get_symbol() == Symbol("y"));
+    BOOST_CHECK_EQUAL(&Derived.get_attr("y"), &y);
+    BOOST_CHECK_EQUAL(Derived.get_attr(Symbol("z")).get_index(), 2);
+    BOOST_CHECK_THROW(Derived.get_attr(Symbol("x")), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,7 @@
+// check that header compiles
+#include "pyffi/object_models/value.hpp"
+int main()
+{
+    pyffi::object_models::Value value;
+    return 0;
+};
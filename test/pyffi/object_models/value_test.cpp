@@ -0,0 +1,142 @@
+/*
+
+Copyright (c) 2007-2010, Python File Format Interface
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+   * Redistributions of source code must retain the above copyright
+     notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above
+     copyright notice, this list of conditions and the following
+     disclaimer in the documentation and/or other materials provided
+     with the distribution.
+
+   * Neither the name of the Python File Format Interface
+     project nor the names of its contributors may be used to endorse
+     or promote products derived from this software without specific
+     prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include "pyffi/object_models/value.hpp"
+
+using namespace pyffi;
+using namespace pyffi::object_models;
+
+BOOST_AUTO_TEST_SUITE(value_test_suite)
+
+BOOST_AUTO_TEST_CASE(value_cast_test)
+{
+    Value empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK(empty.type() == typeid(void));
+
+    Value x(10, 0);
+    BOOST_CHECK(!x.empty());
+    BOOST_CHECK(x.type() == typeid(int));
+    BOOST_CHECK_EQUAL(value_cast<int>(x), 10);
+    BOOST_CHECK_EQUAL(*value_cast<int>(&x), 10);
+    BOOST_CHECK(!value_cast<float>(&x));
+    BOOST_CHECK_THROW(value_cast<float>(x), bad_value_cast);
+
+    // modify through reference
+    value_cast<int &>(x) = 20;
+    Value const & y = x;
+    BOOST_CHECK_EQUAL(value_cast<int const &>(y), 20);
+
+    // assignment of a different type
+    x = std::string("Hello");
+    BOOST_CHECK_EQUAL(value_cast<std::string>(x), "Hello");
+}
+
+BOOST_AUTO_TEST_CASE(value_arena_test)
+{
+    Arena arena;
+    Value x(std::string("Hello"), &arena);
+    BOOST_CHECK_EQUAL(x.get_arena(), &arena);
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+
+    // copies reside on the heap
+    Value y(x);
+    BOOST_CHECK(!y.get_arena());
+    BOOST_CHECK_EQUAL(value_cast<std::string>(y), "Hello");
+
+    // assignment keeps the arena
+    x = Value(std::string("World"), 0);
+    BOOST_CHECK_EQUAL(x.get_arena(), &arena);
+    BOOST_CHECK_EQUAL(value_cast<std::string>(x), "World");
+
+    // moves keep the arena
+    Value z(std::move(x));
+    BOOST_CHECK(x.empty());
+    BOOST_CHECK_EQUAL(z.get_arena(), &arena);
+    BOOST_CHECK_EQUAL(value_cast<std::string>(z), "World");
+}
+
+BOOST_AUTO_TEST_CASE(value_inline_test)
+{
+    struct Vec {
+        float x, y, z;
+    };
+    struct Big {
+        double a, b, c;
+    };
+
+    // small plain old data is stored inline, even in an arena
+    Arena arena;
+    Value x(10, &arena);
+    Value v(Vec(), &arena);
+    BOOST_CHECK(x.is_inline());
+    BOOST_CHECK(v.is_inline());
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 0);
+    BOOST_CHECK(x.is<int>());
+    BOOST_CHECK(!x.is<unsigned int>());
+    BOOST_CHECK(v.is<Vec>());
+
+    // anything else is allocated
+    Value b(Big(), &arena);
+    Value s(std::string("Hello"), 0);
+    BOOST_CHECK(!b.is_inline());
+    BOOST_CHECK(!s.is_inline());
+    BOOST_CHECK_EQUAL(arena.get_num_blocks(), 1);
+
+    // inline values can be moved between arenas
+    Value y;
+    y = std::move(x);
+    BOOST_CHECK(x.empty());
+    BOOST_CHECK(y.is_inline());
+    BOOST_CHECK_EQUAL(value_cast<int>(y), 10);
+
+    // switching between inline and allocated types
+    y = std::string("World");
+    BOOST_CHECK(!y.is_inline());
+    BOOST_CHECK_EQUAL(value_cast<std::string>(y), "World");
+    y = 1.5f;
+    BOOST_CHECK(y.is_inline());
+    BOOST_CHECK_EQUAL(value_cast<float>(y), 1.5f);
+    y = s;
+    BOOST_CHECK_EQUAL(value_cast<std::string>(y), "Hello");
+}
+
+BOOST_AUTO_TEST_SUITE_END()